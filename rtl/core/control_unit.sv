@@ -14,6 +14,7 @@ module control_unit (
     output logic       mem_write_d_o,
     output logic       jump_d_o,
     output logic       branch_d_o,
+    output logic       csr_d_o,
     output logic       alu_src_d_o,
     output logic [`ALU_CONTROL_WIDTH-1:0] alu_control_d_o,
     output immediate_type_e imm_type_d_o,
@@ -30,6 +31,7 @@ module control_unit (
         mem_write_d_o   = 1'b0;
         jump_d_o        = 1'b0;
         branch_d_o      = 1'b0;
+        csr_d_o         = 1'b0;
         alu_src_d_o     = 1'b0;
         alu_control_d_o = `ALU_OP_ADD;
         imm_type_d_o    = IMM_TYPE_NONE;
@@ -152,6 +154,16 @@ module control_unit (
                     default:       alu_control_d_o = `ALU_OP_ADD;
                 endcase
             end
+            `OPCODE_SYSTEM: begin
+                // ecall/ebreak (funct3 000) decode as NOPs; execute reads and
+                // writes the CSR and returns the old value in alu_result
+                if (funct3 != 3'b000 && funct3 != 3'b100) begin
+                    reg_write_d_o   = 1'b1;
+                    csr_d_o         = 1'b1;
+                    op_a_sel_d_o    = ALU_A_SRC_RS1;
+                    result_src_d_o  = 2'b00;
+                end
+            end
         endcase
     end
 endmodule
\ No newline at end of file
@@ -0,0 +1,109 @@
+`include "common/defines.svh"
+`include "common/csr_defines.svh"
+
+// Zicsr counter file: mcycle, minstret and NUM_HPM_COUNTERS programmable
+// mhpmcounter/mhpmevent pairs (mhpmcounter3 upwards), plus mcountinhibit and
+// the read-only cycle/instret/hpmcounter aliases. The access comes from the
+// instruction in EX, which always commits (no traps, and flushes only squash
+// younger instructions), so reads and writes take effect there. Addresses
+// outside this set read as zero and ignore writes.
+module csr_file #(
+    parameter int unsigned NUM_HPM_COUNTERS = 8
+)(
+    input  logic clk,
+    input  logic rst_n,
+
+    input  logic [`CSR_ADDR_WIDTH-1:0] csr_addr_i,
+    output logic [`DATA_WIDTH-1:0]     csr_rdata_o,
+    input  logic                       csr_write_i,
+    input  logic [`DATA_WIDTH-1:0]     csr_wdata_i,
+
+    // A valid instruction left EX this cycle (it will retire)
+    input  logic                       instr_retired_i,
+    // One bit per `HPM_EVENT_* code
+    input  logic [`HPM_NUM_EVENTS-1:0] hpm_events_i
+);
+
+    // mhpmcounter3..31: mcountinhibit has one bit per counter, up to bit 31
+    if (NUM_HPM_COUNTERS > 29) begin : g_num_hpm_counters_check
+        $error("csr_file: NUM_HPM_COUNTERS is %0d; at most 29 (mhpmcounter3..31) exist", NUM_HPM_COUNTERS);
+    end
+
+    logic [`DATA_WIDTH-1:0] mcycle_q;
+    logic [`DATA_WIDTH-1:0] minstret_q;
+    logic [`DATA_WIDTH-1:0] mhpmcounter_q [NUM_HPM_COUNTERS];
+    logic [`HPM_EVENT_SEL_WIDTH-1:0] mhpmevent_q [NUM_HPM_COUNTERS];
+    logic [31:0]            mcountinhibit_q;
+
+    function automatic logic hpm_event_hit(input logic [`HPM_EVENT_SEL_WIDTH-1:0] sel,
+                                           input logic [`HPM_NUM_EVENTS-1:0] events);
+        if (sel == `HPM_EVENT_SEL_WIDTH'(`HPM_EVENT_NONE) || sel >= `HPM_EVENT_SEL_WIDTH'(`HPM_NUM_EVENTS)) begin
+            return 1'b0;
+        end
+        return events[sel];
+    endfunction
+
+    // Read port
+    always_comb begin
+        csr_rdata_o = `DATA_WIDTH'(0);
+        case (csr_addr_i)
+            `CSR_MCYCLE,   `CSR_CYCLE:   csr_rdata_o = mcycle_q;
+            `CSR_MINSTRET, `CSR_INSTRET: csr_rdata_o = minstret_q;
+            `CSR_MCOUNTINHIBIT:          csr_rdata_o = `DATA_WIDTH'(mcountinhibit_q);
+            default: begin
+                for (int i = 0; i < NUM_HPM_COUNTERS; i++) begin
+                    if (csr_addr_i == `CSR_MHPMCOUNTER3 + `CSR_ADDR_WIDTH'(i) ||
+                        csr_addr_i == `CSR_HPMCOUNTER3  + `CSR_ADDR_WIDTH'(i)) begin
+                        csr_rdata_o = mhpmcounter_q[i];
+                    end
+                    if (csr_addr_i == `CSR_MHPMEVENT3 + `CSR_ADDR_WIDTH'(i)) begin
+                        csr_rdata_o = `DATA_WIDTH'(mhpmevent_q[i]);
+                    end
+                end
+            end
+        endcase
+    end
+
+    // Counters tick every cycle unless inhibited; a CSR write in the same
+    // cycle takes precedence over the increment. User aliases are read-only.
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            mcycle_q        <= `DATA_WIDTH'(0);
+            minstret_q      <= `DATA_WIDTH'(0);
+            mcountinhibit_q <= 32'b0;
+            for (int i = 0; i < NUM_HPM_COUNTERS; i++) begin
+                mhpmcounter_q[i] <= `DATA_WIDTH'(0);
+                mhpmevent_q[i]   <= `HPM_EVENT_SEL_WIDTH'(`HPM_EVENT_NONE);
+            end
+        end else begin
+            if (csr_write_i && csr_addr_i == `CSR_MCYCLE) begin
+                mcycle_q <= csr_wdata_i;
+            end else if (!mcountinhibit_q[0]) begin
+                mcycle_q <= mcycle_q + 1;
+            end
+
+            if (csr_write_i && csr_addr_i == `CSR_MINSTRET) begin
+                minstret_q <= csr_wdata_i;
+            end else if (!mcountinhibit_q[2] && instr_retired_i) begin
+                minstret_q <= minstret_q + 1;
+            end
+
+            if (csr_write_i && csr_addr_i == `CSR_MCOUNTINHIBIT) begin
+                // Bit 1 (time) is not implemented
+                mcountinhibit_q <= csr_wdata_i[31:0] & ~32'h2;
+            end
+
+            for (int i = 0; i < NUM_HPM_COUNTERS; i++) begin
+                if (csr_write_i && csr_addr_i == `CSR_MHPMCOUNTER3 + `CSR_ADDR_WIDTH'(i)) begin
+                    mhpmcounter_q[i] <= csr_wdata_i;
+                end else if (!mcountinhibit_q[i + 3] && hpm_event_hit(mhpmevent_q[i], hpm_events_i)) begin
+                    mhpmcounter_q[i] <= mhpmcounter_q[i] + 1;
+                end
+                if (csr_write_i && csr_addr_i == `CSR_MHPMEVENT3 + `CSR_ADDR_WIDTH'(i)) begin
+                    mhpmevent_q[i] <= csr_wdata_i[`HPM_EVENT_SEL_WIDTH-1:0];
+                end
+            end
+        end
+    end
+
+endmodule
@@ -3,7 +3,11 @@
 `include "common/riscv_opcodes.svh"
 
 module data_memory #(
-    parameter string DATA_MEM_INIT_FILE = ""
+    parameter string DATA_MEM_INIT_FILE = "",
+    // 1: the whole 64-bit address space, backed through DPI by the
+    // testbench's sparse paged memory (tests/common/sparse_dmem.h) instead of
+    // the 1 KiB array. DATA_MEM_INIT_FILE is ignored; programs come from ELF.
+    parameter bit SPARSE = 0
 )(
     input  logic clk,
     input  logic rst_n,
@@ -19,27 +23,117 @@ module data_memory #(
     localparam MEM_ADDR_BITS = 10;
     localparam MEM_SIZE_BYTES = 1 << MEM_ADDR_BITS;
     localparam MEM_ADDR_WIDTH = $clog2(MEM_SIZE_BYTES);
+    localparam ARRAY_BYTES = SPARSE ? 1 : MEM_SIZE_BYTES;
 
-    logic [7:0] mem [MEM_SIZE_BYTES-1:0];
+    logic [7:0] mem [ARRAY_BYTES-1:0] /* verilator public */;
     logic [`DATA_WIDTH-1:0] aligned_word_read_comb;
+    logic                   aligned_word_valid_comb;
     logic [`DATA_WIDTH-1:0] temp_read_data_comb;
 
-    always_comb begin
-        temp_read_data_comb = `DATA_WIDTH'('x);
-        aligned_word_read_comb = `DATA_WIDTH'('0);
+    string init_file;
 
-        if (addr_i < MEM_SIZE_BYTES) begin
-            logic [2:0] byte_offset_in_word = addr_i[2:0];
-            logic [`DATA_WIDTH-1:0] current_aligned_word;
+    generate
+        if (SPARSE) begin : g_sparse
+            import "DPI-C" function longint dmem_sparse_read(input longint addr);
+            import "DPI-C" function void dmem_sparse_write(input longint addr, input longint data, input int bytes);
+            import "DPI-C" function void dmem_sparse_reset();
+
+            // Reads never allocate: untouched pages read as zero
+            always_comb begin
+                aligned_word_read_comb = dmem_sparse_read(addr_i & ~`DATA_WIDTH'((`DATA_WIDTH/8) - 1));
+                aligned_word_valid_comb = 1'b1;
+            end
+
+            always_ff @(posedge clk) begin
+                if (mem_write_en_i) begin
+                    case (funct3_i)
+                        `FUNCT3_SB: dmem_sparse_write(addr_i, write_data_i, 1);
+                        `FUNCT3_SH: dmem_sparse_write(addr_i, write_data_i, 2);
+                        `FUNCT3_SW: dmem_sparse_write(addr_i, write_data_i, 4);
+                        `FUNCT3_SD: dmem_sparse_write(addr_i, write_data_i, 8);
+                        default: ;
+                    endcase
+                end
+            end
 
-            for (int i = 0; i < (`DATA_WIDTH/8); i++) begin
-                if (((addr_i & ~((`DATA_WIDTH/8) - 1)) + `DATA_WIDTH'(i)) < MEM_SIZE_BYTES) begin
-                    current_aligned_word[(i*8) +: 8] = mem[(addr_i & ~((`DATA_WIDTH/8) - 1)) + `DATA_WIDTH'(i)];
-                end else begin
-                    current_aligned_word[(i*8) +: 8] = 8'h00;
+            // Reset drops the pages written since the program was loaded
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    dmem_sparse_reset();
                 end
             end
-            aligned_word_read_comb = current_aligned_word;
+        end else begin : g_array
+            always_comb begin
+                aligned_word_read_comb = `DATA_WIDTH'('0);
+                aligned_word_valid_comb = addr_i < MEM_SIZE_BYTES;
+
+                if (aligned_word_valid_comb) begin
+                    for (int i = 0; i < (`DATA_WIDTH/8); i++) begin
+                        if (((addr_i & ~((`DATA_WIDTH/8) - 1)) + `DATA_WIDTH'(i)) < MEM_SIZE_BYTES) begin
+                            aligned_word_read_comb[(i*8) +: 8] = mem[(addr_i & ~((`DATA_WIDTH/8) - 1)) + `DATA_WIDTH'(i)];
+                        end
+                    end
+                end
+            end
+
+            always_ff @(posedge clk) begin
+                if (mem_write_en_i) begin
+
+                    case (funct3_i)
+                        `FUNCT3_SB: begin
+                            if (addr_i < MEM_SIZE_BYTES) mem[addr_i] = write_data_i[7:0];
+                        end
+                        `FUNCT3_SH: begin
+                            if (addr_i < MEM_SIZE_BYTES - 1) begin
+                                mem[addr_i]   <= write_data_i[7:0];
+                                mem[addr_i+1] <= write_data_i[15:8];
+                            end
+                        end
+                        `FUNCT3_SW: begin
+                            if (addr_i < MEM_SIZE_BYTES - 3) begin
+                                for (int i = 0; i < 4; i++) begin
+                                    mem[addr_i+i] <= write_data_i[i*8 +: 8];
+                                end
+                            end
+                        end
+                        `FUNCT3_SD: begin
+                             if (addr_i < MEM_SIZE_BYTES - 7) begin
+                                for (int i = 0; i < (`DATA_WIDTH/8); i++) begin
+                                    mem[addr_i + `DATA_WIDTH'(i)] <= write_data_i[i*8 +: 8];
+                                end
+                            end
+                        end
+                        default: ;
+                    endcase
+                end
+            end
+
+            // Reset clears the array and (re)loads the init image once, on the
+            // first clock edge after rst_n is released, rather than on every
+            // edge while it is held low.
+            logic init_pending_q;
+
+            always_ff @(posedge clk or negedge rst_n) begin
+                if (!rst_n) begin
+                    init_pending_q <= 1'b1;
+                end else if (init_pending_q) begin
+                    init_pending_q <= 1'b0;
+                    for (int i = 0; i < MEM_SIZE_BYTES; i++) begin
+                        mem[i] = 8'h00;
+                    end
+                    if (init_file != "") begin
+                        $readmemh(init_file, mem);
+                    end
+                end
+            end
+        end
+    endgenerate
+
+    always_comb begin
+        temp_read_data_comb = `DATA_WIDTH'('x);
+
+        if (aligned_word_valid_comb) begin
+            logic [2:0] byte_offset_in_word = addr_i[2:0];
 
             case (funct3_i)
                 `FUNCT3_LB: begin
@@ -65,56 +159,14 @@ module data_memory #(
                 end
                 default: temp_read_data_comb = `DATA_WIDTH'('x);
             endcase
-        end else begin
-             temp_read_data_comb = `DATA_WIDTH'('x);
         end
     end
     assign read_data_o = temp_read_data_comb;
 
-    always_ff @(posedge clk) begin
-        if (mem_write_en_i) begin
-
-            case (funct3_i)
-                `FUNCT3_SB: begin
-                    if (addr_i < MEM_SIZE_BYTES) mem[addr_i] = write_data_i[7:0];
-                end
-                `FUNCT3_SH: begin
-                    if (addr_i < MEM_SIZE_BYTES - 1) begin
-                        mem[addr_i]   <= write_data_i[7:0];
-                        mem[addr_i+1] <= write_data_i[15:8];
-                    end
-                end
-                `FUNCT3_SW: begin
-                    if (addr_i < MEM_SIZE_BYTES - 3) begin
-                        for (int i = 0; i < 4; i++) begin
-                            mem[addr_i+i] <= write_data_i[i*8 +: 8];
-                        end
-                    end
-                end
-                `FUNCT3_SD: begin
-                     if (addr_i < MEM_SIZE_BYTES - 7) begin
-                        for (int i = 0; i < (`DATA_WIDTH/8); i++) begin
-                            mem[addr_i + `DATA_WIDTH'(i)] <= write_data_i[i*8 +: 8];
-                        end
-                    end
-                end
-                default: ;
-            endcase
-        end
-    end
-
-    always_ff @(posedge clk or negedge rst_n) begin
-        if (!rst_n) begin
-            for (int i = 0; i < MEM_SIZE_BYTES; i++) begin
-                mem[i] = 8'h00;
-            end
-        end
-    end
-
     initial begin
-        if (DATA_MEM_INIT_FILE != "") begin
-            $readmemh(DATA_MEM_INIT_FILE, mem);
-        end
+        // +DATA_MEM_INIT_FILE=<path> overrides the elaboration-time parameter
+        init_file = DATA_MEM_INIT_FILE;
+        void'($value$plusargs("DATA_MEM_INIT_FILE=%s", init_file));
     end
 
 endmodule
\ No newline at end of file
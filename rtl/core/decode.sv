@@ -40,6 +40,7 @@ module decode (
         .mem_write_d_o         (id_ex_data_o.mem_write),
         .jump_d_o              (id_ex_data_o.jump),
         .branch_d_o            (id_ex_data_o.branch),
+        .csr_d_o               (id_ex_data_o.csr_en),
         .alu_src_d_o           (id_ex_data_o.alu_src),
         .alu_control_d_o       (id_ex_data_o.alu_control),
         .imm_type_d_o          (imm_type_sel_internal),
@@ -66,6 +67,9 @@ module decode (
         .imm_ext_o         (imm_ext_internal)
     );
 
+    assign id_ex_data_o.valid      = if_id_data_i.valid;
+    assign id_ex_data_o.seq        = if_id_data_i.seq;
+    assign id_ex_data_o.instr      = if_id_data_i.instr;
     assign id_ex_data_o.pc         = if_id_data_i.pc;
     assign id_ex_data_o.pc_plus_4  = if_id_data_i.pc_plus_4;
     assign id_ex_data_o.rs1_data   = rs1_data_from_rf;
@@ -8,6 +8,12 @@ module execute (
     input  logic [1:0]             forward_a_e_i,
     input  logic [1:0]             forward_b_e_i,
 
+    // CSR access of a Zicsr instruction (see rtl/core/csr_file.sv)
+    input  logic [`DATA_WIDTH-1:0] csr_rdata_i,
+    output logic [`CSR_ADDR_WIDTH-1:0] csr_addr_o,
+    output logic                   csr_write_o,
+    output logic [`DATA_WIDTH-1:0] csr_wdata_o,
+
     output ex_mem_data_t           ex_mem_data_o,
     output logic                   pc_src_o,
     output logic [`DATA_WIDTH-1:0] pc_target_addr_o
@@ -87,14 +93,73 @@ module execute (
         end
     end
 
+    // Zicsr: the source is the forwarded rs1 value, or the zero-extended rs1
+    // field for the immediate forms. csrrs/csrrc with a zero source only read.
+    logic [`DATA_WIDTH-1:0] csr_src;
+    logic [`REG_ADDR_WIDTH-1:0] csr_uimm;
+
+    assign csr_uimm   = id_ex_data_i.instr[19:15];
+    assign csr_src    = id_ex_data_i.funct3[2] ? `DATA_WIDTH'(csr_uimm) : alu_operand_a_final;
+    assign csr_addr_o = id_ex_data_i.instr[31:20];
+
+    always_comb begin
+        case (id_ex_data_i.funct3[1:0])
+            2'b01:   csr_wdata_o = csr_src;
+            2'b10:   csr_wdata_o = csr_rdata_i | csr_src;
+            2'b11:   csr_wdata_o = csr_rdata_i & ~csr_src;
+            default: csr_wdata_o = csr_rdata_i;
+        endcase
+    end
+
+    assign csr_write_o = id_ex_data_i.valid && id_ex_data_i.csr_en &&
+                         (id_ex_data_i.funct3[1:0] == 2'b01 || csr_uimm != `REG_ADDR_WIDTH'(0));
+
     assign pc_src_o = (id_ex_data_i.jump) || (id_ex_data_i.branch && take_branch);
+
+    // Retirement trace: register operands as read after forwarding. The ALU
+    // operands cannot be reused, since they may hold the PC or an immediate.
+    logic [6:0] opcode_e;
+    logic       reads_rs1;
+    logic       reads_rs2;
+    logic [`DATA_WIDTH-1:0] rs1_value_e;
+    logic [`DATA_WIDTH-1:0] rs2_value_e;
+
+    assign opcode_e  = id_ex_data_i.instr[6:0];
+    assign reads_rs1 = opcode_e == `OPCODE_JALR || opcode_e == `OPCODE_BRANCH || opcode_e == `OPCODE_LOAD ||
+                       opcode_e == `OPCODE_STORE || opcode_e == `OPCODE_OP_IMM || opcode_e == `OPCODE_OP ||
+                       (id_ex_data_i.csr_en && !id_ex_data_i.funct3[2]);
+    assign reads_rs2 = opcode_e == `OPCODE_BRANCH || opcode_e == `OPCODE_STORE || opcode_e == `OPCODE_OP;
+
+    always_comb begin
+        case (forward_a_e_i)
+            2'b10:   rs1_value_e = forward_data_mem_i;
+            2'b01:   rs1_value_e = forward_data_wb_i;
+            default: rs1_value_e = id_ex_data_i.rs1_data;
+        endcase
+        case (forward_b_e_i)
+            2'b10:   rs2_value_e = forward_data_mem_i;
+            2'b01:   rs2_value_e = forward_data_wb_i;
+            default: rs2_value_e = id_ex_data_i.rs2_data;
+        endcase
+    end
+
+    assign ex_mem_data_o.valid      = id_ex_data_i.valid;
+    assign ex_mem_data_o.seq        = id_ex_data_i.seq;
+    assign ex_mem_data_o.instr      = id_ex_data_i.instr;
+    assign ex_mem_data_o.pc         = id_ex_data_i.pc;
     assign ex_mem_data_o.reg_write  = id_ex_data_i.reg_write;
     assign ex_mem_data_o.result_src = id_ex_data_i.result_src;
     assign ex_mem_data_o.mem_write  = id_ex_data_i.mem_write;
     assign ex_mem_data_o.funct3     = id_ex_data_i.funct3;
-    assign ex_mem_data_o.alu_result = alu_result_internal;
+    assign ex_mem_data_o.alu_result = id_ex_data_i.csr_en ? csr_rdata_i : alu_result_internal;
     assign ex_mem_data_o.rs2_data   = write_data_e;
     assign ex_mem_data_o.rd_addr    = id_ex_data_i.rd_addr;
     assign ex_mem_data_o.pc_plus_4  = id_ex_data_i.pc_plus_4;
 
+    assign ex_mem_data_o.rvfi_pc_wdata  = pc_src_o ? pc_target_addr_o : id_ex_data_i.pc_plus_4;
+    assign ex_mem_data_o.rvfi_rs1_addr  = reads_rs1 ? id_ex_data_i.rs1_addr : `REG_ADDR_WIDTH'(0);
+    assign ex_mem_data_o.rvfi_rs2_addr  = reads_rs2 ? id_ex_data_i.rs2_addr : `REG_ADDR_WIDTH'(0);
+    assign ex_mem_data_o.rvfi_rs1_rdata = reads_rs1 ? rs1_value_e : `DATA_WIDTH'(0);
+    assign ex_mem_data_o.rvfi_rs2_rdata = reads_rs2 ? rs2_value_e : `DATA_WIDTH'(0);
+
 endmodule
\ No newline at end of file
@@ -2,10 +2,12 @@
 
 module fetch #(
     parameter string INSTR_MEM_INIT_FILE_PARAM = "",
-    parameter logic [`DATA_WIDTH-1:0] PC_INIT_VALUE_PARAM = `PC_RESET_VALUE
+    parameter int unsigned INSTR_MEM_WORDS = 2**20,
+    parameter bit INSTR_MEM_SHARED_IMAGE = 0
 )(
     input  logic clk,
     input  logic rst_n,
+    input  logic [`DATA_WIDTH-1:0]     pc_init_value_i,
     input  logic                       stall_f_i,
     input  logic                       pc_src_e_i,
     input  logic [`DATA_WIDTH-1:0]     pc_target_e_i,
@@ -17,9 +19,12 @@ module fetch #(
     logic [`DATA_WIDTH-1:0] pc_next;
     logic [`DATA_WIDTH-1:0] pc_plus_4_temp;
     logic [`INSTR_WIDTH-1:0] instr_mem_data;
+    logic [`SEQ_NUM_WIDTH-1:0] seq_reg;
 
     instruction_memory #(
-        .INSTR_MEM_INIT_FILE_PARAM(INSTR_MEM_INIT_FILE_PARAM)
+        .INSTR_MEM_INIT_FILE_PARAM(INSTR_MEM_INIT_FILE_PARAM),
+        .ROM_SIZE                 (INSTR_MEM_WORDS),
+        .SHARED_IMAGE             (INSTR_MEM_SHARED_IMAGE)
     ) i_instr_mem (
         .address     (pc_reg),
         .instruction (instr_mem_data)
@@ -30,12 +35,16 @@ module fetch #(
 
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
-            pc_reg <= PC_INIT_VALUE_PARAM;
+            pc_reg  <= pc_init_value_i;
+            seq_reg <= `SEQ_NUM_WIDTH'(0);
         end else if (!stall_f_i) begin
-            pc_reg <= pc_next;
+            pc_reg  <= pc_next;
+            seq_reg <= seq_reg + 1;
         end
     end
 
+    assign if_id_data_o.valid      = 1'b1;
+    assign if_id_data_o.seq        = seq_reg;
     assign if_id_data_o.instr      = instr_mem_data;
     assign if_id_data_o.pc         = pc_reg;
     assign if_id_data_o.pc_plus_4  = pc_plus_4_temp;
@@ -6,30 +6,56 @@ module instruction_memory (
 );
 
     parameter string INSTR_MEM_INIT_FILE_PARAM = "";
-    localparam ROM_SIZE = 2**20;
+    // ROM depth in 32-bit words (power of two); fetch wraps at ROM_SIZE * 4 bytes
+    parameter int unsigned ROM_SIZE = 2**20;
+    // 1: fetch through DPI from the process-wide program image of the
+    // testbench (tests/common/shared_imem.h) instead of a per-instance ROM.
+    // The array then shrinks to one word and +INSTR_MEM_INIT_FILE is ignored.
+    parameter bit SHARED_IMAGE = 0;
+
+    localparam ROM_WORDS = SHARED_IMAGE ? 1 : ROM_SIZE;
     localparam ROM_ADDR_WIDTH = $clog2(ROM_SIZE);
 
-    logic [`INSTR_WIDTH-1:0] mem[ROM_SIZE-1:0];
+    // The array is not filled with ROM_SIZE NOPs at time 0. A word never
+    // written is X in four-state simulators and reads as NOP; Verilator starts
+    // it at 0x00000000, an unknown opcode that the core (like the reference
+    // model) executes as a no-op. Loaded words, zero ones included, are fetched
+    // as they are; the testbench backdoor NOP-fills a ROM it reuses.
+    logic [`INSTR_WIDTH-1:0] mem[ROM_WORDS-1:0] /* verilator public */;
     logic [ROM_ADDR_WIDTH-1:0] mem_idx;
+    logic [`INSTR_WIDTH-1:0] rom_word;
+
+    string init_file;
 
     initial begin
-        for (int i = 0; i < ROM_SIZE; i++) begin
-            mem[i] = `NOP_INSTRUCTION;
-        end
+        if (!SHARED_IMAGE) begin
+            // +INSTR_MEM_INIT_FILE=<path> overrides the elaboration-time parameter
+            init_file = INSTR_MEM_INIT_FILE_PARAM;
+            void'($value$plusargs("INSTR_MEM_INIT_FILE=%s", init_file));
 
-        if (INSTR_MEM_INIT_FILE_PARAM != "") begin
-            $readmemh(INSTR_MEM_INIT_FILE_PARAM, mem);
-        end else begin
-            mem[0] = 32'h00100093; // addi x1, x0, 1
-            mem[1] = 32'h00200113; // addi x2, x0, 2
-            mem[2] = 32'h00308193; // addi x3, x1, 3
-            mem[3] = 32'h00110213; // addi x4, x2, 1
+            if (init_file != "") begin
+                $readmemh(init_file, mem);
+            end else begin
+                mem[0] = 32'h00100093; // addi x1, x0, 1
+                mem[1] = 32'h00200113; // addi x2, x0, 2
+                mem[2] = 32'h00308193; // addi x3, x1, 3
+                mem[3] = 32'h00110213; // addi x4, x2, 1
+            end
         end
     end
 
-    assign mem_idx = address[ROM_ADDR_WIDTH+2-1:2];
-    assign instruction = (mem_idx < ROM_SIZE) ?
-                         mem[mem_idx] :
-                         `NOP_INSTRUCTION;
+    generate
+        if (SHARED_IMAGE) begin : g_shared_image
+            import "DPI-C" pure function int imem_shared_fetch(input longint addr);
+
+            assign mem_idx = '0;
+            assign rom_word = '0;
+            assign instruction = imem_shared_fetch(address);
+        end else begin : g_rom
+            assign mem_idx = address[ROM_ADDR_WIDTH+2-1:2];
+            assign rom_word = (mem_idx < ROM_SIZE) ? mem[mem_idx] : '0;
+            assign instruction = $isunknown(rom_word) ? `NOP_INSTRUCTION : rom_word;
+        end
+    endgenerate
 
-endmodule
\ No newline at end of file
+endmodule
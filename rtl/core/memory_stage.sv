@@ -1,7 +1,8 @@
 `include "common/pipeline_types.svh"
 
 module memory_stage #(
-    parameter string DATA_MEM_INIT_FILE_PARAM = ""
+    parameter string DATA_MEM_INIT_FILE_PARAM = "",
+    parameter bit DATA_MEM_SPARSE = 0
 )(
     input  logic clk,
     input  logic rst_n,
@@ -12,7 +13,8 @@ module memory_stage #(
     logic [`DATA_WIDTH-1:0] mem_read_data_internal;
 
     data_memory #(
-        .DATA_MEM_INIT_FILE(DATA_MEM_INIT_FILE_PARAM)
+        .DATA_MEM_INIT_FILE(DATA_MEM_INIT_FILE_PARAM),
+        .SPARSE            (DATA_MEM_SPARSE)
     ) u_data_memory (
         .clk            (clk),
         .rst_n          (rst_n),
@@ -23,6 +25,16 @@ module memory_stage #(
         .read_data_o    (mem_read_data_internal)
     );
 
+    // Bytes of the access, counted from the access address (rvfi_mem_addr is
+    // the unaligned address, so the mask always starts at bit 0).
+    logic [`DATA_BYTES-1:0] access_mask;
+    assign access_mask = `DATA_BYTES'((1 << (1 << ex_mem_data_i.funct3[1:0])) - 1);
+
+    assign mem_wb_data_o.valid          = ex_mem_data_i.valid;
+    assign mem_wb_data_o.seq            = ex_mem_data_i.seq;
+    assign mem_wb_data_o.instr          = ex_mem_data_i.instr;
+    assign mem_wb_data_o.pc             = ex_mem_data_i.pc;
+    assign mem_wb_data_o.store_data     = ex_mem_data_i.rs2_data;
     assign mem_wb_data_o.reg_write      = ex_mem_data_i.reg_write;
     assign mem_wb_data_o.result_src     = ex_mem_data_i.result_src;
     assign mem_wb_data_o.read_data_mem  = mem_read_data_internal;
@@ -30,4 +42,12 @@ module memory_stage #(
     assign mem_wb_data_o.pc_plus_4      = ex_mem_data_i.pc_plus_4;
     assign mem_wb_data_o.rd_addr        = ex_mem_data_i.rd_addr;
 
+    assign mem_wb_data_o.rvfi_pc_wdata  = ex_mem_data_i.rvfi_pc_wdata;
+    assign mem_wb_data_o.rvfi_rs1_addr  = ex_mem_data_i.rvfi_rs1_addr;
+    assign mem_wb_data_o.rvfi_rs2_addr  = ex_mem_data_i.rvfi_rs2_addr;
+    assign mem_wb_data_o.rvfi_rs1_rdata = ex_mem_data_i.rvfi_rs1_rdata;
+    assign mem_wb_data_o.rvfi_rs2_rdata = ex_mem_data_i.rvfi_rs2_rdata;
+    assign mem_wb_data_o.rvfi_mem_rmask = ex_mem_data_i.result_src == 2'b01 ? access_mask : `DATA_BYTES'(0);
+    assign mem_wb_data_o.rvfi_mem_wmask = ex_mem_data_i.mem_write ? access_mask : `DATA_BYTES'(0);
+
 endmodule
\ No newline at end of file
@@ -5,8 +5,16 @@
 
 module pipeline #(
     parameter string INSTR_MEM_INIT_FILE = "",
+    // Instruction ROM depth in words, and DPI fetch from the testbench's
+    // shared program image instead (see rtl/core/instruction_memory.sv)
+    parameter int unsigned INSTR_MEM_WORDS = 2**20,
+    parameter bit INSTR_MEM_SHARED_IMAGE = 0,
     parameter logic [`DATA_WIDTH-1:0] PC_START_ADDR = `PC_RESET_VALUE,
-    parameter string DATA_MEM_INIT_FILE = ""
+    parameter string DATA_MEM_INIT_FILE = "",
+    // Full 64-bit data address space through DPI (see rtl/core/data_memory.sv)
+    parameter bit DATA_MEM_SPARSE = 0,
+    // mhpmcounter3.. / mhpmevent3.. pairs (see rtl/core/csr_file.sv), at most 29
+    parameter int unsigned NUM_HPM_COUNTERS = 8
 )(
     input  logic clk,
     input  logic rst_n,
@@ -15,7 +23,49 @@ module pipeline #(
     output logic [`INSTR_WIDTH-1:0] debug_instr_f,
     output logic                   debug_reg_write_wb,
     output logic [`REG_ADDR_WIDTH-1:0] debug_rd_addr_wb,
-    output logic [`DATA_WIDTH-1:0] debug_result_w
+    output logic [`DATA_WIDTH-1:0] debug_result_w,
+
+    // Hazard unit decisions for the instruction in EX this cycle
+    output logic                   debug_valid_ex,
+    output logic [`INSTR_WIDTH-1:0] debug_instr_ex,
+    output logic [1:0]             debug_forward_a_ex,
+    output logic [1:0]             debug_forward_b_ex,
+    output logic                   debug_stall_f,
+    output logic                   debug_flush_d,
+    output logic                   debug_flush_e,
+
+    // Fetch-order tag of the instruction in each stage this cycle, for
+    // timeline tracing (valid for IF is always 1; EX uses debug_valid_ex,
+    // WB rvfi_valid)
+    output logic [`SEQ_NUM_WIDTH-1:0] debug_seq_f,
+    output logic                   debug_valid_d,
+    output logic [`SEQ_NUM_WIDTH-1:0] debug_seq_d,
+    output logic [`SEQ_NUM_WIDTH-1:0] debug_seq_ex,
+    output logic                   debug_valid_mem,
+    output logic [`SEQ_NUM_WIDTH-1:0] debug_seq_mem,
+    output logic [`SEQ_NUM_WIDTH-1:0] debug_seq_wb,
+
+    // RVFI-style retirement port: one record per instruction leaving WB, in
+    // program order. rs1/rs2 are the operands as read after forwarding, and
+    // unused operands, rd = x0 and untouched memory fields are 0.
+    // rvfi_mem_addr is the access address itself, so the byte masks and the
+    // data start at bit 0.
+    output logic                   rvfi_valid,
+    output logic [63:0]            rvfi_order,
+    output logic [`INSTR_WIDTH-1:0] rvfi_insn,
+    output logic [`DATA_WIDTH-1:0] rvfi_pc_rdata,
+    output logic [`DATA_WIDTH-1:0] rvfi_pc_wdata,
+    output logic [`REG_ADDR_WIDTH-1:0] rvfi_rs1_addr,
+    output logic [`REG_ADDR_WIDTH-1:0] rvfi_rs2_addr,
+    output logic [`DATA_WIDTH-1:0] rvfi_rs1_rdata,
+    output logic [`DATA_WIDTH-1:0] rvfi_rs2_rdata,
+    output logic [`REG_ADDR_WIDTH-1:0] rvfi_rd_addr,
+    output logic [`DATA_WIDTH-1:0] rvfi_rd_wdata,
+    output logic [`DATA_WIDTH-1:0] rvfi_mem_addr,
+    output logic [`DATA_BYTES-1:0] rvfi_mem_rmask,
+    output logic [`DATA_BYTES-1:0] rvfi_mem_wmask,
+    output logic [`DATA_WIDTH-1:0] rvfi_mem_rdata,
+    output logic [`DATA_WIDTH-1:0] rvfi_mem_wdata
 );
 
     if_id_data_t    if_id_data_q, if_id_data_d;
@@ -43,12 +93,31 @@ module pipeline #(
     logic [`REG_ADDR_WIDTH-1:0] rs1_addr_id_signal;
     logic [`REG_ADDR_WIDTH-1:0] rs2_addr_id_signal;
 
+    // For csr_file
+    logic [`CSR_ADDR_WIDTH-1:0] csr_addr_ex_signal;
+    logic [`DATA_WIDTH-1:0]     csr_rdata_ex_signal;
+    logic                       csr_write_ex_signal;
+    logic [`DATA_WIDTH-1:0]     csr_wdata_ex_signal;
+    logic [`HPM_NUM_EVENTS-1:0] hpm_events_signal;
+
+    // Start address can be overridden at runtime with +PC_START_ADDR=<hex>
+    // (or by the testbench ELF loader), so one verilated model serves every
+    // test program.
+    logic [`DATA_WIDTH-1:0] pc_start_addr /* verilator public */;
+
+    initial begin
+        pc_start_addr = PC_START_ADDR;
+        void'($value$plusargs("PC_START_ADDR=%h", pc_start_addr));
+    end
+
     fetch #(
         .INSTR_MEM_INIT_FILE_PARAM(INSTR_MEM_INIT_FILE),
-        .PC_INIT_VALUE_PARAM(PC_START_ADDR)
+        .INSTR_MEM_WORDS          (INSTR_MEM_WORDS),
+        .INSTR_MEM_SHARED_IMAGE   (INSTR_MEM_SHARED_IMAGE)
     ) u_fetch (
         .clk                (clk),
         .rst_n              (rst_n),
+        .pc_init_value_i    (pc_start_addr),
         .stall_f_i          (stall_fetch_signal),
         .pc_src_e_i         (pc_src_ex_o),
         .pc_target_e_i      (pc_target_ex_o),
@@ -71,13 +140,18 @@ module pipeline #(
         .forward_data_wb_i  (rf_write_data_from_wb.result_to_rf),
         .forward_a_e_i      (forward_a_ex_signal),
         .forward_b_e_i      (forward_b_ex_signal),
+        .csr_rdata_i        (csr_rdata_ex_signal),
+        .csr_addr_o         (csr_addr_ex_signal),
+        .csr_write_o        (csr_write_ex_signal),
+        .csr_wdata_o        (csr_wdata_ex_signal),
         .ex_mem_data_o      (ex_mem_data_from_execute),
         .pc_src_o           (pc_src_ex_o),
         .pc_target_addr_o   (pc_target_ex_o)
     );
 
     memory_stage #(
-        .DATA_MEM_INIT_FILE_PARAM(DATA_MEM_INIT_FILE)
+        .DATA_MEM_INIT_FILE_PARAM(DATA_MEM_INIT_FILE),
+        .DATA_MEM_SPARSE         (DATA_MEM_SPARSE)
     ) u_memory_stage (
         .clk                (clk),
         .rst_n              (rst_n),
@@ -115,6 +189,38 @@ module pipeline #(
         .flush_execute_o  (flush_execute_signal)
     );
 
+    // Performance counter events, one cycle each. Forwarding, branch and
+    // memory events only count real instructions in EX.
+    always_comb begin
+        hpm_events_signal = '0;
+        hpm_events_signal[`HPM_EVENT_LOAD_USE_STALL]   = stall_fetch_signal;
+        hpm_events_signal[`HPM_EVENT_FLUSH_DECODE]     = flush_decode_signal;
+        hpm_events_signal[`HPM_EVENT_FLUSH_EXECUTE]    = flush_execute_signal;
+        hpm_events_signal[`HPM_EVENT_FORWARD_A_MEM]    = id_ex_data_q.valid && forward_a_ex_signal == 2'b10;
+        hpm_events_signal[`HPM_EVENT_FORWARD_A_WB]     = id_ex_data_q.valid && forward_a_ex_signal == 2'b01;
+        hpm_events_signal[`HPM_EVENT_FORWARD_B_MEM]    = id_ex_data_q.valid && forward_b_ex_signal == 2'b10;
+        hpm_events_signal[`HPM_EVENT_FORWARD_B_WB]     = id_ex_data_q.valid && forward_b_ex_signal == 2'b01;
+        hpm_events_signal[`HPM_EVENT_BRANCH_TAKEN]     = id_ex_data_q.valid && id_ex_data_q.branch && pc_src_ex_o;
+        hpm_events_signal[`HPM_EVENT_BRANCH_NOT_TAKEN] = id_ex_data_q.valid && id_ex_data_q.branch && !pc_src_ex_o;
+        hpm_events_signal[`HPM_EVENT_LOAD]             = id_ex_data_q.valid && id_ex_data_q.result_src == 2'b01;
+        hpm_events_signal[`HPM_EVENT_STORE]            = id_ex_data_q.valid && id_ex_data_q.mem_write;
+    end
+
+    // Every valid instruction in EX commits, so minstret counts there; a
+    // counter read then sees exactly the instructions older than itself.
+    csr_file #(
+        .NUM_HPM_COUNTERS   (NUM_HPM_COUNTERS)
+    ) u_csr_file (
+        .clk                (clk),
+        .rst_n              (rst_n),
+        .csr_addr_i         (csr_addr_ex_signal),
+        .csr_rdata_o        (csr_rdata_ex_signal),
+        .csr_write_i        (csr_write_ex_signal),
+        .csr_wdata_i        (csr_wdata_ex_signal),
+        .instr_retired_i    (id_ex_data_q.valid),
+        .hpm_events_i       (hpm_events_signal)
+    );
+
     // IF/ID Register Logic
     always_comb begin
         if (flush_decode_signal) begin
@@ -128,8 +234,8 @@ module pipeline #(
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             if_id_data_q <= NOP_IF_ID_DATA;
-            if_id_data_q.pc <= PC_START_ADDR;
-            if_id_data_q.pc_plus_4 <= PC_START_ADDR + 4;
+            if_id_data_q.pc <= pc_start_addr;
+            if_id_data_q.pc_plus_4 <= pc_start_addr + 4;
         end else begin
             if_id_data_q <= if_id_data_d;
         end
@@ -146,8 +252,8 @@ module pipeline #(
     always_ff @(posedge clk or negedge rst_n) begin
         if (!rst_n) begin
             id_ex_data_q <= NOP_ID_EX_DATA;
-            id_ex_data_q.pc <= PC_START_ADDR;
-            id_ex_data_q.pc_plus_4 <= PC_START_ADDR + 4;
+            id_ex_data_q.pc <= pc_start_addr;
+            id_ex_data_q.pc_plus_4 <= pc_start_addr + 4;
         end else begin
             id_ex_data_q <= id_ex_data_d;
         end
@@ -179,4 +285,61 @@ module pipeline #(
     assign debug_rd_addr_wb   = rf_write_data_from_wb.rd_addr;
     assign debug_result_w     = rf_write_data_from_wb.result_to_rf;
 
+    assign debug_valid_ex     = id_ex_data_q.valid;
+    assign debug_instr_ex     = id_ex_data_q.instr;
+    assign debug_forward_a_ex = forward_a_ex_signal;
+    assign debug_forward_b_ex = forward_b_ex_signal;
+    assign debug_stall_f      = stall_fetch_signal;
+    assign debug_flush_d      = flush_decode_signal;
+    assign debug_flush_e      = flush_execute_signal;
+
+    assign debug_seq_f        = if_id_data_from_fetch.seq;
+    assign debug_valid_d      = if_id_data_q.valid;
+    assign debug_seq_d        = if_id_data_q.seq;
+    assign debug_seq_ex       = id_ex_data_q.seq;
+    assign debug_valid_mem    = ex_mem_data_q.valid;
+    assign debug_seq_mem      = ex_mem_data_q.seq;
+    assign debug_seq_wb       = mem_wb_data_q.seq;
+
+    // Retirement port. The order counter counts what has left WB so far.
+    logic [63:0] rvfi_order_q;
+    always_ff @(posedge clk or negedge rst_n) begin
+        if (!rst_n) begin
+            rvfi_order_q <= 64'd0;
+        end else if (mem_wb_data_q.valid) begin
+            rvfi_order_q <= rvfi_order_q + 64'd1;
+        end
+    end
+
+    function automatic logic [`DATA_WIDTH-1:0] bytes_of(input logic [`DATA_WIDTH-1:0] data,
+                                                       input logic [`DATA_BYTES-1:0] mask);
+        for (int i = 0; i < `DATA_BYTES; i++) begin
+            if (!mask[i]) begin
+                data[i*8 +: 8] = 8'h00;
+            end
+        end
+        return data;
+    endfunction
+
+    logic rvfi_rd_written;
+    assign rvfi_rd_written = rf_write_data_from_wb.reg_write_en && rf_write_data_from_wb.rd_addr != `REG_ADDR_WIDTH'(0);
+
+    assign rvfi_valid     = mem_wb_data_q.valid;
+    assign rvfi_order     = rvfi_order_q;
+    assign rvfi_insn      = mem_wb_data_q.instr;
+    assign rvfi_pc_rdata  = mem_wb_data_q.pc;
+    assign rvfi_pc_wdata  = mem_wb_data_q.rvfi_pc_wdata;
+    assign rvfi_rs1_addr  = mem_wb_data_q.rvfi_rs1_addr;
+    assign rvfi_rs2_addr  = mem_wb_data_q.rvfi_rs2_addr;
+    assign rvfi_rs1_rdata = mem_wb_data_q.rvfi_rs1_rdata;
+    assign rvfi_rs2_rdata = mem_wb_data_q.rvfi_rs2_rdata;
+    assign rvfi_rd_addr   = rvfi_rd_written ? rf_write_data_from_wb.rd_addr : `REG_ADDR_WIDTH'(0);
+    assign rvfi_rd_wdata  = rvfi_rd_written ? rf_write_data_from_wb.result_to_rf : `DATA_WIDTH'(0);
+    assign rvfi_mem_rmask = mem_wb_data_q.rvfi_mem_rmask;
+    assign rvfi_mem_wmask = mem_wb_data_q.rvfi_mem_wmask;
+    assign rvfi_mem_addr  = (rvfi_mem_rmask != '0 || rvfi_mem_wmask != '0) ? mem_wb_data_q.alu_result
+                                                                             : `DATA_WIDTH'(0);
+    assign rvfi_mem_rdata = bytes_of(mem_wb_data_q.read_data_mem, rvfi_mem_rmask);
+    assign rvfi_mem_wdata = bytes_of(mem_wb_data_q.store_data, rvfi_mem_wmask);
+
 endmodule
\ No newline at end of file
@@ -0,0 +1,90 @@
+// tests/common/async_trace_sink.h
+#ifndef ASYNC_TRACE_SINK_H
+#define ASYNC_TRACE_SINK_H
+
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+// Moves trace output off the simulation thread. The testbench pushes raw,
+// fixed-size records into an in-process SpscRing; a background thread pops
+// them and hands each one to the consumer, which does the formatting and
+// file I/O. The simulation thread only ever copies a record into the ring.
+// If the ring fills up it waits for the writer thread to catch up (counted in
+// producer_stalls()), so no output is lost.
+//
+// The consumer runs on the writer thread only; anything it touches must not
+// be used by the simulation thread until close() returns.
+template <typename Record, size_t Capacity = (1 << 16)>
+class AsyncTraceSink {
+public:
+    using Consumer = std::function<void(const Record&)>;
+
+    AsyncTraceSink() = default;
+    AsyncTraceSink(const AsyncTraceSink&) = delete;
+    AsyncTraceSink& operator=(const AsyncTraceSink&) = delete;
+    ~AsyncTraceSink() { close(); }
+
+    void open(Consumer consumer) {
+        close();
+        consumer_ = std::move(consumer);
+        ring_.reset(new SpscRing<Record, Capacity>);
+        ring_->init();
+        done_.store(false, std::memory_order_relaxed);
+        writer_ = std::thread([this] { drain(); });
+    }
+
+    bool is_open() const { return writer_.joinable(); }
+
+    void push(const Record& record) {
+        while (!ring_->try_push(record)) {
+            ++producer_stalls_;
+            std::this_thread::yield();
+        }
+    }
+
+    // Waits until every pushed record has been consumed, then stops the thread.
+    void close() {
+        if (!writer_.joinable()) {
+            return;
+        }
+        done_.store(true, std::memory_order_release);
+        writer_.join();
+        consumer_ = nullptr;
+    }
+
+    uint64_t producer_stalls() const { return producer_stalls_; }
+
+private:
+    void drain() {
+        Record record;
+        for (;;) {
+            if (ring_->try_pop(record)) {
+                consumer_(record);
+                continue;
+            }
+            // Check done only after seeing an empty ring, then drain once more:
+            // pushes that happened before close() are visible after the acquire.
+            if (done_.load(std::memory_order_acquire)) {
+                while (ring_->try_pop(record)) {
+                    consumer_(record);
+                }
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::unique_ptr<SpscRing<Record, Capacity>> ring_;
+    Consumer          consumer_;
+    std::thread       writer_;
+    std::atomic<bool> done_{false};
+    uint64_t          producer_stalls_ = 0;
+};
+
+#endif // ASYNC_TRACE_SINK_H
@@ -0,0 +1,100 @@
+// tests/common/cosim_channel.h
+#ifndef COSIM_CHANNEL_H
+#define COSIM_CHANNEL_H
+
+#include "spsc_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+// POSIX shared-memory channel between the ISS co-simulation plugin (producer)
+// and pipeline_cosim_tb (consumer). The testbench creates the segment and
+// passes its name to the ISS process in COSIM_SHM_NAME. Register writes then
+// stream through the ring while both simulators run.
+
+struct CosimRegWrite {
+    uint64_t value;
+    uint32_t rd;
+    uint32_t reserved;
+};
+
+struct CosimChannel {
+    static constexpr uint32_t kMagic = 0x43534d31; // "CSM1"
+    static constexpr size_t kRingCapacity = 1 << 16;
+
+    uint32_t magic;
+    std::atomic<uint32_t> producer_done;  // ISS finished; no more writes will come
+    std::atomic<uint32_t> consumer_done;  // RTL finished; producer may drop writes
+    SpscRing<CosimRegWrite, kRingCapacity> ring;
+};
+
+// Consumer side: creates (or replaces) the named segment and initializes it.
+inline CosimChannel* cosim_channel_create(const std::string& name) {
+    shm_unlink(name.c_str()); // Stale segment from an aborted run
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        std::cerr << "ERROR: shm_open(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (ftruncate(fd, sizeof(CosimChannel)) != 0) {
+        std::cerr << "ERROR: ftruncate(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, sizeof(CosimChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "ERROR: mmap(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    CosimChannel* channel = new (addr) CosimChannel;
+    channel->producer_done.store(0, std::memory_order_relaxed);
+    channel->consumer_done.store(0, std::memory_order_relaxed);
+    channel->ring.init();
+    std::atomic_thread_fence(std::memory_order_release);
+    channel->magic = CosimChannel::kMagic;
+    return channel;
+}
+
+// Producer side: maps a segment created by cosim_channel_create().
+inline CosimChannel* cosim_channel_open(const std::string& name) {
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        std::cerr << "ERROR: shm_open(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, sizeof(CosimChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "ERROR: mmap(" << name << ") failed: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    CosimChannel* channel = static_cast<CosimChannel*>(addr);
+    if (channel->magic != CosimChannel::kMagic) {
+        std::cerr << "ERROR: " << name << " is not an initialized co-simulation channel." << std::endl;
+        munmap(addr, sizeof(CosimChannel));
+        return nullptr;
+    }
+    return channel;
+}
+
+inline void cosim_channel_unmap(CosimChannel* channel) {
+    if (channel) {
+        munmap(channel, sizeof(CosimChannel));
+    }
+}
+
+#endif // COSIM_CHANNEL_H
@@ -0,0 +1,218 @@
+// tests/common/cpi_stack.h
+#ifndef CPI_STACK_H
+#define CPI_STACK_H
+
+#include "rv64i_isa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Top-down cycle accounting: every cycle is charged to exactly one bucket,
+// by what the WB slot holds in that cycle.
+//   base          a valid instruction retires (charged to its PC)
+//   load_use      the bubble a load-use stall put into EX (charged to the
+//                 stalled consumer)
+//   branch_flush  one of the two bubbles of a taken branch (charged to the
+//   jump_flush    branch), or of a jal/jalr
+//   fetch_wait    a bubble the pipeline started with: reset/refill after a
+//                 handoff. Fetch and data memory answer in one cycle, so this
+//                 bucket does not grow while a program runs.
+// Bubbles are tagged with their cause when the hazard unit creates them
+// (stall_f/flush_e for load-use, flush_d = execute.pc_src_o for taken control
+// flow) and the tag moves down a shadow pipeline until the bubble reaches
+// WB, so the buckets always add up to the cycle count. Stage PCs come from
+// the seq tags: a small ring remembers the PC each seq had in IF.
+
+namespace cpi_stack {
+
+enum Bucket : unsigned { BASE, LOAD_USE, BRANCH_FLUSH, JUMP_FLUSH, FETCH_WAIT, NUM_BUCKETS };
+
+const char* const BUCKET_NAMES[NUM_BUCKETS] = {"base", "load_use", "branch_flush", "jump_flush", "fetch_wait"};
+
+constexpr uint64_t NO_PC = ~0ULL;
+
+struct PcStats {
+    uint64_t retired = 0;
+    uint64_t cycles[NUM_BUCKETS] = {};
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+            sum += cycles[b];
+        }
+        return sum;
+    }
+};
+
+class Accountant {
+public:
+    // Call once per cycle, after the clock edge.
+    template <typename Model>
+    void sample(const Model* top) {
+        pc_ring_[top->debug_seq_f & RING_MASK] = top->debug_pc_f;
+
+        if (top->rvfi_valid) {
+            charge({BASE, top->rvfi_pc_rdata});
+            ++per_pc_[top->rvfi_pc_rdata].retired;
+            ++retired_;
+        } else {
+            charge(bubble_[WB]);
+        }
+
+        const uint8_t op_ex = rv64i::opcode(top->debug_instr_ex);
+        const bool jump_ex = op_ex == rv64i::OPCODE_JAL || op_ex == rv64i::OPCODE_JALR;
+        const Bubble control{jump_ex ? JUMP_FLUSH : BRANCH_FLUSH, pc_of(top->debug_seq_ex)};
+
+        bubble_[WB] = bubble_[MEM];
+        bubble_[MEM] = bubble_[EX];
+        if (top->debug_flush_e) {
+            bubble_[EX] = top->debug_stall_f ? Bubble{LOAD_USE, pc_of(top->debug_seq_d)} : control;
+        } else {
+            bubble_[EX] = bubble_[ID];
+        }
+        if (top->debug_flush_d) {
+            bubble_[ID] = control;
+        } else if (!top->debug_stall_f) {
+            bubble_[ID] = Bubble{};
+        }
+    }
+
+    uint64_t cycles() const { return cycles_; }
+    uint64_t retired() const { return retired_; }
+    uint64_t bucket(Bucket b) const { return buckets_[b]; }
+    const std::unordered_map<uint64_t, PcStats>& per_pc() const { return per_pc_; }
+
+    // One line for the end of a testbench log.
+    std::string summary() const {
+        std::ostringstream ss;
+        ss << "CPI STACK: " << cycles_ << " cycles, " << retired_ << " retired, CPI " << std::fixed
+           << std::setprecision(3) << cpi(cycles_, retired_);
+        for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+            ss << ", " << BUCKET_NAMES[b] << ' ' << buckets_[b] << " (" << std::setprecision(1)
+               << percent(buckets_[b]) << "%)";
+        }
+        return ss.str();
+    }
+
+    // Global stack, then one row per static PC, most expensive first.
+    void write(std::ostream& os) const {
+        os << "# CPI stack\n"
+           << "cycles " << cycles_ << '\n'
+           << "retired " << retired_ << '\n'
+           << "cpi " << std::fixed << std::setprecision(3) << cpi(cycles_, retired_) << '\n';
+        for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+            os << BUCKET_NAMES[b] << ' ' << buckets_[b] << ' ' << std::setprecision(1) << percent(buckets_[b])
+               << "%\n";
+        }
+
+        std::vector<std::pair<uint64_t, PcStats>> rows(per_pc_.begin(), per_pc_.end());
+        std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+            return a.second.total() != b.second.total() ? a.second.total() > b.second.total() : a.first < b.first;
+        });
+        os << "\n# per PC: pc retired cycles cpi";
+        for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+            os << ' ' << BUCKET_NAMES[b];
+        }
+        os << '\n';
+        for (const auto& row : rows) {
+            if (row.first == NO_PC) {
+                os << "-";
+            } else {
+                os << "0x" << std::hex << std::setw(8) << std::setfill('0') << row.first << std::dec
+                   << std::setfill(' ');
+            }
+            os << ' ' << row.second.retired << ' ' << row.second.total() << ' ' << std::setprecision(3)
+               << cpi(row.second.total(), row.second.retired);
+            for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+                os << ' ' << row.second.cycles[b];
+            }
+            os << '\n';
+        }
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "ERROR: Could not open CPI stack report for writing: " << path << std::endl;
+            return false;
+        }
+        write(file);
+        return true;
+    }
+
+    // End-of-run self-checks. The buckets, and the per-PC rows, must add up
+    // to the cycles charged.
+    bool check_totals() const {
+        uint64_t buckets = 0;
+        for (unsigned b = 0; b < NUM_BUCKETS; ++b) {
+            buckets += buckets_[b];
+        }
+        uint64_t rows = 0;
+        for (const auto& row : per_pc_) {
+            rows += row.second.total();
+        }
+        if (buckets != cycles_ || rows != cycles_) {
+            std::cerr << "ERROR: CPI stack does not add up: " << cycles_ << " cycles, " << buckets
+                      << " in buckets, " << rows << " in per-PC rows." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Every load-use stall the hazard unit raised (stall_f cycles, e.g.
+    // pipeline_events STALL_LOAD_USE) is one load_use bubble, charged or
+    // still on its way to WB.
+    bool check_load_use(uint64_t stalls) const {
+        uint64_t in_flight = 0;
+        for (unsigned s = EX; s < NUM_SLOTS; ++s) {
+            in_flight += bubble_[s].bucket == LOAD_USE;
+        }
+        if (buckets_[LOAD_USE] + in_flight != stalls) {
+            std::cerr << "ERROR: CPI stack has " << buckets_[LOAD_USE] << " load_use cycles (+" << in_flight
+                      << " in flight) for " << stalls << " load-use stalls." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    enum Slot : unsigned { ID, EX, MEM, WB, NUM_SLOTS };
+    static constexpr uint64_t RING_MASK = 7; // More than the instructions in flight
+
+    struct Bubble {
+        Bucket   bucket = FETCH_WAIT;
+        uint64_t pc = NO_PC;
+    };
+
+    static double cpi(uint64_t cycles, uint64_t retired) {
+        return retired ? static_cast<double>(cycles) / retired : 0.0;
+    }
+
+    double percent(uint64_t cycles) const { return cycles_ ? 100.0 * cycles / cycles_ : 0.0; }
+
+    uint64_t pc_of(uint64_t seq) const { return pc_ring_[seq & RING_MASK]; }
+
+    void charge(const Bubble& b) {
+        ++cycles_;
+        ++buckets_[b.bucket];
+        ++per_pc_[b.pc].cycles[b.bucket];
+    }
+
+    Bubble   bubble_[NUM_SLOTS];
+    uint64_t pc_ring_[RING_MASK + 1] = {NO_PC, NO_PC, NO_PC, NO_PC, NO_PC, NO_PC, NO_PC, NO_PC};
+    uint64_t cycles_ = 0;
+    uint64_t retired_ = 0;
+    uint64_t buckets_[NUM_BUCKETS] = {};
+    std::unordered_map<uint64_t, PcStats> per_pc_;
+};
+
+} // namespace cpi_stack
+
+#endif // CPI_STACK_H
@@ -0,0 +1,217 @@
+// tests/common/elf_loader.h
+#ifndef ELF_LOADER_H
+#define ELF_LOADER_H
+
+#include <elf.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Minimal ELF64 (little-endian, RISC-V) reader for test programs.
+// Produces every PT_LOAD segment as a flat byte image, so the testbench can
+// backdoor-load memories without an objcopy/readelf hex conversion step.
+
+struct ElfSegment {
+    uint64_t             vaddr = 0;
+    uint32_t             flags = 0;     // PF_X / PF_W / PF_R
+    std::vector<uint8_t> bytes;         // p_memsz bytes; tail past p_filesz (.bss) is zero
+};
+
+struct ElfImage {
+    uint64_t                entry = 0;
+    std::vector<ElfSegment> segments;
+    std::string             path;           // File it was loaded from; empty if built in memory
+};
+
+// One PT_LOAD program header, checked to lie inside the file.
+struct ElfLoadSegment {
+    uint64_t vaddr = 0;
+    uint64_t file_offset = 0;
+    uint64_t file_size = 0;
+    uint64_t mem_size = 0;          // Past file_size the segment is zero (.bss)
+    uint32_t flags = 0;             // PF_X / PF_W / PF_R
+};
+
+// Validates the ELF header and program header table of an in-memory file
+// (`size` bytes at `data`; `path` is only used in messages) and returns its
+// non-empty PT_LOAD segments. Shared by load_elf_image() and the mapped
+// images of shared_imem.h.
+inline bool parse_elf_load_segments(const uint8_t* data, size_t size, const std::string& path, uint64_t& entry,
+                                    std::vector<ElfLoadSegment>& segments) {
+    Elf64_Ehdr ehdr;
+    if (size < sizeof(ehdr)) {
+        std::cerr << "ERROR: " << path << " is too small to be an ELF file." << std::endl;
+        return false;
+    }
+    std::memcpy(&ehdr, data, sizeof(ehdr));
+
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr.e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr.e_ident[EI_DATA] != ELFDATA2LSB) {
+        std::cerr << "ERROR: " << path << " is not a little-endian ELF64 file." << std::endl;
+        return false;
+    }
+    if (ehdr.e_machine != EM_RISCV) {
+        std::cerr << "ERROR: " << path << " is not a RISC-V ELF (e_machine=" << ehdr.e_machine << ")." << std::endl;
+        return false;
+    }
+    if (ehdr.e_phentsize != sizeof(Elf64_Phdr) ||
+        ehdr.e_phoff + static_cast<uint64_t>(ehdr.e_phnum) * sizeof(Elf64_Phdr) > size) {
+        std::cerr << "ERROR: " << path << " has a malformed program header table." << std::endl;
+        return false;
+    }
+
+    entry = ehdr.e_entry;
+    segments.clear();
+    for (uint16_t i = 0; i < ehdr.e_phnum; ++i) {
+        Elf64_Phdr phdr;
+        std::memcpy(&phdr, data + ehdr.e_phoff + i * sizeof(Elf64_Phdr), sizeof(phdr));
+        if (phdr.p_type != PT_LOAD || phdr.p_memsz == 0) {
+            continue;
+        }
+        if (phdr.p_filesz > phdr.p_memsz || phdr.p_offset + phdr.p_filesz > size) {
+            std::cerr << "ERROR: " << path << ": PT_LOAD segment " << i << " lies outside the file." << std::endl;
+            return false;
+        }
+        ElfLoadSegment segment;
+        segment.vaddr = phdr.p_vaddr;
+        segment.file_offset = phdr.p_offset;
+        segment.file_size = phdr.p_filesz;
+        segment.mem_size = phdr.p_memsz;
+        segment.flags = phdr.p_flags;
+        segments.push_back(segment);
+    }
+    return true;
+}
+
+inline bool load_elf_image(const std::string& filepath, ElfImage& image) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open ELF file: " << filepath << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::vector<ElfLoadSegment> loads;
+    if (!parse_elf_load_segments(raw.data(), raw.size(), filepath, image.entry, loads)) {
+        return false;
+    }
+    image.segments.clear();
+    image.path = filepath;
+
+    for (const ElfLoadSegment& load : loads) {
+        ElfSegment segment;
+        segment.vaddr = load.vaddr;
+        segment.flags = load.flags;
+        segment.bytes.assign(load.mem_size, 0);
+        std::memcpy(segment.bytes.data(), raw.data() + load.file_offset, load.file_size);
+        image.segments.push_back(std::move(segment));
+    }
+
+    if (image.segments.empty()) {
+        std::cerr << "ERROR: " << filepath << " has no PT_LOAD segments." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct ElfSymbol {
+    std::string name;
+    uint64_t    value = 0;
+    uint64_t    size = 0;
+    uint8_t     type = STT_NOTYPE;  // STT_FUNC / STT_OBJECT / ...
+};
+
+// Reads the static symbol table (.symtab). A stripped file is not an error;
+// it just has no symbols.
+inline bool load_elf_symbols(const std::string& filepath, std::vector<ElfSymbol>& symbols) {
+    symbols.clear();
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open ELF file: " << filepath << std::endl;
+        return false;
+    }
+    std::vector<uint8_t> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Elf64_Ehdr ehdr;
+    if (raw.size() < sizeof(ehdr)) {
+        std::cerr << "ERROR: " << filepath << " is too small to be an ELF file." << std::endl;
+        return false;
+    }
+    std::memcpy(&ehdr, raw.data(), sizeof(ehdr));
+    if (ehdr.e_shoff == 0 || ehdr.e_shnum == 0) {
+        return true;
+    }
+    if (ehdr.e_shentsize != sizeof(Elf64_Shdr) ||
+        ehdr.e_shoff + static_cast<uint64_t>(ehdr.e_shnum) * sizeof(Elf64_Shdr) > raw.size()) {
+        std::cerr << "ERROR: " << filepath << " has a malformed section header table." << std::endl;
+        return false;
+    }
+    auto section = [&](uint32_t index) {
+        Elf64_Shdr shdr;
+        std::memcpy(&shdr, raw.data() + ehdr.e_shoff + index * sizeof(Elf64_Shdr), sizeof(shdr));
+        return shdr;
+    };
+
+    for (uint16_t i = 0; i < ehdr.e_shnum; ++i) {
+        const Elf64_Shdr symtab = section(i);
+        if (symtab.sh_type != SHT_SYMTAB) {
+            continue;
+        }
+        if (symtab.sh_link >= ehdr.e_shnum || symtab.sh_offset + symtab.sh_size > raw.size()) {
+            std::cerr << "ERROR: " << filepath << ": symbol table lies outside the file." << std::endl;
+            return false;
+        }
+        const Elf64_Shdr strtab = section(symtab.sh_link);
+        if (strtab.sh_offset + strtab.sh_size > raw.size()) {
+            std::cerr << "ERROR: " << filepath << ": string table lies outside the file." << std::endl;
+            return false;
+        }
+        const char* names = reinterpret_cast<const char*>(raw.data() + strtab.sh_offset);
+        for (uint64_t offset = sizeof(Elf64_Sym); offset + sizeof(Elf64_Sym) <= symtab.sh_size;
+             offset += sizeof(Elf64_Sym)) { // Entry 0 is the undefined symbol
+            Elf64_Sym sym;
+            std::memcpy(&sym, raw.data() + symtab.sh_offset + offset, sizeof(sym));
+            if (sym.st_name == 0 || sym.st_name >= strtab.sh_size || sym.st_shndx == SHN_UNDEF) {
+                continue;
+            }
+            ElfSymbol symbol;
+            symbol.name.assign(names + sym.st_name, strnlen(names + sym.st_name, strtab.sh_size - sym.st_name));
+            symbol.value = sym.st_value;
+            symbol.size = sym.st_size;
+            symbol.type = ELF64_ST_TYPE(sym.st_info);
+            symbols.push_back(std::move(symbol));
+        }
+    }
+    return true;
+}
+
+inline bool elf_find_symbol(const std::vector<ElfSymbol>& symbols, const std::string& name, uint64_t& value) {
+    for (const ElfSymbol& symbol : symbols) {
+        if (symbol.name == name) {
+            value = symbol.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads a little-endian 32-bit word from whichever segment covers addr.
+inline bool elf_image_read32(const ElfImage& image, uint64_t addr, uint32_t& word) {
+    for (const ElfSegment& segment : image.segments) {
+        if (addr >= segment.vaddr && addr + 4 <= segment.vaddr + segment.bytes.size()) {
+            const uint8_t* p = segment.bytes.data() + (addr - segment.vaddr);
+            word = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                   (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // ELF_LOADER_H
@@ -0,0 +1,101 @@
+// tests/common/elf_writer.h
+#ifndef ELF_WRITER_H
+#define ELF_WRITER_H
+
+#include "elf_loader.h"
+
+#include <elf.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Writers for generated test programs: the inverse of load_elf_image(), and
+// the $readmemh image read by instruction_memory's +INSTR_MEM_INIT_FILE.
+
+// Writes a static ELF64 RISC-V executable with one PT_LOAD per segment and no
+// section headers, which is all load_elf_image() and the ISS loader need.
+inline bool write_elf_image(const std::string& filepath, const ElfImage& image) {
+    Elf64_Ehdr ehdr;
+    std::memset(&ehdr, 0, sizeof(ehdr));
+    std::memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_EXEC;
+    ehdr.e_machine = EM_RISCV;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_entry = image.entry;
+    ehdr.e_phoff = sizeof(Elf64_Ehdr);
+    ehdr.e_ehsize = sizeof(Elf64_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = static_cast<uint16_t>(image.segments.size());
+
+    std::vector<uint8_t> raw(sizeof(Elf64_Ehdr) + image.segments.size() * sizeof(Elf64_Phdr));
+    std::memcpy(raw.data(), &ehdr, sizeof(ehdr));
+    for (size_t i = 0; i < image.segments.size(); ++i) {
+        const ElfSegment& segment = image.segments[i];
+        while (raw.size() % 8 != 0) {
+            raw.push_back(0);
+        }
+        Elf64_Phdr phdr;
+        std::memset(&phdr, 0, sizeof(phdr));
+        phdr.p_type = PT_LOAD;
+        phdr.p_flags = segment.flags;
+        phdr.p_offset = raw.size();
+        phdr.p_vaddr = segment.vaddr;
+        phdr.p_paddr = segment.vaddr;
+        phdr.p_filesz = segment.bytes.size();
+        phdr.p_memsz = segment.bytes.size();
+        phdr.p_align = 8;
+        std::memcpy(raw.data() + sizeof(Elf64_Ehdr) + i * sizeof(Elf64_Phdr), &phdr, sizeof(phdr));
+        raw.insert(raw.end(), segment.bytes.begin(), segment.bytes.end());
+    }
+
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open ELF file for writing: " << filepath << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(raw.data()), static_cast<std::streamsize>(raw.size()));
+    return file.good();
+}
+
+// Writes the executable segments as a word-addressed hex image (one
+// "@<word index>" line per segment). Data segments cannot be expressed in
+// this format and are an error.
+inline bool write_hex_image(const std::string& filepath, const ElfImage& image) {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open hex file for writing: " << filepath << std::endl;
+        return false;
+    }
+    file << std::hex << std::uppercase << std::setfill('0');
+    for (const ElfSegment& segment : image.segments) {
+        if (!(segment.flags & PF_X)) {
+            std::cerr << "ERROR: Hex images hold instructions only; the data segment at 0x" << std::hex
+                      << segment.vaddr << std::dec << " needs an ELF image." << std::endl;
+            return false;
+        }
+        if (segment.vaddr % 4 != 0) {
+            std::cerr << "ERROR: Executable segment at 0x" << std::hex << segment.vaddr << std::dec
+                      << " is not word aligned." << std::endl;
+            return false;
+        }
+        file << '@' << std::setw(8) << segment.vaddr / 4 << '\n';
+        for (uint64_t offset = 0; offset < segment.bytes.size(); offset += 4) {
+            uint32_t word = 0;
+            for (uint64_t b = 0; b < 4 && offset + b < segment.bytes.size(); ++b) {
+                word |= static_cast<uint32_t>(segment.bytes[offset + b]) << (8 * b);
+            }
+            file << std::setw(8) << word << '\n';
+        }
+    }
+    return file.good();
+}
+
+#endif // ELF_WRITER_H
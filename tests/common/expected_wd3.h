@@ -0,0 +1,60 @@
+// tests/common/expected_wd3.h
+#ifndef EXPECTED_WD3_H
+#define EXPECTED_WD3_H
+
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Expected register-file write data per cycle: one hex value per line, or
+// 'x'/'X' when no write is expected that cycle. '#' starts a comment line.
+const uint64_t X_DEF = 0xFFFFFFFFFFFFFFFFUL;
+
+// Pass as expected_num_cycles for runs that end when the program does.
+const int EXPECTED_WD3_UNTIL_EXIT = -1;
+
+inline bool load_expected_wd3_values(const std::string& filepath, std::vector<uint64_t>& values, int expected_num_cycles) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open expected output file: " << filepath << std::endl;
+        return false;
+    }
+    std::string line;
+    int line_count = 0;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        try {
+            if (line == "X" || line == "x") {
+                values.push_back(X_DEF);
+            } else {
+                values.push_back(std::stoull(line, nullptr, 16));
+            }
+            line_count++;
+        } catch (const std::exception& e) {
+            std::cerr << "Error parsing hex value '" << line << "' at line " << (line_count + 1) << ": " << e.what() << std::endl;
+            return false;
+        }
+    }
+    file.close();
+    if (expected_num_cycles == EXPECTED_WD3_UNTIL_EXIT) {
+        return true;
+    }
+    if (line_count < expected_num_cycles) {
+        std::cerr << "ERROR: Number of expected values (" << line_count
+                  << ") is less than NUM_CYCLES_TO_RUN (" << expected_num_cycles << ")." << std::endl;
+        std::cerr << "Please provide an expected value (or 'X' if no write) for each cycle." << std::endl;
+        return false;
+    }
+    if (line_count > expected_num_cycles) {
+         std::cerr << "Warning: Number of expected values (" << line_count
+                  << ") is greater than NUM_CYCLES_TO_RUN (" << expected_num_cycles << ")." << std::endl;
+    }
+    return true;
+}
+
+#endif // EXPECTED_WD3_H
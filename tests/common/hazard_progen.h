@@ -0,0 +1,374 @@
+// tests/common/hazard_progen.h
+#ifndef HAZARD_PROGEN_H
+#define HAZARD_PROGEN_H
+
+#include "elf_loader.h"
+#include "rv64i_isa.h"
+#include "rv64i_model.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Constrained-random RV64I programs aimed at hazard_unit.sv and the execute
+// stage forwarding muxes. A program is a register-initialising prologue, a
+// body of randomly chosen hazard patterns and a NOP drain ending in ecall.
+// Every control transfer is forward, so all programs terminate.
+//
+// The working set of registers is kept small (Config::num_regs) so that even
+// filler instructions collide often. Memory accesses are naturally aligned and
+// stay inside data memory, with the base register written right before the
+// access so the address itself is forwarded.
+
+namespace progen {
+
+enum Pattern : unsigned {
+    RAW_EX_MEM,       // Producer, then consumer: EX/MEM forwarding (chains of 2-4)
+    RAW_MEM_WB,       // Producer, one unrelated instruction, consumer: MEM/WB forwarding
+    FORWARD_PRIORITY, // Same rd written twice (EX/MEM must win), or rs1/rs2 from different stages
+    LOAD_USE,         // Load, then consumer: one stall; or one instruction later: no stall
+    BRANCH,           // Branch right after a producer or load of its operand
+    JUMP,             // jal/jalr right after a producer, link register consumed at the target
+    X0,               // Writes to x0 followed by x0 readers: no forwarding, no stall
+    MEMORY,           // Store, then a load from the same address
+    FILLER,           // Random ALU instruction
+    NUM_PATTERNS
+};
+
+const char* const PATTERN_NAMES[NUM_PATTERNS] = {
+    "raw_ex_mem", "raw_mem_wb", "forward_priority", "load_use", "branch", "jump", "x0", "memory", "filler",
+};
+
+struct Config {
+    unsigned length = 200;        // Patterns per program
+    unsigned num_regs = 6;        // Working-set registers, 2-31
+    uint64_t text_base = 0x10000; // Link address of the program
+    uint64_t dmem_bytes = 1024;   // Data memory size (rtl/core/data_memory.sv)
+    bool     data_segment = false; // Also emit a random initial data-memory image
+    unsigned weights[NUM_PATTERNS] = {4, 3, 2, 4, 3, 2, 1, 2, 2};
+};
+
+// Parses "name=weight,name=weight" into config.weights. Unnamed patterns keep
+// their weight.
+inline bool parse_weights(const std::string& spec, Config& config) {
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const size_t eq = item.find('=');
+        const std::string name = item.substr(0, eq);
+        unsigned p = 0;
+        while (p < NUM_PATTERNS && name != PATTERN_NAMES[p]) {
+            ++p;
+        }
+        if (eq == std::string::npos || p == NUM_PATTERNS) {
+            std::cerr << "ERROR: Bad pattern weight '" << item << "'." << std::endl;
+            return false;
+        }
+        config.weights[p] = static_cast<unsigned>(std::strtoul(item.c_str() + eq + 1, nullptr, 0));
+    }
+    return true;
+}
+
+struct Program {
+    ElfImage image;
+    uint64_t static_instructions = 0;
+    uint64_t pattern_counts[NUM_PATTERNS] = {};
+};
+
+class Generator {
+public:
+    explicit Generator(const Config& config) : config_(config) {
+        if (config_.num_regs < 2) config_.num_regs = 2;
+        if (config_.num_regs > 31) config_.num_regs = 31;
+    }
+
+    Program generate(uint64_t seed) {
+        rng_.seed(seed);
+        code_.clear();
+        Program program;
+
+        // Working set: num_regs distinct registers out of x1-x31
+        std::vector<uint8_t> all;
+        for (uint8_t r = 1; r < 32; ++r) {
+            all.push_back(r);
+        }
+        std::shuffle(all.begin(), all.end(), rng_);
+        regs_.assign(all.begin(), all.begin() + config_.num_regs);
+
+        for (uint8_t r : regs_) {
+            emit(rv64i::encode_u(rv64i::OPCODE_LUI, r, static_cast<int64_t>(rng_() & 0xFFFFF) << 12));
+            emit(rv64i::encode_i(rv64i::OPCODE_OP_IMM, r, 0b000, r, imm12()));
+        }
+
+        std::discrete_distribution<unsigned> choose(std::begin(config_.weights), std::end(config_.weights));
+        for (unsigned i = 0; i < config_.length; ++i) {
+            const unsigned pattern = choose(rng_);
+            ++program.pattern_counts[pattern];
+            emit_pattern(static_cast<Pattern>(pattern));
+        }
+
+        for (int i = 0; i < 5; ++i) {
+            emit(rv64i::FunctionalModel::NOP); // Drain the pipeline before the end marker
+        }
+        emit(0x00000073); // ecall
+
+        ElfSegment text;
+        text.vaddr = config_.text_base;
+        text.flags = PF_R | PF_X;
+        for (uint32_t word : code_) {
+            for (int b = 0; b < 4; ++b) {
+                text.bytes.push_back(static_cast<uint8_t>(word >> (8 * b)));
+            }
+        }
+        program.image.entry = config_.text_base;
+        program.image.segments.push_back(std::move(text));
+        if (config_.data_segment) {
+            ElfSegment data;
+            data.vaddr = 0;
+            data.flags = PF_R | PF_W;
+            for (uint64_t i = 0; i < config_.dmem_bytes; ++i) {
+                data.bytes.push_back(static_cast<uint8_t>(rng_()));
+            }
+            program.image.segments.push_back(std::move(data));
+        }
+        program.static_instructions = code_.size();
+        return program;
+    }
+
+private:
+    void emit(uint32_t instr) { code_.push_back(instr); }
+
+    unsigned below(unsigned n) { return static_cast<unsigned>(rng_() % n); }
+    bool coin() { return (rng_() & 1) != 0; }
+    int64_t imm12() { return static_cast<int64_t>(below(4096)) - 2048; }
+    uint8_t reg() { return regs_[below(static_cast<unsigned>(regs_.size()))]; }
+    uint8_t other_reg(uint8_t not_this) {
+        uint8_t r;
+        do {
+            r = reg();
+        } while (r == not_this);
+        return r;
+    }
+
+    // Register-register or register-immediate ALU operation.
+    uint32_t alu(uint8_t rd, uint8_t rs1, uint8_t rs2) {
+        const uint8_t f3 = static_cast<uint8_t>(below(8));
+        if (coin()) {
+            const uint8_t f7 = ((f3 == 0b000 || f3 == 0b101) && coin()) ? 0x20 : 0x00; // sub / sra
+            return rv64i::encode_r(rv64i::OPCODE_OP, rd, f3, rs1, rs2, f7);
+        }
+        if (f3 == 0b001 || f3 == 0b101) {
+            const int64_t shamt = below(64);
+            const int64_t alt = (f3 == 0b101 && coin()) ? 0x400 : 0; // srai
+            return rv64i::encode_i(rv64i::OPCODE_OP_IMM, rd, f3, rs1, alt | shamt);
+        }
+        return rv64i::encode_i(rv64i::OPCODE_OP_IMM, rd, f3, rs1, imm12());
+    }
+
+    // Any instruction that writes rd without depending on a recent result in a
+    // way the caller cares about.
+    void producer(uint8_t rd) {
+        switch (below(6)) {
+            case 0:  emit(rv64i::encode_u(rv64i::OPCODE_LUI, rd, static_cast<int64_t>(rng_() & 0xFFFFF) << 12)); break;
+            case 1:  emit(rv64i::encode_u(rv64i::OPCODE_AUIPC, rd, static_cast<int64_t>(below(16)) << 12)); break;
+            default: emit(alu(rd, reg(), reg())); break;
+        }
+    }
+
+    // An ALU instruction reading r as rs1, rs2 or both.
+    void consumer(uint8_t r, uint8_t rd) {
+        switch (below(3)) {
+            case 0:  emit(alu(rd, r, reg())); break;
+            case 1:  emit(rv64i::encode_r(rv64i::OPCODE_OP, rd, static_cast<uint8_t>(below(8)), reg(), r, 0)); break;
+            default: emit(rv64i::encode_r(rv64i::OPCODE_OP, rd, 0b000, r, r, coin() ? 0x20 : 0x00)); break;
+        }
+    }
+
+    // Filler that neither reads nor writes r.
+    void unrelated(uint8_t r) {
+        uint8_t rd = other_reg(r), rs1 = other_reg(r), rs2 = other_reg(r);
+        emit(alu(rd, rs1, rs2));
+    }
+
+    // Sets base to an address inside data memory and returns a naturally
+    // aligned offset for an access of 1 << size_log2 bytes.
+    int64_t address(uint8_t base, unsigned size_log2) {
+        const uint64_t window = std::min<uint64_t>(addressable() - 64, 2047 - 64);
+        const int64_t base_addr = static_cast<int64_t>(below(static_cast<unsigned>(window / 8 + 1)) * 8);
+        emit(rv64i::encode_i(rv64i::OPCODE_OP_IMM, base, 0b000, 0, base_addr));
+        return static_cast<int64_t>(below(64 >> size_log2) << size_log2);
+    }
+
+    // Bytes reachable with an addi from x0, rounded down to doublewords.
+    uint64_t addressable() const { return std::max<uint64_t>(std::min<uint64_t>(config_.dmem_bytes, 2048), 64) & ~7ULL; }
+    int64_t address_mask() const { return static_cast<int64_t>((addressable() - 8) & 0x7F8); }
+
+    void load(uint8_t rd, uint8_t base) {
+        static const uint8_t f3s[] = {0b000, 0b001, 0b010, 0b011, 0b100, 0b101, 0b110}; // lb..ld, lbu..lwu
+        const uint8_t f3 = f3s[below(7)];
+        const int64_t offset = address(base, f3 & 0x3);
+        emit(rv64i::encode_i(rv64i::OPCODE_LOAD, rd, f3, base, offset));
+    }
+
+    void store(uint8_t data, uint8_t base, uint8_t f3, int64_t offset) {
+        emit(rv64i::encode_s(rv64i::OPCODE_STORE, f3, base, data, offset));
+    }
+
+    // Branch over `skip` filler instructions. Operands are supplied by the caller.
+    void branch(uint8_t rs1, uint8_t rs2) {
+        static const uint8_t f3s[] = {0b000, 0b001, 0b100, 0b101, 0b110, 0b111};
+        const unsigned skip = 1 + below(3);
+        emit(rv64i::encode_b(f3s[below(6)], rs1, rs2, 4 * (skip + 1)));
+        for (unsigned i = 0; i < skip; ++i) {
+            emit(alu(reg(), reg(), reg()));
+        }
+    }
+
+    void emit_pattern(Pattern pattern) {
+        switch (pattern) {
+            case RAW_EX_MEM: {
+                uint8_t r = reg();
+                producer(r);
+                for (unsigned n = 1 + below(3); n > 0; --n) {
+                    const uint8_t next = reg();
+                    consumer(r, next);
+                    r = next;
+                }
+                break;
+            }
+            case RAW_MEM_WB: {
+                const uint8_t r = reg();
+                producer(r);
+                unrelated(r);
+                consumer(r, reg());
+                break;
+            }
+            case FORWARD_PRIORITY: {
+                const uint8_t a = reg();
+                if (coin()) {
+                    producer(a);
+                    producer(a);
+                    consumer(a, reg());
+                } else {
+                    const uint8_t b = other_reg(a);
+                    producer(a); // MEM/WB when the consumer executes
+                    producer(b); // EX/MEM
+                    emit(rv64i::encode_r(rv64i::OPCODE_OP, reg(), static_cast<uint8_t>(below(8)),
+                                         coin() ? a : b, coin() ? b : a, 0));
+                }
+                break;
+            }
+            case LOAD_USE: {
+                const uint8_t r = reg();
+                const unsigned use = below(3);
+                // A consuming store gets its base before the load, so in the
+                // stall variant it still directly follows the load. The load's
+                // own addi may reuse that register; it sets another in-range
+                // address.
+                uint8_t store_base = 0;
+                int64_t store_offset = 0;
+                if (use == 1) {
+                    store_base = other_reg(r);
+                    store_offset = address(store_base, 3);
+                }
+                load(r, other_reg(r));
+                const bool stall = below(4) != 0;
+                if (!stall) {
+                    unrelated(r);
+                }
+                switch (use) {
+                    case 0: consumer(r, reg()); break;
+                    case 1:
+                        store(r, store_base, 0b011, store_offset); // Loaded value is the store data
+                        break;
+                    default:
+                        // Loaded value, masked into data memory, is the next load's address
+                        emit(rv64i::encode_i(rv64i::OPCODE_OP_IMM, r, 0b111, r, address_mask()));
+                        emit(rv64i::encode_i(rv64i::OPCODE_LOAD, reg(), 0b011, r, 0));
+                        break;
+                }
+                break;
+            }
+            case BRANCH: {
+                const uint8_t r = reg();
+                if (below(3) == 0) {
+                    load(r, other_reg(r)); // Load-use into the comparator
+                } else {
+                    producer(r);
+                }
+                const unsigned form = below(3);
+                branch(form == 1 ? reg() : r, form == 0 ? reg() : r);
+                break;
+            }
+            case JUMP: {
+                const uint8_t r = reg();
+                const uint8_t link = coin() ? reg() : 0;
+                const unsigned skip = 1 + below(3);
+                if (coin()) {
+                    producer(r);
+                    emit(rv64i::encode_j(link, 4 * (skip + 1)));
+                } else {
+                    // auipc feeds jalr's base through EX/MEM forwarding
+                    emit(rv64i::encode_u(rv64i::OPCODE_AUIPC, r, 0));
+                    emit(rv64i::encode_i(rv64i::OPCODE_JALR, link, 0b000, r, 4 * (skip + 2)));
+                }
+                for (unsigned i = 0; i < skip; ++i) {
+                    emit(alu(reg(), reg(), reg()));
+                }
+                consumer(link != 0 ? link : r, reg());
+                break;
+            }
+            case X0: {
+                switch (below(4)) {
+                    case 0:
+                        emit(alu(0, reg(), reg())); // Must not be forwarded
+                        consumer(0, reg());
+                        break;
+                    case 1:
+                        load(0, reg()); // rd == x0: no load-use stall
+                        consumer(0, reg());
+                        break;
+                    case 2:
+                        emit(rv64i::encode_u(rv64i::OPCODE_LUI, 0, static_cast<int64_t>(rng_() & 0xFFFFF) << 12));
+                        branch(0, coin() ? 0 : reg());
+                        break;
+                    default:
+                        emit(rv64i::encode_i(rv64i::OPCODE_OP_IMM, 0, 0b000, reg(), imm12()));
+                        unrelated(0);
+                        consumer(0, reg());
+                        break;
+                }
+                break;
+            }
+            case MEMORY: {
+                static const uint8_t f3s[] = {0b000, 0b001, 0b010, 0b011}; // sb..sd
+                const uint8_t data = reg();
+                const uint8_t base = other_reg(data);
+                producer(data);
+                const uint8_t f3 = f3s[below(4)];
+                const int64_t offset = address(base, f3);
+                store(data, base, f3, offset);
+                const uint8_t load_f3 = (f3 != 0b011 && coin()) ? (f3 | 0x4) : f3; // Signed or unsigned
+                emit(rv64i::encode_i(rv64i::OPCODE_LOAD, reg(), load_f3, base, offset));
+                break;
+            }
+            default:
+                emit(alu(reg(), reg(), reg()));
+                break;
+        }
+    }
+
+    Config config_;
+    std::mt19937_64 rng_;
+    std::vector<uint8_t> regs_;
+    std::vector<uint32_t> code_;
+};
+
+} // namespace progen
+
+#endif // HAZARD_PROGEN_H
@@ -0,0 +1,214 @@
+// tests/common/pipeline_backdoor.h
+#ifndef PIPELINE_BACKDOOR_H
+#define PIPELINE_BACKDOOR_H
+
+#include "Vpipeline.h"
+#include "Vpipeline___024root.h"
+
+#include "elf_loader.h"
+#ifdef PIPELINE_SHARED_IMEM
+#include "shared_imem.h"
+#endif
+#ifdef PIPELINE_SPARSE_DMEM
+#include "sparse_dmem.h"
+#endif
+
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+// Direct access to the pipeline's `verilator public` state.
+//
+// Ordering matters because initial blocks and reset touch the same arrays:
+//   1. top->eval() once so instruction_memory's initial block has run;
+//   2. backdoor_load_instr_mem() / backdoor_set_pc_start();
+//   3. reset sequence (data_memory clears itself on reset);
+//   4. backdoor_load_data_mem().
+// To run another program on the same model, hold rst_n low, call
+// backdoor_clear_instr_mem() and repeat steps 2-4.
+//
+// In a hierarchical build (PIPELINE_HIERARCHICAL) the memories and register
+// file live inside separately verilated stage blocks and are not reachable
+// from the top model. Only pc_start_addr, which belongs to the top module,
+// stays accessible; the ELF loaders report an error so such a build runs
+// +INSTR_MEM_INIT_FILE programs only.
+//
+// With a shared instruction image (PIPELINE_SHARED_IMEM) there is no ROM
+// array: loading binds the ELF file the image was read from to the calling
+// thread (tests/common/shared_imem.h), so it works for images from
+// load_elf_image() only. Likewise a sparse data memory (PIPELINE_SPARSE_DMEM)
+// is the calling thread's sparse_dmem::thread_memory(); it takes any address,
+// and reset restores the loaded image rather than clearing it.
+
+inline void backdoor_set_pc_start(Vpipeline* top, uint64_t pc) {
+    top->rootp->pipeline__DOT__pc_start_addr = pc;
+}
+
+#ifdef PIPELINE_HIERARCHICAL
+
+inline bool backdoor_load_instr_mem(Vpipeline*, const ElfImage&) {
+    std::cerr << "ERROR: ELF loading needs the memory backdoor, which a hierarchical build does not have. "
+              << "Use +INSTR_MEM_INIT_FILE or a flat build." << std::endl;
+    return false;
+}
+
+inline bool backdoor_load_data_mem(Vpipeline* top, const ElfImage& image) {
+    return backdoor_load_instr_mem(top, image);
+}
+
+#else
+
+#ifndef PIPELINE_SPARSE_DMEM
+inline auto& backdoor_data_mem(Vpipeline* top) {
+    return top->rootp->pipeline__DOT__u_memory_stage__DOT__u_data_memory__DOT__mem;
+}
+#endif
+
+inline auto& backdoor_register_file(Vpipeline* top) {
+    return top->rootp->pipeline__DOT__u_decode__DOT__u_register_file__DOT__regs;
+}
+
+template <typename Array>
+constexpr uint64_t backdoor_array_depth(const Array& array) {
+    return sizeof(array.m_storage) / sizeof(array.m_storage[0]);
+}
+
+#ifdef PIPELINE_SHARED_IMEM
+
+inline void backdoor_clear_instr_mem(Vpipeline*) {
+    shared_imem::bind(nullptr);
+}
+
+inline bool backdoor_load_instr_mem(Vpipeline*, const ElfImage& image) {
+    if (image.path.empty()) {
+        std::cerr << "ERROR: The shared instruction image maps ELF files; this image was not loaded from one."
+                  << std::endl;
+        return false;
+    }
+    std::shared_ptr<const shared_imem::Image> shared = shared_imem::Image::open(image.path);
+    if (!shared) {
+        return false;
+    }
+    shared_imem::bind(std::move(shared));
+    return true;
+}
+
+#else
+
+inline auto& backdoor_instr_mem(Vpipeline* top) {
+    return top->rootp->pipeline__DOT__u_fetch__DOT__i_instr_mem__DOT__mem;
+}
+
+// Fills the instruction ROM with NOPs. Needed when a model is reused for
+// another program: reset does not touch the ROM, and a loaded word is fetched
+// as it is, so zeroing it would not give a NOP back.
+inline void backdoor_clear_instr_mem(Vpipeline* top) {
+    constexpr uint32_t NOP = 0x00000013; // addi x0, x0, 0
+    auto& mem = backdoor_instr_mem(top);
+    for (uint64_t i = 0; i < backdoor_array_depth(mem); ++i) {
+        mem[i] = NOP;
+    }
+}
+
+// Copies executable segments into the word-addressed instruction ROM.
+inline bool backdoor_load_instr_mem(Vpipeline* top, const ElfImage& image) {
+    auto& mem = backdoor_instr_mem(top);
+    const uint64_t mem_size_bytes = backdoor_array_depth(mem) * 4;
+
+    for (const ElfSegment& segment : image.segments) {
+        if (!(segment.flags & PF_X)) {
+            continue;
+        }
+        if (segment.vaddr % 4 != 0 || segment.vaddr + segment.bytes.size() > mem_size_bytes) {
+            std::cerr << "ERROR: Executable segment at 0x" << std::hex << segment.vaddr << std::dec
+                      << " (" << segment.bytes.size() << " bytes) does not fit instruction memory." << std::endl;
+            return false;
+        }
+        for (uint64_t offset = 0; offset < segment.bytes.size(); offset += 4) {
+            uint32_t word = 0;
+            for (uint64_t b = 0; b < 4 && offset + b < segment.bytes.size(); ++b) {
+                word |= static_cast<uint32_t>(segment.bytes[offset + b]) << (8 * b);
+            }
+            mem[(segment.vaddr + offset) / 4] = word;
+        }
+    }
+    return true;
+}
+
+#endif // PIPELINE_SHARED_IMEM
+
+#ifdef PIPELINE_SPARSE_DMEM
+
+inline bool backdoor_load_data_mem(Vpipeline*, const ElfImage& image) {
+    return sparse_dmem::thread_memory().load(image);
+}
+
+#else
+
+// Copies every segment that falls inside the data memory window
+// (.data/.rodata/.bss). Segments outside both memories are an error:
+// the program would silently read wrong data otherwise.
+inline bool backdoor_load_data_mem(Vpipeline* top, const ElfImage& image) {
+    auto& mem = backdoor_data_mem(top);
+    const uint64_t mem_size_bytes = backdoor_array_depth(mem);
+
+    for (const ElfSegment& segment : image.segments) {
+        const bool fits = segment.vaddr + segment.bytes.size() <= mem_size_bytes;
+        if (!fits) {
+            if (segment.flags & PF_X) {
+                continue; // Code only lives in instruction memory
+            }
+            std::cerr << "ERROR: Data segment at 0x" << std::hex << segment.vaddr << std::dec
+                      << " (" << segment.bytes.size() << " bytes) is outside data memory (0x0-0x"
+                      << std::hex << mem_size_bytes << std::dec << "). Link it lower, e.g. -Tdata=0x100." << std::endl;
+            return false;
+        }
+        for (uint64_t offset = 0; offset < segment.bytes.size(); ++offset) {
+            mem[segment.vaddr + offset] = segment.bytes[offset];
+        }
+    }
+    return true;
+}
+
+#endif // PIPELINE_SPARSE_DMEM
+
+// Architectural state handoff, e.g. from a functional fast-forward. The PC goes
+// in through backdoor_set_pc_start() before reset. Registers are loaded after
+// the reset ticks but before rst_n is released, so the first decoded
+// instruction already reads them; data bytes go in after release, like
+// backdoor_load_data_mem().
+inline void backdoor_load_registers(Vpipeline* top, const uint64_t (&regs)[32]) {
+    auto& rf = backdoor_register_file(top);
+    for (int i = 0; i < 32; ++i) {
+        rf[i] = i == 0 ? 0 : regs[i];
+    }
+}
+
+#ifdef PIPELINE_SPARSE_DMEM
+
+inline bool backdoor_load_data_bytes(Vpipeline*, const std::vector<uint8_t>& bytes) {
+    ElfImage image;
+    image.segments.push_back({0, PF_R | PF_W, bytes});
+    return sparse_dmem::thread_memory().load(image);
+}
+
+#else
+
+inline bool backdoor_load_data_bytes(Vpipeline* top, const std::vector<uint8_t>& bytes) {
+    auto& mem = backdoor_data_mem(top);
+    if (bytes.size() > backdoor_array_depth(mem)) {
+        std::cerr << "ERROR: " << bytes.size() << " bytes of data do not fit data memory." << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < bytes.size(); ++i) {
+        mem[i] = bytes[i];
+    }
+    return true;
+}
+
+#endif // PIPELINE_SPARSE_DMEM
+
+#endif // PIPELINE_HIERARCHICAL
+
+#endif // PIPELINE_BACKDOOR_H
@@ -0,0 +1,275 @@
+// tests/common/pipeline_events.h
+#ifndef PIPELINE_EVENTS_H
+#define PIPELINE_EVENTS_H
+
+#include "rv64i_isa.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Always-on hazard and dispatch counters, sampled from the pipeline debug
+// ports once per cycle: every hazard_unit outcome (forward_a/forward_b source,
+// load-use stall, decode and execute flush) and the opcode/funct3 of every
+// instruction that enters EX. Sampling is a handful of array increments, so
+// testbenches keep it on for every run.
+//
+// Reports are plain "<name> <count>" lines. Every field is a sum, so reports
+// of many runs merge by adding them (merge(), read(), tools/event_report_merge).
+// Hazard outcomes are listed even when zero, which shows the paths a
+// regression never exercised.
+
+namespace pipeline_events {
+
+enum Event : unsigned {
+    CYCLES,
+    DISPATCHED,      // Valid instructions entering EX
+    FORWARD_A_NONE,  // forward_a 00: register file
+    FORWARD_A_WB,    // forward_a 01: from WB
+    FORWARD_A_MEM,   // forward_a 10: from MEM
+    FORWARD_B_NONE,
+    FORWARD_B_WB,
+    FORWARD_B_MEM,
+    STALL_LOAD_USE,
+    FLUSH_DECODE,    // Taken branch or jump
+    FLUSH_EXECUTE,   // Load-use bubble or taken branch/jump
+    NUM_EVENTS
+};
+
+const char* const EVENT_NAMES[NUM_EVENTS] = {
+    "cycles",
+    "dispatched",
+    "forward_a.00_regfile",
+    "forward_a.01_wb",
+    "forward_a.10_mem",
+    "forward_b.00_regfile",
+    "forward_b.01_wb",
+    "forward_b.10_mem",
+    "stall.load_use",
+    "flush.decode",
+    "flush.execute",
+};
+
+// Name of a major opcode, or null for encodings the core does not decode.
+inline const char* opcode_name(uint8_t op) {
+    switch (op) {
+        case rv64i::OPCODE_LUI:      return "LUI";
+        case rv64i::OPCODE_AUIPC:    return "AUIPC";
+        case rv64i::OPCODE_JAL:      return "JAL";
+        case rv64i::OPCODE_JALR:     return "JALR";
+        case rv64i::OPCODE_BRANCH:   return "BRANCH";
+        case rv64i::OPCODE_LOAD:     return "LOAD";
+        case rv64i::OPCODE_STORE:    return "STORE";
+        case rv64i::OPCODE_OP_IMM:   return "OP_IMM";
+        case rv64i::OPCODE_OP:       return "OP";
+        case rv64i::OPCODE_MISC_MEM: return "MISC_MEM";
+        case rv64i::OPCODE_SYSTEM:   return "SYSTEM";
+        default:                     return nullptr;
+    }
+}
+
+// LUI, AUIPC and JAL keep immediate bits where funct3 would be.
+inline bool has_funct3(uint8_t op) {
+    return op != rv64i::OPCODE_LUI && op != rv64i::OPCODE_AUIPC && op != rv64i::OPCODE_JAL;
+}
+
+// A fresh Counters holds one run; clear() makes an empty accumulator.
+class Counters {
+public:
+    // Call once per cycle, after the clock edge.
+    template <typename Model>
+    void sample(const Model* top) {
+        ++events_[CYCLES];
+        events_[STALL_LOAD_USE] += top->debug_stall_f;
+        events_[FLUSH_DECODE] += top->debug_flush_d;
+        events_[FLUSH_EXECUTE] += top->debug_flush_e;
+        if (!top->debug_valid_ex) {
+            return;
+        }
+        ++events_[DISPATCHED];
+        ++events_[FORWARD_A_NONE + forward_index(top->debug_forward_a_ex)];
+        ++events_[FORWARD_B_NONE + forward_index(top->debug_forward_b_ex)];
+        ++dispatch_[rv64i::opcode(top->debug_instr_ex)][rv64i::funct3(top->debug_instr_ex)];
+    }
+
+    void clear() {
+        runs_ = 0;
+        std::memset(events_, 0, sizeof(events_));
+        std::memset(dispatch_, 0, sizeof(dispatch_));
+    }
+
+    void merge(const Counters& other) {
+        runs_ += other.runs_;
+        for (unsigned e = 0; e < NUM_EVENTS; ++e) {
+            events_[e] += other.events_[e];
+        }
+        for (unsigned op = 0; op < 128; ++op) {
+            for (unsigned f3 = 0; f3 < 8; ++f3) {
+                dispatch_[op][f3] += other.dispatch_[op][f3];
+            }
+        }
+    }
+
+    uint64_t runs() const { return runs_; }
+    uint64_t count(Event e) const { return events_[e]; }
+
+    void write(std::ostream& os) const {
+        os << "# pipeline event counters\n"
+           << "runs " << runs_ << '\n';
+        for (unsigned e = 0; e < NUM_EVENTS; ++e) {
+            os << EVENT_NAMES[e] << ' ' << events_[e] << '\n';
+        }
+        for (unsigned op = 0; op < 128; ++op) {
+            const std::string name = dispatch_name(static_cast<uint8_t>(op));
+            if (!has_funct3(static_cast<uint8_t>(op))) {
+                uint64_t total = 0;
+                for (unsigned f3 = 0; f3 < 8; ++f3) {
+                    total += dispatch_[op][f3];
+                }
+                if (total) {
+                    os << name << ' ' << total << '\n';
+                }
+                continue;
+            }
+            for (unsigned f3 = 0; f3 < 8; ++f3) {
+                if (dispatch_[op][f3]) {
+                    os << name << ".funct3_" << f3 << ' ' << dispatch_[op][f3] << '\n';
+                }
+            }
+        }
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream file(path, std::ios::out | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "ERROR: Could not open event report for writing: " << path << std::endl;
+            return false;
+        }
+        write(file);
+        return true;
+    }
+
+    // Adds the counts of a report written by write().
+    bool read(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "ERROR: Could not open event report: " << path << std::endl;
+            return false;
+        }
+        Counters report;
+        report.clear();
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line)) {
+            ++line_number;
+            std::istringstream ss(line);
+            std::string name;
+            uint64_t value = 0;
+            if (!(ss >> name) || name[0] == '#') {
+                continue;
+            }
+            if (!(ss >> value) || !report.add(name, value)) {
+                std::cerr << "ERROR: " << path << ":" << line_number << ": unrecognized line: " << line << std::endl;
+                return false;
+            }
+        }
+        merge(report);
+        return true;
+    }
+
+    // Checkpoint contents (tb_checkpoint.h); Stream is a VerilatedSave or
+    // VerilatedRestore, so this header does not depend on them.
+    template <typename Stream>
+    void save(Stream& os) const {
+        os << runs_;
+        for (uint64_t count : events_) {
+            os << count;
+        }
+        for (const auto& per_opcode : dispatch_) {
+            for (uint64_t count : per_opcode) {
+                os << count;
+            }
+        }
+    }
+
+    template <typename Stream>
+    void restore(Stream& is) {
+        is >> runs_;
+        for (uint64_t& count : events_) {
+            is >> count;
+        }
+        for (auto& per_opcode : dispatch_) {
+            for (uint64_t& count : per_opcode) {
+                is >> count;
+            }
+        }
+    }
+
+    // One line for the end of a testbench log.
+    std::string summary() const {
+        std::ostringstream ss;
+        ss << "EVENTS: dispatched " << events_[DISPATCHED] << " in " << events_[CYCLES] << " cycles, forward_a "
+           << events_[FORWARD_A_NONE] << "/" << events_[FORWARD_A_WB] << "/" << events_[FORWARD_A_MEM]
+           << ", forward_b " << events_[FORWARD_B_NONE] << "/" << events_[FORWARD_B_WB] << "/"
+           << events_[FORWARD_B_MEM] << " (regfile/wb/mem), load-use stalls " << events_[STALL_LOAD_USE]
+           << ", flushes " << events_[FLUSH_DECODE] << " decode/" << events_[FLUSH_EXECUTE] << " execute";
+        return ss.str();
+    }
+
+private:
+    // 2'b11 is never produced; count it as no forwarding.
+    static unsigned forward_index(unsigned forward) {
+        forward &= 3;
+        return forward == 3 ? 0 : forward;
+    }
+
+    static std::string dispatch_name(uint8_t op) {
+        const char* name = opcode_name(op);
+        if (name) {
+            return std::string("dispatch.") + name;
+        }
+        std::ostringstream ss;
+        ss << "dispatch.0x" << std::hex << static_cast<unsigned>(op);
+        return ss.str();
+    }
+
+    bool add(const std::string& name, uint64_t value) {
+        if (name == "runs") {
+            runs_ += value;
+            return true;
+        }
+        for (unsigned e = 0; e < NUM_EVENTS; ++e) {
+            if (name == EVENT_NAMES[e]) {
+                events_[e] += value;
+                return true;
+            }
+        }
+        for (unsigned op = 0; op < 128; ++op) {
+            const std::string base = dispatch_name(static_cast<uint8_t>(op));
+            if (name.compare(0, base.size(), base) != 0) {
+                continue;
+            }
+            const std::string rest = name.substr(base.size());
+            if (rest.empty() && !has_funct3(static_cast<uint8_t>(op))) {
+                dispatch_[op][0] += value;
+                return true;
+            }
+            if (rest.size() == 9 && rest.compare(0, 8, ".funct3_") == 0 && rest[8] >= '0' && rest[8] <= '7') {
+                dispatch_[op][rest[8] - '0'] += value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t runs_ = 1;
+    uint64_t events_[NUM_EVENTS] = {};
+    uint64_t dispatch_[128][8] = {};
+};
+
+} // namespace pipeline_events
+
+#endif // PIPELINE_EVENTS_H
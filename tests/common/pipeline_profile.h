@@ -0,0 +1,367 @@
+// tests/common/pipeline_profile.h
+#ifndef PIPELINE_PROFILE_H
+#define PIPELINE_PROFILE_H
+
+#include "elf_loader.h"
+#include "rv64i_isa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Exact (not sampled) profile of a pipeline run, driven by the retire port.
+// Each retirement is charged the cycles since the previous one, so a stall or
+// flush lands on the instruction that was waiting for it to drain and the
+// per-PC cycles add up to the cycles profiled. From that come
+//   - a flat profile: cycles, retired and CPI per static PC, hottest first,
+//     with <symbol>+<offset> from the ELF symbol table,
+//   - the same per function (the nearest code symbol at or below the PC;
+//     hand-written tests have no .size/.type, so every label counts),
+//   - the dynamic instruction mix by mnemonic (opcode/funct3/funct7[5]),
+//   - folded stacks ("main;foo;bar <cycles>") for flamegraph.pl, speedscope
+//     or inferno. The call stack is a shadow of the RISC-V call hints: a
+//     jal/jalr writing ra or t0 pushes the caller, a jalr x0 through ra or
+//     t0 pops it.
+// retire() runs once per instruction, so it only does array and hash-table
+// updates on symbol indices and instruction fields; names and mnemonics are
+// looked up when a report is written.
+
+namespace pipeline_profile {
+
+// Code symbols of an ELF, for PC -> name lookups.
+class Symbolizer {
+public:
+    // Keeps function and untyped symbols inside executable segments; at equal
+    // addresses a function symbol beats a plain label.
+    void load(const std::vector<ElfSymbol>& symbols, const ElfImage& image) {
+        symbols_.clear();
+        for (const ElfSymbol& s : symbols) {
+            if ((s.type == STT_FUNC || s.type == STT_NOTYPE) && executable(image, s.value)) {
+                symbols_.push_back(s);
+            }
+        }
+        std::stable_sort(symbols_.begin(), symbols_.end(), [](const ElfSymbol& a, const ElfSymbol& b) {
+            if (a.value != b.value) {
+                return a.value < b.value;
+            }
+            return (a.type == STT_FUNC) > (b.type == STT_FUNC);
+        });
+        symbols_.erase(std::unique(symbols_.begin(), symbols_.end(),
+                                   [](const ElfSymbol& a, const ElfSymbol& b) { return a.value == b.value; }),
+                       symbols_.end());
+    }
+
+    static constexpr uint32_t NO_SYMBOL = ~0u;
+
+    bool empty() const { return symbols_.empty(); }
+    size_t size() const { return symbols_.size(); }
+
+    // Index of the nearest code symbol at or below pc; NO_SYMBOL below the
+    // first one.
+    uint32_t index(uint64_t pc) const {
+        auto it = std::upper_bound(symbols_.begin(), symbols_.end(), pc,
+                                   [](uint64_t value, const ElfSymbol& s) { return value < s.value; });
+        return it == symbols_.begin() ? NO_SYMBOL : static_cast<uint32_t>(it - symbols_.begin() - 1);
+    }
+
+    const ElfSymbol* find(uint64_t pc) const {
+        const uint32_t i = index(pc);
+        return i == NO_SYMBOL ? nullptr : &symbols_[i];
+    }
+
+    // Function name for the per-function table and the folded stacks.
+    const std::string& name(uint32_t index) const {
+        static const std::string unknown = "??";
+        return index == NO_SYMBOL ? unknown : symbols_[index].name;
+    }
+
+    // "<symbol>+0x<offset>", or "??" without a symbol.
+    std::string location(uint64_t pc) const {
+        const ElfSymbol* s = find(pc);
+        if (!s) {
+            return "??";
+        }
+        std::ostringstream ss;
+        ss << s->name << "+0x" << std::hex << (pc - s->value);
+        return ss.str();
+    }
+
+private:
+    static bool executable(const ElfImage& image, uint64_t addr) {
+        for (const ElfSegment& seg : image.segments) {
+            if ((seg.flags & PF_X) && addr >= seg.vaddr && addr < seg.vaddr + seg.bytes.size()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<ElfSymbol> symbols_;
+};
+
+class Profiler {
+public:
+    explicit Profiler(const Symbolizer& symbols) : symbols_(symbols) {}
+
+    // Call once per cycle, after the clock edge.
+    template <typename Model>
+    void sample(const Model* top) {
+        ++cycles_;
+        ++pending_cycles_;
+        if (top->rvfi_valid) {
+            retire(top->rvfi_pc_rdata, top->rvfi_insn);
+        }
+    }
+
+    void retire(uint64_t pc, uint32_t instr) {
+        PcStats& stats = per_pc_[pc];
+        if (stats.retired == 0) {
+            stats.instr = instr;
+            stats.symbol = symbols_.index(pc);
+        }
+        ++stats.retired;
+        stats.cycles += pending_cycles_;
+        ++mix_[mix_key(instr)];
+
+        const uint32_t leaf = stack_node(call_stack_.empty() ? ROOT : call_stack_.back(), stats.symbol);
+        stacks_[leaf].cycles += pending_cycles_;
+
+        ++retired_;
+        pending_cycles_ = 0;
+        track_call(leaf, instr);
+    }
+
+    uint64_t cycles() const { return cycles_; }
+    uint64_t retired() const { return retired_; }
+
+    // One line for the end of a testbench log.
+    std::string summary() const {
+        std::ostringstream ss;
+        const std::vector<Row> hot = functions();
+        ss << "PROFILE: " << cycles_ << " cycles, " << retired_ << " retired, " << per_pc_.size() << " static PCs, "
+           << hot.size() << " functions";
+        if (!hot.empty()) {
+            ss << ", hottest " << hot.front().name << " (" << std::fixed << std::setprecision(1)
+               << percent(hot.front().cycles) << "%)";
+        }
+        return ss.str();
+    }
+
+    // Flat profile, per-function table and instruction mix.
+    void write_report(std::ostream& os) const {
+        os << "# Profile\n"
+           << "cycles " << cycles_ << '\n'
+           << "retired " << retired_ << '\n'
+           << "cpi " << std::fixed << std::setprecision(3) << cpi(cycles_, retired_) << '\n';
+        if (pending_cycles_) {
+            os << "unattributed " << pending_cycles_ << " (after the last retirement)\n";
+        }
+
+        std::vector<std::pair<uint64_t, const PcStats*>> pcs;
+        for (const auto& entry : per_pc_) {
+            pcs.emplace_back(entry.first, &entry.second);
+        }
+        std::sort(pcs.begin(), pcs.end(), [](const auto& a, const auto& b) {
+            return a.second->cycles != b.second->cycles ? a.second->cycles > b.second->cycles : a.first < b.first;
+        });
+        os << "\n# flat: pc cycles % retired cpi location instr\n";
+        for (const auto& entry : pcs) {
+            const PcStats& s = *entry.second;
+            os << "0x" << std::hex << std::setw(8) << std::setfill('0') << entry.first << std::dec << std::setfill(' ')
+               << ' ' << s.cycles << ' ' << std::setprecision(1) << percent(s.cycles) << ' ' << s.retired << ' '
+               << std::setprecision(3) << cpi(s.cycles, s.retired) << ' ' << symbols_.location(entry.first) << ' '
+               << rv64i::mnemonic(s.instr) << '\n';
+        }
+
+        os << "\n# per function: name cycles % retired cpi\n";
+        for (const Row& row : functions()) {
+            os << row.name << ' ' << row.cycles << ' ' << std::setprecision(1) << percent(row.cycles) << ' '
+               << row.retired << ' ' << std::setprecision(3) << cpi(row.cycles, row.retired) << '\n';
+        }
+
+        std::map<std::string, uint64_t> by_mnemonic; // LUI/AUIPC/JAL keys differ in immediate bits only
+        for (uint32_t key = 0; key < MIX_KEYS; ++key) {
+            if (mix_[key]) {
+                by_mnemonic[rv64i::mnemonic(mix_instr(key))] += mix_[key];
+            }
+        }
+        std::vector<std::pair<std::string, uint64_t>> mix(by_mnemonic.begin(), by_mnemonic.end());
+        std::sort(mix.begin(), mix.end(), [](const auto& a, const auto& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        os << "\n# instruction mix: mnemonic retired %\n";
+        for (const auto& entry : mix) {
+            os << entry.first << ' ' << entry.second << ' ' << std::setprecision(1)
+               << (retired_ ? 100.0 * entry.second / retired_ : 0.0) << '\n';
+        }
+    }
+
+    // One "frame;frame;leaf <cycles>" line per distinct stack, sorted.
+    void write_folded(std::ostream& os) const {
+        std::vector<std::pair<std::string, uint64_t>> lines;
+        for (uint32_t node = ROOT + 1; node < stacks_.size(); ++node) {
+            if (stacks_[node].cycles) {
+                lines.emplace_back(stack_name(node), stacks_[node].cycles);
+            }
+        }
+        std::sort(lines.begin(), lines.end());
+        for (const auto& line : lines) {
+            os << line.first << ' ' << line.second << '\n';
+        }
+    }
+
+    // <prefix>.txt gets the report, <prefix>.folded the folded stacks.
+    bool write(const std::string& prefix) const {
+        std::ofstream report(prefix + ".txt", std::ios::out | std::ios::trunc);
+        std::ofstream folded(prefix + ".folded", std::ios::out | std::ios::trunc);
+        if (!report.is_open() || !folded.is_open()) {
+            std::cerr << "ERROR: Could not open profile output for writing: " << prefix << ".{txt,folded}" << std::endl;
+            return false;
+        }
+        write_report(report);
+        write_folded(folded);
+        return true;
+    }
+
+private:
+    // Deeper than any test program recurses; keeps a runaway push from growing
+    // without bound when a program never returns.
+    static constexpr size_t MAX_STACK_DEPTH = 256;
+
+    struct PcStats {
+        uint64_t cycles = 0;
+        uint64_t retired = 0;
+        uint32_t instr = 0;
+        uint32_t symbol = Symbolizer::NO_SYMBOL;
+    };
+
+    // A call stack, interned as a path of symbol indices: node = (caller
+    // stack, function). Node 0 is the empty stack above the outermost frame.
+    struct StackNode {
+        uint32_t parent = 0;
+        uint32_t symbol = Symbolizer::NO_SYMBOL;
+        uint64_t cycles = 0;
+    };
+    static constexpr uint32_t ROOT = 0;
+
+    // Instruction mix slots: opcode, funct3 and funct7[5] decide the
+    // mnemonic, except ebreak, which is ecall with imm 1.
+    static constexpr uint32_t MIX_KEYS = (128 << 4) + 1;
+    static constexpr uint32_t MIX_EBREAK = MIX_KEYS - 1;
+
+    static uint32_t mix_key(uint32_t instr) {
+        if (instr == rv64i::INSTR_EBREAK) {
+            return MIX_EBREAK;
+        }
+        return (static_cast<uint32_t>(rv64i::opcode(instr)) << 4) | (static_cast<uint32_t>(rv64i::funct3(instr)) << 1) |
+               ((rv64i::funct7(instr) >> 5) & 1);
+    }
+
+    // An instruction with the fields of a mix slot, for rv64i::mnemonic().
+    static uint32_t mix_instr(uint32_t key) {
+        if (key == MIX_EBREAK) {
+            return rv64i::INSTR_EBREAK;
+        }
+        return (key >> 4) | (((key >> 1) & 7) << 12) | ((key & 1) << 30);
+    }
+
+    struct Row {
+        std::string name;
+        uint64_t    cycles = 0;
+        uint64_t    retired = 0;
+    };
+
+    static bool link_register(uint8_t reg) { return reg == 1 || reg == 5; } // ra, t0
+
+    static double cpi(uint64_t cycles, uint64_t retired) {
+        return retired ? static_cast<double>(cycles) / retired : 0.0;
+    }
+
+    double percent(uint64_t cycles) const { return cycles_ ? 100.0 * cycles / cycles_ : 0.0; }
+
+    uint32_t stack_node(uint32_t parent, uint32_t symbol) {
+        const uint64_t key = (static_cast<uint64_t>(parent) << 32) | symbol;
+        auto it = stack_nodes_.find(key);
+        if (it != stack_nodes_.end()) {
+            return it->second;
+        }
+        const uint32_t node = static_cast<uint32_t>(stacks_.size());
+        stacks_.push_back({parent, symbol, 0});
+        stack_nodes_.emplace(key, node);
+        return node;
+    }
+
+    std::string stack_name(uint32_t node) const {
+        std::vector<uint32_t> path;
+        for (; node != ROOT; node = stacks_[node].parent) {
+            path.push_back(stacks_[node].symbol);
+        }
+        std::string name;
+        for (auto it = path.rbegin(); it != path.rend(); ++it) {
+            if (!name.empty()) {
+                name += ';';
+            }
+            name += symbols_.name(*it);
+        }
+        return name;
+    }
+
+    // `leaf` is the stack the instruction retired in; a call makes it the
+    // caller of what follows.
+    void track_call(uint32_t leaf, uint32_t instr) {
+        const uint8_t op = rv64i::opcode(instr);
+        if (op != rv64i::OPCODE_JAL && op != rv64i::OPCODE_JALR) {
+            return;
+        }
+        if (link_register(rv64i::rd(instr))) {
+            if (call_stack_.size() < MAX_STACK_DEPTH) {
+                call_stack_.push_back(leaf);
+            }
+        } else if (op == rv64i::OPCODE_JALR && rv64i::rd(instr) == 0 && link_register(rv64i::rs1(instr)) &&
+                   !call_stack_.empty()) {
+            call_stack_.pop_back();
+        }
+    }
+
+    std::vector<Row> functions() const {
+        std::vector<Row> by_symbol(symbols_.size() + 1); // Last: no symbol
+        for (const auto& entry : per_pc_) {
+            const uint32_t symbol = entry.second.symbol;
+            Row& row = by_symbol[symbol == Symbolizer::NO_SYMBOL ? symbols_.size() : symbol];
+            row.cycles += entry.second.cycles;
+            row.retired += entry.second.retired;
+        }
+        std::vector<Row> rows;
+        for (size_t i = 0; i < by_symbol.size(); ++i) {
+            if (by_symbol[i].retired) {
+                by_symbol[i].name = symbols_.name(i < symbols_.size() ? static_cast<uint32_t>(i) : Symbolizer::NO_SYMBOL);
+                rows.push_back(by_symbol[i]);
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            return a.cycles != b.cycles ? a.cycles > b.cycles : a.name < b.name;
+        });
+        return rows;
+    }
+
+    const Symbolizer& symbols_;
+    uint64_t cycles_ = 0;
+    uint64_t retired_ = 0;
+    uint64_t pending_cycles_ = 0; // Since the last retirement
+    std::unordered_map<uint64_t, PcStats>  per_pc_;
+    std::vector<uint64_t>                  mix_ = std::vector<uint64_t>(MIX_KEYS);
+    std::vector<StackNode>                 stacks_ = std::vector<StackNode>(1); // ROOT
+    std::unordered_map<uint64_t, uint32_t> stack_nodes_; // (parent, symbol) -> node
+    std::vector<uint32_t>                  call_stack_;   // Caller stacks, innermost last
+};
+
+} // namespace pipeline_profile
+
+#endif // PIPELINE_PROFILE_H
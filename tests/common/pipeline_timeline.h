@@ -0,0 +1,273 @@
+// tests/common/pipeline_timeline.h
+#ifndef PIPELINE_TIMELINE_H
+#define PIPELINE_TIMELINE_H
+
+#include "pipeline_events.h"
+#include "rv64i_isa.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Per-instruction pipeline timeline for pipeline viewers. Every cycle the
+// testbench takes a Sample of the fetch-order tag (`seq`) in each stage plus
+// the hazard unit's stall/flush outputs; a Writer follows each instruction
+// from IF to WB and writes either
+//   - Kanata 0004, the native log format of the Konata viewer: one
+//     instruction per row, with a hover note for every load-use stall cycle
+//     and a flush marker for squashed wrong-path instructions, or
+//   - gem5 O3PipeView lines (fetch/decode/rename/dispatch/issue/complete/
+//     retire), which Konata and gem5's o3-pipeview.py both read. The five
+//     stages map to fetch=IF, decode=rename=ID, dispatch=issue=EX,
+//     complete=MEM and retire=end of WB; ticks are cycles * O3_TICKS_PER_CYCLE
+//     and a squashed instruction has retire tick 0.
+// Samples are plain structs, so the Writer can run on an AsyncTraceSink
+// thread.
+
+namespace pipeline_timeline {
+
+enum Stage : unsigned { IF, ID, EX, MEM, WB, NUM_STAGES };
+
+const char* const STAGE_NAMES[NUM_STAGES] = {"IF", "ID", "EX", "MEM", "WB"};
+
+enum class Format { KONATA, O3PIPEVIEW };
+
+constexpr uint64_t O3_TICKS_PER_CYCLE = 1000;
+
+// Pipeline state right after one clock edge.
+struct Sample {
+    uint64_t cycle;
+    uint64_t seq[NUM_STAGES];
+    uint64_t pc_f;
+    uint32_t instr_f;
+    uint8_t  valid;     // Bit per Stage
+    uint8_t  stall;     // Load-use stall: IF and ID hold
+    uint8_t  flush;     // Taken branch/jump: IF and ID are squashed
+};
+
+template <typename Model>
+Sample sample_from_model(const Model* top, uint64_t cycle) {
+    Sample s;
+    s.cycle = cycle;
+    s.seq[IF] = top->debug_seq_f;
+    s.seq[ID] = top->debug_seq_d;
+    s.seq[EX] = top->debug_seq_ex;
+    s.seq[MEM] = top->debug_seq_mem;
+    s.seq[WB] = top->debug_seq_wb;
+    s.pc_f = top->debug_pc_f;
+    s.instr_f = top->debug_instr_f;
+    s.valid = static_cast<uint8_t>((1u << IF) | (top->debug_valid_d ? 1u << ID : 0) |
+                                   (top->debug_valid_ex ? 1u << EX : 0) | (top->debug_valid_mem ? 1u << MEM : 0) |
+                                   (top->rvfi_valid ? 1u << WB : 0));
+    s.stall = top->debug_stall_f;
+    s.flush = top->debug_flush_d;
+    return s;
+}
+
+// "<OPCODE> 0x<word>"; the core has no disassembler. No ':' because
+// O3PipeView fields are colon-separated.
+inline std::string describe(uint32_t instr, bool known) {
+    if (!known) {
+        return "(in flight when tracing started)";
+    }
+    const char* name = pipeline_events::opcode_name(rv64i::opcode(instr));
+    std::ostringstream ss;
+    ss << (name ? name : "???") << " 0x" << std::hex << std::setw(8) << std::setfill('0') << instr;
+    return ss.str();
+}
+
+class Writer {
+public:
+    bool open(const std::string& path, Format format) {
+        file_.open(path, std::ios::out | std::ios::trunc);
+        if (!file_.is_open()) {
+            std::cerr << "ERROR: Could not open pipeline timeline file for writing: " << path << std::endl;
+            return false;
+        }
+        format_ = format;
+        if (format_ == Format::KONATA) {
+            file_ << "Kanata\t0004\n";
+        }
+        return true;
+    }
+
+    bool is_open() const { return file_.is_open(); }
+
+    void consume(const Sample& s) {
+        if (format_ == Format::KONATA) {
+            if (!started_) {
+                file_ << "C=\t" << s.cycle << '\n';
+            } else if (s.cycle > cycle_) {
+                file_ << "C\t" << (s.cycle - cycle_) << '\n';
+            }
+        }
+        started_ = true;
+        cycle_ = s.cycle;
+        finish_pending(s.cycle);
+
+        for (unsigned stage = IF; stage < NUM_STAGES; ++stage) {
+            if (s.valid & (1u << stage)) {
+                advance(entry(s, static_cast<Stage>(stage)), static_cast<Stage>(stage), s.cycle);
+            }
+        }
+        if (s.stall) {
+            for (unsigned stage : {IF, ID}) {
+                if (s.valid & (1u << stage)) {
+                    note(inflight_.at(s.seq[stage]), "load-use stall at cycle " + std::to_string(s.cycle));
+                }
+            }
+        }
+        if (s.flush) {
+            for (unsigned stage : {IF, ID}) {
+                if (s.valid & (1u << stage)) {
+                    Entry& e = inflight_.at(s.seq[stage]);
+                    note(e, "flushed by a taken branch/jump at cycle " + std::to_string(s.cycle));
+                    pending_.push_back({s.seq[stage], true});
+                }
+            }
+        }
+        if (s.valid & (1u << WB)) {
+            pending_.push_back({s.seq[WB], false});
+        }
+    }
+
+    // Ends the instructions that left the pipeline in the last sampled cycle.
+    // Instructions still in flight are dropped.
+    void close() {
+        if (!file_.is_open()) {
+            return;
+        }
+        if (format_ == Format::KONATA && !pending_.empty()) {
+            file_ << "C\t1\n";
+        }
+        finish_pending(cycle_ + 1);
+        file_.close();
+    }
+
+    uint64_t retired() const { return retired_; }
+    uint64_t flushed() const { return flushed_; }
+
+private:
+    struct Entry {
+        uint64_t id = 0;        // Kanata id, dense from 0
+        uint64_t seq = 0;
+        uint64_t pc = 0;
+        uint32_t instr = 0;
+        bool     known = false; // Seen in IF, so pc/instr are valid
+        int      stage = -1;
+        uint64_t start[NUM_STAGES] = {};
+    };
+
+    struct Pending {
+        uint64_t seq;
+        bool     flushed;
+    };
+
+    Entry& entry(const Sample& s, Stage stage) {
+        auto it = inflight_.find(s.seq[stage]);
+        if (it != inflight_.end()) {
+            return it->second;
+        }
+        Entry& e = inflight_[s.seq[stage]];
+        e.id = next_id_++;
+        e.seq = s.seq[stage];
+        e.known = stage == IF;
+        e.pc = e.known ? s.pc_f : 0;
+        e.instr = e.known ? s.instr_f : 0;
+        if (format_ == Format::KONATA) {
+            file_ << "I\t" << e.id << '\t' << e.seq << "\t0\n"
+                  << "L\t" << e.id << "\t0\t" << std::hex << "0x" << std::setw(8) << std::setfill('0') << e.pc
+                  << std::dec << ' ' << describe(e.instr, e.known) << '\n';
+        }
+        return e;
+    }
+
+    void advance(Entry& e, Stage stage, uint64_t cycle) {
+        if (e.stage >= static_cast<int>(stage)) {
+            return; // Held by a stall
+        }
+        if (format_ == Format::KONATA) {
+            if (e.stage >= 0) {
+                file_ << "E\t" << e.id << "\t0\t" << STAGE_NAMES[e.stage] << '\n';
+            }
+            file_ << "S\t" << e.id << "\t0\t" << STAGE_NAMES[stage] << '\n';
+        }
+        for (int skipped = e.stage + 1; skipped <= static_cast<int>(stage); ++skipped) {
+            e.start[skipped] = cycle;
+        }
+        e.stage = static_cast<int>(stage);
+    }
+
+    void note(const Entry& e, const std::string& text) {
+        if (format_ == Format::KONATA) {
+            file_ << "L\t" << e.id << "\t1\t" << text << "; \n";
+        }
+    }
+
+    void finish_pending(uint64_t cycle) {
+        for (const Pending& p : pending_) {
+            auto it = inflight_.find(p.seq);
+            if (it == inflight_.end()) {
+                continue;
+            }
+            const Entry& e = it->second;
+            if (format_ == Format::KONATA) {
+                file_ << "E\t" << e.id << "\t0\t" << STAGE_NAMES[e.stage] << '\n'
+                      << "R\t" << e.id << '\t' << (p.flushed ? 0 : retired_) << '\t' << (p.flushed ? 1 : 0) << '\n';
+            } else {
+                write_o3(e, p.flushed ? 0 : cycle);
+            }
+            if (p.flushed) {
+                ++flushed_;
+            } else {
+                ++retired_;
+            }
+            inflight_.erase(it);
+        }
+        pending_.clear();
+    }
+
+    void write_o3(const Entry& e, uint64_t retire_cycle) {
+        auto tick = [&](Stage stage) { return e.stage >= static_cast<int>(stage) ? e.start[stage] * O3_TICKS_PER_CYCLE : 0; };
+        file_ << "O3PipeView:fetch:" << tick(IF) << ":0x" << std::hex << std::setw(16) << std::setfill('0') << e.pc
+              << std::dec << ":0:" << e.seq << ':' << describe(e.instr, e.known) << '\n'
+              << "O3PipeView:decode:" << tick(ID) << '\n'
+              << "O3PipeView:rename:" << tick(ID) << '\n'
+              << "O3PipeView:dispatch:" << tick(EX) << '\n'
+              << "O3PipeView:issue:" << tick(EX) << '\n'
+              << "O3PipeView:complete:" << tick(MEM) << '\n'
+              << "O3PipeView:retire:" << retire_cycle * O3_TICKS_PER_CYCLE << ":store:0\n";
+    }
+
+    std::ofstream  file_;
+    Format         format_ = Format::KONATA;
+    bool           started_ = false;
+    uint64_t       cycle_ = 0;
+    uint64_t       next_id_ = 0;
+    uint64_t       retired_ = 0;
+    uint64_t       flushed_ = 0;
+    std::map<uint64_t, Entry> inflight_;
+    std::vector<Pending>      pending_;
+};
+
+// +PIPEVIEW_FORMAT=konata (default) or o3. Returns false for anything else.
+inline bool parse_format(const std::string& name, Format& format) {
+    if (name.empty() || name == "konata" || name == "kanata") {
+        format = Format::KONATA;
+        return true;
+    }
+    if (name == "o3" || name == "o3pipeview") {
+        format = Format::O3PIPEVIEW;
+        return true;
+    }
+    return false;
+}
+
+} // namespace pipeline_timeline
+
+#endif // PIPELINE_TIMELINE_H
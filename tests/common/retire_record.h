@@ -0,0 +1,82 @@
+// tests/common/retire_record.h
+#ifndef RETIRE_RECORD_H
+#define RETIRE_RECORD_H
+
+#include "rv64i_isa.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// One retired instruction as seen by a checker: architectural effects only,
+// so RTL and ISS records can be compared field by field.
+struct RetireRecord {
+    uint64_t pc = 0;
+    uint32_t instr = 0;
+    bool     rd_write = false;  // rd != x0 was written
+    uint8_t  rd = 0;
+    uint64_t rd_value = 0;
+    bool     mem_write = false;
+    uint64_t mem_addr = 0;
+    uint64_t mem_wdata = 0;     // Masked to the store width
+};
+
+// Builds the record for the instruction in WB from the pipeline's rvfi_*
+// retirement port, which already zeroes rd = x0 and masks store data to the
+// access width. Only meaningful when top->rvfi_valid is set.
+template <typename Model>
+RetireRecord retire_record_from_model(const Model* top) {
+    RetireRecord r;
+    r.pc = top->rvfi_pc_rdata;
+    r.instr = top->rvfi_insn;
+    r.rd_write = top->rvfi_rd_addr != 0;
+    r.rd = top->rvfi_rd_addr;
+    r.rd_value = top->rvfi_rd_wdata;
+    r.mem_write = top->rvfi_mem_wmask != 0;
+    r.mem_addr = top->rvfi_mem_addr;
+    r.mem_wdata = top->rvfi_mem_wdata;
+    return r;
+}
+
+inline std::string format_retire_record(const RetireRecord& r) {
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0')
+       << "pc=0x" << std::setw(16) << r.pc << " instr=0x" << std::setw(8) << r.instr;
+    if (r.rd_write) {
+        ss << " x" << std::dec << static_cast<int>(r.rd) << std::hex << "=0x" << std::setw(16) << r.rd_value;
+    }
+    if (r.mem_write) {
+        ss << " mem[0x" << std::setw(16) << r.mem_addr << "]=0x" << std::setw(16) << r.mem_wdata;
+    }
+    return ss.str();
+}
+
+// CSR reads return counter values that depend on timing, which no reference
+// can predict. When one retires, the checker takes the RTL's value into the
+// reference record and must also write it into the reference's register, so
+// later instructions that use the value are still compared exactly. Returns
+// true when it did so (ref.rd then needs the update).
+inline bool adopt_csr_read(const RetireRecord& rtl, RetireRecord& ref) {
+    if (!rv64i::is_csr(ref.instr) || !ref.rd_write || !rtl.rd_write || rtl.rd != ref.rd) {
+        return false;
+    }
+    ref.rd_value = rtl.rd_value;
+    return true;
+}
+
+// Empty string when the records agree, otherwise a description of the first
+// differing field. CSR reads compare equal only after adopt_csr_read().
+inline std::string diff_retire_records(const RetireRecord& got, const RetireRecord& exp) {
+    if (got.pc != exp.pc) return "PC mismatch";
+    if (got.instr != exp.instr) return "instruction mismatch";
+    if (got.rd_write != exp.rd_write) return "register write enable mismatch";
+    if (got.rd_write && got.rd != exp.rd) return "destination register mismatch";
+    if (got.rd_write && got.rd_value != exp.rd_value) return "register value mismatch";
+    if (got.mem_write != exp.mem_write) return "store enable mismatch";
+    if (got.mem_write && got.mem_addr != exp.mem_addr) return "store address mismatch";
+    if (got.mem_write && got.mem_wdata != exp.mem_wdata) return "store data mismatch";
+    return "";
+}
+
+#endif // RETIRE_RECORD_H
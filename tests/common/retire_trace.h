@@ -0,0 +1,215 @@
+// tests/common/retire_trace.h
+#ifndef RETIRE_TRACE_H
+#define RETIRE_TRACE_H
+
+#include "retire_record.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Binary retirement trace: a fixed 32-byte header followed by fixed-size
+// little-endian records, so a reader can mmap the file and index any record
+// directly (no parsing, no per-line flush on the writer side).
+//
+// The header lists which fields the producer fills in. An RTL trace has all
+// of them; an ISS plugin that only sees register writes has RD only, and the
+// diff tool then compares just the fields both traces carry.
+
+namespace retire_trace {
+
+const char     kMagic[8] = {'R', 'V', 'R', 'E', 'T', 'I', 'R', 'E'};
+const uint16_t kVersion = 1;
+
+enum Field : uint32_t {
+    FIELD_CYCLE = 1u << 0,
+    FIELD_PC    = 1u << 1,
+    FIELD_INSTR = 1u << 2,
+    FIELD_RD    = 1u << 3,  // rd_write, rd, rd_value
+    FIELD_MEM   = 1u << 4,  // mem_write, mem_addr, mem_wdata
+    FIELD_ALL   = FIELD_CYCLE | FIELD_PC | FIELD_INSTR | FIELD_RD | FIELD_MEM,
+};
+
+enum RecordFlag : uint8_t {
+    FLAG_RD_WRITE  = 1u << 0,
+    FLAG_MEM_WRITE = 1u << 1,
+};
+
+struct Header {
+    char     magic[8];
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t fields;
+    uint64_t record_count;  // Patched on close; 0 means "derive from file size"
+    uint64_t reserved;
+};
+static_assert(sizeof(Header) == 32, "Trace header layout changed");
+
+struct Record {
+    uint64_t cycle;
+    uint64_t pc;
+    uint64_t rd_value;
+    uint64_t mem_addr;
+    uint64_t mem_wdata;
+    uint32_t instr;
+    uint8_t  rd;
+    uint8_t  flags;
+    uint16_t reserved;
+};
+static_assert(sizeof(Record) == 48, "Trace record layout changed");
+
+inline Record make_record(uint64_t cycle, const RetireRecord& r) {
+    Record rec{};
+    rec.cycle = cycle;
+    rec.pc = r.pc;
+    rec.instr = r.instr;
+    if (r.rd_write) {
+        rec.flags |= FLAG_RD_WRITE;
+        rec.rd = r.rd;
+        rec.rd_value = r.rd_value;
+    }
+    if (r.mem_write) {
+        rec.flags |= FLAG_MEM_WRITE;
+        rec.mem_addr = r.mem_addr;
+        rec.mem_wdata = r.mem_wdata;
+    }
+    return rec;
+}
+
+// Buffered writer; records are copied into a large buffer and written in bulk.
+class Writer {
+public:
+    ~Writer() { close(); }
+
+    bool open(const std::string& path, uint32_t fields) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            std::cerr << "ERROR: Could not open retire trace file: " << path << std::endl;
+            return false;
+        }
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.record_size = sizeof(Record);
+        header.fields = fields;
+        std::fwrite(&header, sizeof(header), 1, file_);
+        buffer_.reserve(kBufferRecords);
+        count_ = 0;
+        return true;
+    }
+
+    bool is_open() const { return file_ != nullptr; }
+
+    void write(const Record& rec) {
+        buffer_.push_back(rec);
+        if (buffer_.size() == kBufferRecords) {
+            flush();
+        }
+    }
+
+    void close() {
+        if (!file_) {
+            return;
+        }
+        flush();
+        std::fseek(file_, offsetof(Header, record_count), SEEK_SET);
+        std::fwrite(&count_, sizeof(count_), 1, file_);
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    static constexpr size_t kBufferRecords = 1 << 14;
+
+    void flush() {
+        if (!buffer_.empty()) {
+            std::fwrite(buffer_.data(), sizeof(Record), buffer_.size(), file_);
+            count_ += buffer_.size();
+            buffer_.clear();
+        }
+    }
+
+    std::FILE*          file_ = nullptr;
+    std::vector<Record> buffer_;
+    uint64_t            count_ = 0;
+};
+
+// Read-only mmap view of a trace file.
+class MappedTrace {
+public:
+    MappedTrace() = default;
+    MappedTrace(const MappedTrace&) = delete;
+    MappedTrace& operator=(const MappedTrace&) = delete;
+    ~MappedTrace() {
+        if (base_) munmap(base_, size_);
+    }
+
+    bool open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "ERROR: Could not open retire trace file: " << path << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            std::cerr << "ERROR: " << path << " is too small to be a retire trace." << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            std::cerr << "ERROR: Could not mmap retire trace file: " << path << std::endl;
+            return false;
+        }
+        base_ = addr;
+        madvise(base_, size_, MADV_SEQUENTIAL);
+
+        const Header* header = static_cast<const Header*>(base_);
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+            std::cerr << "ERROR: " << path << " is not a retire trace file." << std::endl;
+            return false;
+        }
+        if (header->version != kVersion || header->record_size != sizeof(Record)) {
+            std::cerr << "ERROR: " << path << " has unsupported trace version " << header->version
+                      << " (record size " << header->record_size << ")." << std::endl;
+            return false;
+        }
+        fields_ = header->fields;
+        records_ = reinterpret_cast<const Record*>(static_cast<const char*>(base_) + sizeof(Header));
+        const uint64_t available = (size_ - sizeof(Header)) / sizeof(Record);
+        count_ = header->record_count;
+        if (count_ == 0 || count_ > available) {
+            if (count_ > available) {
+                std::cerr << "WARNING: " << path << " is truncated; using " << available << " records." << std::endl;
+            }
+            count_ = available; // Writer did not finish; trust the file size
+        }
+        return true;
+    }
+
+    uint32_t fields() const { return fields_; }
+    uint64_t size() const { return count_; }
+    const Record& operator[](uint64_t i) const { return records_[i]; }
+
+private:
+    void*         base_ = nullptr;
+    size_t        size_ = 0;
+    const Record* records_ = nullptr;
+    uint64_t      count_ = 0;
+    uint32_t      fields_ = 0;
+};
+
+} // namespace retire_trace
+
+#endif // RETIRE_TRACE_H
@@ -0,0 +1,181 @@
+// tests/common/rv64i_isa.h
+#ifndef RV64I_ISA_H
+#define RV64I_ISA_H
+
+#include <cstdint>
+
+// C++ mirror of rtl/common/riscv_opcodes.svh plus field/immediate decoding,
+// for testbench-side checkers that need to interpret retired instructions.
+
+namespace rv64i {
+
+const uint8_t OPCODE_LUI      = 0b0110111;
+const uint8_t OPCODE_AUIPC    = 0b0010111;
+const uint8_t OPCODE_JAL      = 0b1101111;
+const uint8_t OPCODE_JALR     = 0b1100111;
+const uint8_t OPCODE_BRANCH   = 0b1100011;
+const uint8_t OPCODE_LOAD     = 0b0000011;
+const uint8_t OPCODE_STORE    = 0b0100011;
+const uint8_t OPCODE_OP_IMM   = 0b0010011;
+const uint8_t OPCODE_OP       = 0b0110011;
+const uint8_t OPCODE_MISC_MEM = 0b0001111;
+const uint8_t OPCODE_SYSTEM   = 0b1110011;
+
+const uint32_t INSTR_ECALL    = 0x00000073;
+const uint32_t INSTR_EBREAK   = 0x00100073;
+
+inline uint8_t opcode(uint32_t instr) { return instr & 0x7F; }
+inline uint8_t rd(uint32_t instr)     { return (instr >> 7) & 0x1F; }
+inline uint8_t funct3(uint32_t instr) { return (instr >> 12) & 0x7; }
+inline uint8_t rs1(uint32_t instr)    { return (instr >> 15) & 0x1F; }
+inline uint8_t rs2(uint32_t instr)    { return (instr >> 20) & 0x1F; }
+inline uint8_t funct7(uint32_t instr) { return (instr >> 25) & 0x7F; }
+
+inline int64_t sign_extend(uint64_t value, unsigned bits) {
+    const uint64_t m = 1ULL << (bits - 1);
+    value &= (bits == 64) ? ~0ULL : ((1ULL << bits) - 1);
+    return static_cast<int64_t>((value ^ m) - m);
+}
+
+inline int64_t imm_i(uint32_t instr) { return sign_extend(instr >> 20, 12); }
+inline int64_t imm_s(uint32_t instr) { return sign_extend(((instr >> 25) << 5) | ((instr >> 7) & 0x1F), 12); }
+inline int64_t imm_b(uint32_t instr) {
+    return sign_extend(((instr >> 31) << 12) | (((instr >> 7) & 1) << 11) |
+                       (((instr >> 25) & 0x3F) << 5) | (((instr >> 8) & 0xF) << 1), 13);
+}
+inline int64_t imm_u(uint32_t instr) { return sign_extend(instr & 0xFFFFF000u, 32); }
+inline int64_t imm_j(uint32_t instr) {
+    return sign_extend(((instr >> 31) << 20) | (((instr >> 12) & 0xFF) << 12) |
+                       (((instr >> 20) & 1) << 11) | (((instr >> 21) & 0x3FF) << 1), 21);
+}
+
+// Zicsr instruction (SYSTEM with funct3 other than 000/100); csr() is its address.
+inline bool is_csr(uint32_t instr) {
+    return opcode(instr) == OPCODE_SYSTEM && (funct3(instr) & 0x3) != 0;
+}
+inline uint16_t csr(uint32_t instr) { return instr >> 20; }
+
+// Counter CSRs of rtl/core/csr_file.sv (rtl/common/csr_defines.svh)
+const uint16_t CSR_MCYCLE        = 0xB00;
+const uint16_t CSR_MINSTRET      = 0xB02;
+const uint16_t CSR_MHPMCOUNTER3  = 0xB03;
+const uint16_t CSR_CYCLE         = 0xC00;
+const uint16_t CSR_INSTRET       = 0xC02;
+const uint16_t CSR_HPMCOUNTER3   = 0xC03;
+const uint16_t CSR_MCOUNTINHIBIT = 0x320;
+const uint16_t CSR_MHPMEVENT3    = 0x323;
+
+// Whether the instruction architecturally writes rd (x0 writes excluded).
+inline bool writes_rd(uint32_t instr) {
+    switch (opcode(instr)) {
+        case OPCODE_LUI: case OPCODE_AUIPC: case OPCODE_JAL: case OPCODE_JALR:
+        case OPCODE_LOAD: case OPCODE_OP_IMM: case OPCODE_OP:
+            return rd(instr) != 0;
+        case OPCODE_SYSTEM:
+            return is_csr(instr) && rd(instr) != 0;
+        default:
+            return false;
+    }
+}
+
+// Whether the instruction reads rs1/rs2, as execute.sv reports them on the
+// rvfi_rs* fields. csrrwi/csrrsi/csrrci use the rs1 field as an immediate.
+inline bool reads_rs1(uint32_t instr) {
+    switch (opcode(instr)) {
+        case OPCODE_JALR: case OPCODE_BRANCH: case OPCODE_LOAD: case OPCODE_STORE:
+        case OPCODE_OP_IMM: case OPCODE_OP:
+            return true;
+        case OPCODE_SYSTEM:
+            return is_csr(instr) && (funct3(instr) & 0x4) == 0;
+        default:
+            return false;
+    }
+}
+inline bool reads_rs2(uint32_t instr) {
+    const uint8_t op = opcode(instr);
+    return op == OPCODE_BRANCH || op == OPCODE_STORE || op == OPCODE_OP;
+}
+
+// Branch condition by funct3; false for the two unused encodings.
+inline bool branch_taken(uint8_t f3, uint64_t a, uint64_t b) {
+    switch (f3) {
+        case 0b000: return a == b;
+        case 0b001: return a != b;
+        case 0b100: return static_cast<int64_t>(a) < static_cast<int64_t>(b);
+        case 0b101: return static_cast<int64_t>(a) >= static_cast<int64_t>(b);
+        case 0b110: return a < b;
+        case 0b111: return a >= b;
+        default:    return false;
+    }
+}
+
+// Assembler mnemonic of the instructions the core decodes, from opcode,
+// funct3 and funct7[5]; "unknown" for anything else.
+inline const char* mnemonic(uint32_t instr) {
+    static const char* const BRANCH[8] = {"beq", "bne", "?", "?", "blt", "bge", "bltu", "bgeu"};
+    static const char* const LOAD[8]   = {"lb", "lh", "lw", "ld", "lbu", "lhu", "lwu", "?"};
+    static const char* const STORE[8]  = {"sb", "sh", "sw", "sd", "?", "?", "?", "?"};
+    static const char* const OP_IMM[8] = {"addi", "slli", "slti", "sltiu", "xori", "srli", "ori", "andi"};
+    static const char* const OP[8]     = {"add", "sll", "slt", "sltu", "xor", "srl", "or", "and"};
+    static const char* const SYSTEM[8] = {"ecall", "csrrw", "csrrs", "csrrc", "?", "csrrwi", "csrrsi", "csrrci"};
+    const uint8_t f3 = funct3(instr);
+    const bool alt = (funct7(instr) & 0x20) != 0;
+    const char* name = "?";
+    switch (opcode(instr)) {
+        case OPCODE_LUI:      name = "lui"; break;
+        case OPCODE_AUIPC:    name = "auipc"; break;
+        case OPCODE_JAL:      name = "jal"; break;
+        case OPCODE_JALR:     name = f3 == 0 ? "jalr" : "?"; break;
+        case OPCODE_BRANCH:   name = BRANCH[f3]; break;
+        case OPCODE_LOAD:     name = LOAD[f3]; break;
+        case OPCODE_STORE:    name = STORE[f3]; break;
+        case OPCODE_OP_IMM:   name = (f3 == 0b101 && alt) ? "srai" : OP_IMM[f3]; break;
+        case OPCODE_OP:       name = (f3 == 0b000 && alt) ? "sub" : (f3 == 0b101 && alt) ? "sra" : OP[f3]; break;
+        case OPCODE_MISC_MEM: name = "fence"; break;
+        case OPCODE_SYSTEM:   name = instr == INSTR_EBREAK ? "ebreak" : SYSTEM[f3]; break;
+        default: break;
+    }
+    return name[0] == '?' ? "unknown" : name;
+}
+
+// Access size in bytes for loads/stores (funct3[1:0]).
+inline unsigned mem_access_bytes(uint32_t instr) { return 1u << (funct3(instr) & 0x3); }
+
+inline uint64_t mask_to_bytes(uint64_t value, unsigned bytes) {
+    return bytes >= 8 ? value : (value & ((1ULL << (8 * bytes)) - 1));
+}
+
+// Encoders, the inverse of the field/immediate decoders above. Immediates are
+// truncated to their field width; callers keep them in range.
+inline uint32_t encode_r(uint8_t op, uint8_t rd, uint8_t f3, uint8_t rs1, uint8_t rs2, uint8_t f7) {
+    return (static_cast<uint32_t>(f7) << 25) | (static_cast<uint32_t>(rs2 & 0x1F) << 20) |
+           (static_cast<uint32_t>(rs1 & 0x1F) << 15) | (static_cast<uint32_t>(f3 & 0x7) << 12) |
+           (static_cast<uint32_t>(rd & 0x1F) << 7) | (op & 0x7F);
+}
+inline uint32_t encode_i(uint8_t op, uint8_t rd, uint8_t f3, uint8_t rs1, int64_t imm) {
+    return (static_cast<uint32_t>(imm & 0xFFF) << 20) | (static_cast<uint32_t>(rs1 & 0x1F) << 15) |
+           (static_cast<uint32_t>(f3 & 0x7) << 12) | (static_cast<uint32_t>(rd & 0x1F) << 7) | (op & 0x7F);
+}
+inline uint32_t encode_s(uint8_t op, uint8_t f3, uint8_t rs1, uint8_t rs2, int64_t imm) {
+    const uint32_t u = static_cast<uint32_t>(imm & 0xFFF);
+    return ((u >> 5) << 25) | (static_cast<uint32_t>(rs2 & 0x1F) << 20) | (static_cast<uint32_t>(rs1 & 0x1F) << 15) |
+           (static_cast<uint32_t>(f3 & 0x7) << 12) | ((u & 0x1F) << 7) | (op & 0x7F);
+}
+inline uint32_t encode_b(uint8_t f3, uint8_t rs1, uint8_t rs2, int64_t offset) {
+    const uint32_t u = static_cast<uint32_t>(offset & 0x1FFF);
+    return (((u >> 12) & 1) << 31) | (((u >> 5) & 0x3F) << 25) | (static_cast<uint32_t>(rs2 & 0x1F) << 20) |
+           (static_cast<uint32_t>(rs1 & 0x1F) << 15) | (static_cast<uint32_t>(f3 & 0x7) << 12) |
+           (((u >> 1) & 0xF) << 8) | (((u >> 11) & 1) << 7) | OPCODE_BRANCH;
+}
+inline uint32_t encode_u(uint8_t op, uint8_t rd, int64_t imm) {
+    return (static_cast<uint32_t>(imm) & 0xFFFFF000u) | (static_cast<uint32_t>(rd & 0x1F) << 7) | (op & 0x7F);
+}
+inline uint32_t encode_j(uint8_t rd, int64_t offset) {
+    const uint32_t u = static_cast<uint32_t>(offset & 0x1FFFFF);
+    return (((u >> 20) & 1) << 31) | (((u >> 1) & 0x3FF) << 21) | (((u >> 11) & 1) << 20) |
+           (((u >> 12) & 0xFF) << 12) | (static_cast<uint32_t>(rd & 0x1F) << 7) | OPCODE_JAL;
+}
+
+} // namespace rv64i
+
+#endif // RV64I_ISA_H
@@ -0,0 +1,185 @@
+// tests/common/rv64i_model.h
+#ifndef RV64I_MODEL_H
+#define RV64I_MODEL_H
+
+#include "elf_loader.h"
+#include "rv64i_isa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace rv64i {
+
+// Instruction-at-a-time functional model of the pipeline's architectural
+// state, used to fast-forward through program prefixes that are not worth
+// cycle-level simulation. It mirrors the RTL memory system rather than a
+// generic RV64I machine: a word-addressed instruction ROM that reads NOPs
+// outside the program, and a small byte-addressed data memory where
+// out-of-range loads read 0 and out-of-range stores are dropped.
+class FunctionalModel {
+public:
+    static constexpr uint32_t NOP = 0x00000013; // addi x0, x0, 0
+
+    FunctionalModel(uint64_t imem_words, uint64_t dmem_bytes) : imem_(imem_words, NOP), dmem_(dmem_bytes, 0) {}
+
+    // Same placement rules as backdoor_load_instr_mem()/backdoor_load_data_mem().
+    bool load(const ElfImage& image) {
+        for (const ElfSegment& segment : image.segments) {
+            const bool fits_dmem = segment.vaddr + segment.bytes.size() <= dmem_.size();
+            if (segment.flags & PF_X) {
+                if (segment.vaddr % 4 != 0 || segment.vaddr + segment.bytes.size() > imem_.size() * 4) {
+                    std::cerr << "ERROR: Executable segment at 0x" << std::hex << segment.vaddr << std::dec
+                              << " does not fit instruction memory." << std::endl;
+                    return false;
+                }
+                for (uint64_t offset = 0; offset < segment.bytes.size(); offset += 4) {
+                    uint32_t word = 0;
+                    for (uint64_t b = 0; b < 4 && offset + b < segment.bytes.size(); ++b) {
+                        word |= static_cast<uint32_t>(segment.bytes[offset + b]) << (8 * b);
+                    }
+                    imem_[(segment.vaddr + offset) / 4] = word;
+                }
+            } else if (!fits_dmem) {
+                std::cerr << "ERROR: Data segment at 0x" << std::hex << segment.vaddr << std::dec
+                          << " is outside data memory." << std::endl;
+                return false;
+            }
+            if (fits_dmem) {
+                std::copy(segment.bytes.begin(), segment.bytes.end(), dmem_.begin() + segment.vaddr);
+            }
+        }
+        pc = image.entry;
+        return true;
+    }
+
+    uint32_t fetch(uint64_t addr) const {
+        const uint64_t index = addr / 4;
+        return index < imem_.size() ? imem_[index] : NOP;
+    }
+
+    // Executes the instruction at pc. Returns false without executing it when
+    // it is ecall/ebreak, which ends the program.
+    bool step() {
+        const uint32_t instr = fetch(pc);
+        const uint64_t rs1_value = regs[rs1(instr)];
+        const uint64_t rs2_value = regs[rs2(instr)];
+        uint64_t next_pc = pc + 4;
+        uint64_t result = 0;
+
+        switch (opcode(instr)) {
+            case OPCODE_LUI:   result = static_cast<uint64_t>(imm_u(instr)); break;
+            case OPCODE_AUIPC: result = pc + static_cast<uint64_t>(imm_u(instr)); break;
+            case OPCODE_JAL:
+                result = pc + 4;
+                next_pc = pc + static_cast<uint64_t>(imm_j(instr));
+                break;
+            case OPCODE_JALR:
+                result = pc + 4;
+                next_pc = (rs1_value + static_cast<uint64_t>(imm_i(instr))) & ~1ULL;
+                break;
+            case OPCODE_BRANCH:
+                if (branch_taken(funct3(instr), rs1_value, rs2_value)) {
+                    next_pc = pc + static_cast<uint64_t>(imm_b(instr));
+                }
+                break;
+            case OPCODE_LOAD:
+                result = load(rs1_value + static_cast<uint64_t>(imm_i(instr)), funct3(instr));
+                break;
+            case OPCODE_STORE:
+                store(rs1_value + static_cast<uint64_t>(imm_s(instr)), rs2_value, mem_access_bytes(instr));
+                break;
+            case OPCODE_OP_IMM: result = alu(instr, rs1_value, static_cast<uint64_t>(imm_i(instr)), true); break;
+            case OPCODE_OP:     result = alu(instr, rs1_value, rs2_value, false); break;
+            case OPCODE_SYSTEM:
+                if (!is_csr(instr)) {
+                    return false;
+                }
+                result = csr_read(csr(instr));
+                break;
+            default: break; // FENCE and unknown opcodes retire as NOPs, as in the RTL
+        }
+        if (writes_rd(instr)) {
+            regs[rd(instr)] = result;
+        }
+        pc = next_pc;
+        ++retired;
+        return true;
+    }
+
+    void set_reg(uint8_t index, uint64_t value) {
+        if (index != 0) {
+            regs[index] = value;
+        }
+    }
+
+    // Replaces one instruction word, e.g. to patch a program while running it.
+    void set_instr(uint64_t addr, uint32_t word) {
+        if (addr / 4 < imem_.size()) {
+            imem_[addr / 4] = word;
+        }
+    }
+
+    const std::vector<uint8_t>& dmem() const { return dmem_; }
+
+    uint64_t pc = 0;
+    uint64_t regs[32] = {};
+    uint64_t retired = 0;
+
+private:
+    // The model has no timing: cycle and instret both read the instruction
+    // count, the other counters read 0, and CSR writes are dropped. Checkers
+    // comparing against the RTL overwrite rd with the RTL's value instead
+    // (adopt_csr_read() in retire_record.h, then set_reg()).
+    uint64_t csr_read(uint16_t address) const {
+        switch (address) {
+            case CSR_MCYCLE: case CSR_CYCLE: case CSR_MINSTRET: case CSR_INSTRET:
+                return retired;
+            default:
+                return 0;
+        }
+    }
+
+    static uint64_t alu(uint32_t instr, uint64_t a, uint64_t b, bool immediate) {
+        const bool alt = (funct7(instr) & 0x20) != 0;
+        const unsigned shamt = b & 0x3F;
+        switch (funct3(instr)) {
+            case 0b000: return (!immediate && alt) ? a - b : a + b;
+            case 0b001: return a << shamt;
+            case 0b010: return static_cast<int64_t>(a) < static_cast<int64_t>(b);
+            case 0b011: return a < b;
+            case 0b100: return a ^ b;
+            case 0b101: return alt ? static_cast<uint64_t>(static_cast<int64_t>(a) >> shamt) : a >> shamt;
+            case 0b110: return a | b;
+            default:    return a & b;
+        }
+    }
+
+    uint64_t load(uint64_t addr, uint8_t f3) const {
+        const unsigned bytes = 1u << (f3 & 0x3);
+        uint64_t value = 0;
+        for (unsigned i = 0; i < bytes; ++i) {
+            const uint64_t a = addr + i;
+            value |= static_cast<uint64_t>(a < dmem_.size() ? dmem_[a] : 0) << (8 * i);
+        }
+        const bool is_unsigned = (f3 & 0x4) != 0;
+        return (is_unsigned || bytes == 8) ? value : static_cast<uint64_t>(sign_extend(value, 8 * bytes));
+    }
+
+    void store(uint64_t addr, uint64_t value, unsigned bytes) {
+        if (addr + bytes > dmem_.size()) {
+            return;
+        }
+        for (unsigned i = 0; i < bytes; ++i) {
+            dmem_[addr + i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    std::vector<uint32_t> imem_;
+    std::vector<uint8_t>  dmem_;
+};
+
+} // namespace rv64i
+
+#endif // RV64I_MODEL_H
@@ -0,0 +1,193 @@
+// tests/common/rvfi_check.h
+#ifndef RVFI_CHECK_H
+#define RVFI_CHECK_H
+
+#include "rv64i_isa.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// Consistency checks on the rvfi_* retirement port (rtl/pipeline.sv) that
+// need no reference model, so they run on any program. They cover the fields
+// the retire records (retire_record.h) leave out:
+//   order   rvfi_order counts retirements from 0 without gaps
+//   pc      rvfi_pc_rdata is the previous retirement's rvfi_pc_wdata, and
+//           pc_wdata is the branch/jump target computed from the reported
+//           operands, or pc+4
+//   regs    rs1/rs2 carry the instruction's fields when it reads them and 0
+//           otherwise; their data is the last rvfi_rd_wdata written to that
+//           register (a shadow register file)
+//   memory  loads and stores report address rs1+imm and a mask of their
+//           access width, other instructions 0; a load's rdata has no bytes
+//           outside its mask, and its rd value is that data extended
+// Store data is compared by the record checkers. The shadow register file
+// starts from the registers the model was reset with (all 0 unless they were
+// loaded through backdoor_load_registers()).
+
+namespace rvfi_check {
+
+class Checker {
+public:
+    Checker() = default;
+    explicit Checker(const uint64_t (&regs)[32]) {
+        for (int i = 1; i < 32; ++i) {
+            regs_[i] = regs[i];
+        }
+    }
+
+    // Call once per cycle, after the clock edge. Returns an empty string, or a
+    // description of the first inconsistency in the instruction retiring now.
+    template <typename Model>
+    std::string check(const Model* top) {
+        if (!top->rvfi_valid) {
+            return "";
+        }
+        Retirement r;
+        r.order = top->rvfi_order;
+        r.insn = top->rvfi_insn;
+        r.pc_rdata = top->rvfi_pc_rdata;
+        r.pc_wdata = top->rvfi_pc_wdata;
+        r.rs1_addr = top->rvfi_rs1_addr;
+        r.rs2_addr = top->rvfi_rs2_addr;
+        r.rs1_rdata = top->rvfi_rs1_rdata;
+        r.rs2_rdata = top->rvfi_rs2_rdata;
+        r.rd_addr = top->rvfi_rd_addr;
+        r.rd_wdata = top->rvfi_rd_wdata;
+        r.mem_addr = top->rvfi_mem_addr;
+        r.mem_rmask = top->rvfi_mem_rmask;
+        r.mem_wmask = top->rvfi_mem_wmask;
+        r.mem_rdata = top->rvfi_mem_rdata;
+        return check_retirement(r);
+    }
+
+    uint64_t checked() const { return checked_; }
+
+    std::string summary() const {
+        std::ostringstream ss;
+        ss << "RVFI: " << checked_ << " retirements consistent (" << redirects_ << " taken branches/jumps, "
+           << loads_ << " loads, " << without_rs2_ << " without rs2)";
+        return ss.str();
+    }
+
+private:
+    struct Retirement {
+        uint64_t order = 0;
+        uint32_t insn = 0;
+        uint64_t pc_rdata = 0;
+        uint64_t pc_wdata = 0;
+        uint8_t  rs1_addr = 0;
+        uint8_t  rs2_addr = 0;
+        uint64_t rs1_rdata = 0;
+        uint64_t rs2_rdata = 0;
+        uint8_t  rd_addr = 0;
+        uint64_t rd_wdata = 0;
+        uint64_t mem_addr = 0;
+        uint8_t  mem_rmask = 0;
+        uint8_t  mem_wmask = 0;
+        uint64_t mem_rdata = 0;
+    };
+
+    std::string check_retirement(const Retirement& r) {
+        using namespace rv64i;
+        const uint32_t insn = r.insn;
+        const uint8_t op = opcode(insn);
+
+        if (r.order != checked_) {
+            return fail(r, "rvfi_order is " + std::to_string(r.order) + ", expected " + std::to_string(checked_));
+        }
+        if (checked_ > 0 && r.pc_rdata != next_pc_) {
+            return fail(r, "rvfi_pc_rdata is not the previous rvfi_pc_wdata " + hex(next_pc_));
+        }
+
+        const uint8_t rs1_addr = reads_rs1(insn) ? rs1(insn) : 0;
+        const uint8_t rs2_addr = reads_rs2(insn) ? rs2(insn) : 0;
+        if (r.rs1_addr != rs1_addr || r.rs2_addr != rs2_addr) {
+            return fail(r, "rvfi_rs1_addr/rvfi_rs2_addr are x" + std::to_string(r.rs1_addr) + "/x" +
+                               std::to_string(r.rs2_addr) + ", expected x" + std::to_string(rs1_addr) + "/x" +
+                               std::to_string(rs2_addr));
+        }
+        if (r.rs1_rdata != regs_[rs1_addr]) {
+            return fail(r, "rvfi_rs1_rdata " + hex(r.rs1_rdata) + " is not x" + std::to_string(rs1_addr) + " = " +
+                               hex(regs_[rs1_addr]));
+        }
+        if (r.rs2_rdata != regs_[rs2_addr]) {
+            return fail(r, "rvfi_rs2_rdata " + hex(r.rs2_rdata) + " is not x" + std::to_string(rs2_addr) + " = " +
+                               hex(regs_[rs2_addr]));
+        }
+
+        uint64_t pc_wdata = r.pc_rdata + 4;
+        if (op == OPCODE_JAL) {
+            pc_wdata = r.pc_rdata + static_cast<uint64_t>(imm_j(insn));
+        } else if (op == OPCODE_JALR) {
+            pc_wdata = (r.rs1_rdata + static_cast<uint64_t>(imm_i(insn))) & ~1ULL;
+        } else if (op == OPCODE_BRANCH && branch_taken(funct3(insn), r.rs1_rdata, r.rs2_rdata)) {
+            pc_wdata = r.pc_rdata + static_cast<uint64_t>(imm_b(insn));
+        }
+        if (r.pc_wdata != pc_wdata) {
+            return fail(r, "rvfi_pc_wdata is " + hex(r.pc_wdata) + ", expected " + hex(pc_wdata));
+        }
+
+        const bool load = op == OPCODE_LOAD;
+        const bool store = op == OPCODE_STORE;
+        const uint8_t mask = static_cast<uint8_t>((1u << mem_access_bytes(insn)) - 1);
+        const uint64_t mem_addr = load  ? r.rs1_rdata + static_cast<uint64_t>(imm_i(insn))
+                                : store ? r.rs1_rdata + static_cast<uint64_t>(imm_s(insn))
+                                        : 0;
+        if (r.mem_rmask != (load ? mask : 0) || r.mem_wmask != (store ? mask : 0)) {
+            return fail(r, "rvfi_mem_rmask/wmask are " + hex(r.mem_rmask) + "/" + hex(r.mem_wmask));
+        }
+        if (r.mem_addr != mem_addr) {
+            return fail(r, "rvfi_mem_addr is " + hex(r.mem_addr) + ", expected " + hex(mem_addr));
+        }
+        if (r.mem_rdata != mask_to_bytes(r.mem_rdata, load ? mem_access_bytes(insn) : 0)) {
+            return fail(r, "rvfi_mem_rdata " + hex(r.mem_rdata) + " has bytes outside rvfi_mem_rmask");
+        }
+        if (load && r.rd_addr != 0) {
+            const unsigned bytes = mem_access_bytes(insn);
+            const bool is_unsigned = (funct3(insn) & 0x4) != 0;
+            const uint64_t loaded = (is_unsigned || bytes == 8)
+                                        ? r.mem_rdata
+                                        : static_cast<uint64_t>(sign_extend(r.mem_rdata, 8 * bytes));
+            if (r.rd_wdata != loaded) {
+                return fail(r, "rvfi_rd_wdata " + hex(r.rd_wdata) + " is not rvfi_mem_rdata " + hex(r.mem_rdata) +
+                                   " extended");
+            }
+        }
+
+        if (r.rd_addr != 0) {
+            regs_[r.rd_addr] = r.rd_wdata;
+        }
+        next_pc_ = r.pc_wdata;
+        redirects_ += r.pc_wdata != r.pc_rdata + 4;
+        loads_ += load;
+        without_rs2_ += !reads_rs2(insn);
+        ++checked_;
+        return "";
+    }
+
+    static std::string hex(uint64_t value) {
+        std::ostringstream ss;
+        ss << "0x" << std::hex << value;
+        return ss.str();
+    }
+
+    static std::string fail(const Retirement& r, const std::string& what) {
+        std::ostringstream ss;
+        ss << what << " (order " << r.order << ", pc=0x" << std::hex << std::setw(16) << std::setfill('0')
+           << r.pc_rdata << " instr=0x" << std::setw(8) << r.insn << " " << rv64i::mnemonic(r.insn) << ")";
+        return ss.str();
+    }
+
+    uint64_t regs_[32] = {};
+    uint64_t next_pc_ = 0;
+    uint64_t checked_ = 0;
+    uint64_t redirects_ = 0;
+    uint64_t loads_ = 0;
+    uint64_t without_rs2_ = 0;
+};
+
+} // namespace rvfi_check
+
+#endif // RVFI_CHECK_H
@@ -0,0 +1,11 @@
+// tests/common/shared_imem.cpp
+// DPI side of instruction_memory.sv with SHARED_IMAGE=1. Linked into
+// testbenches built with add_verilated_pipeline(... SHARED_IMEM).
+
+#include "Vpipeline__Dpi.h"
+
+#include "shared_imem.h"
+
+int imem_shared_fetch(long long addr) {
+    return static_cast<int>(shared_imem::fetch(static_cast<uint64_t>(addr)));
+}
@@ -0,0 +1,172 @@
+// tests/common/shared_imem.h
+#ifndef SHARED_IMEM_H
+#define SHARED_IMEM_H
+
+#include "elf_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Program images for pipelines verilated with INSTR_MEM_SHARED_IMAGE=1
+// (add_verilated_pipeline(... SHARED_IMEM)). instruction_memory.sv then has no
+// ROM array: fetch calls imem_shared_fetch() (shared_imem.cpp), which reads
+// the image bound to the calling thread. An image is the ELF file mapped
+// read-only, served straight from its executable PT_LOAD segments, so all
+// models running the same program share one copy in the page cache.
+//
+// Bind on the thread that calls eval(). A model verilated with --threads > 1
+// could fetch from one of its own threads, so such builds are not supported.
+//
+// The mapping also exposes every PT_LOAD segment, which the sparse data
+// memory (sparse_dmem.h) uses as its copy-on-write backing.
+
+namespace shared_imem {
+
+constexpr uint32_t NOP = 0x00000013; // addi x0, x0, 0
+
+class Image {
+public:
+    struct Segment {
+        uint64_t       vaddr;
+        uint64_t       file_size;
+        uint64_t       mem_size;  // Past file_size the segment is zero (.bss)
+        uint64_t       file_offset;
+        uint32_t       flags;     // PF_X / PF_W / PF_R
+        const uint8_t* data;      // file_size bytes inside the mapping
+    };
+
+    // Maps `elf_path`, or returns the image already mapped for it if the file
+    // has not changed since. Null (with an error printed) on failure.
+    static std::shared_ptr<const Image> open(const std::string& elf_path);
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+    ~Image() {
+        if (map_ != MAP_FAILED) {
+            munmap(map_, map_size_);
+        }
+    }
+
+    uint64_t entry() const { return entry_; }
+    const std::vector<Segment>& segments() const { return segments_; }
+
+    // Word-aligned like the ROM. Unmapped addresses read as NOP, the way an
+    // unwritten word does after backdoor_clear_instr_mem(); loaded words are
+    // returned as they are.
+    uint32_t fetch(uint64_t addr) const {
+        addr &= ~3ULL;
+        for (const Span& span : spans_) {
+            const uint64_t offset = addr - span.vaddr;
+            if (offset < span.size && span.size - offset >= 4) {
+                const uint8_t* p = span.data + offset;
+                const uint32_t word = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                                      (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+                return word;
+            }
+        }
+        return NOP;
+    }
+
+private:
+    struct Span {
+        uint64_t       vaddr;
+        uint64_t       size;
+        const uint8_t* data;
+    };
+
+    Image() = default;
+
+    bool parse(const std::string& path) {
+        const uint8_t* base = static_cast<const uint8_t*>(map_);
+        std::vector<ElfLoadSegment> loads;
+        if (!parse_elf_load_segments(base, map_size_, path, entry_, loads)) {
+            return false;
+        }
+        for (const ElfLoadSegment& load : loads) {
+            segments_.push_back({load.vaddr, load.file_size, load.mem_size, load.file_offset, load.flags,
+                                 base + load.file_offset});
+            // Past file_size nothing was loaded, so fetch reads NOP there
+            if ((load.flags & PF_X) && load.file_size != 0) {
+                spans_.push_back({load.vaddr, load.file_size, base + load.file_offset});
+            }
+        }
+        if (spans_.empty()) {
+            std::cerr << "ERROR: " << path << " has no executable PT_LOAD segment." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void*                map_ = MAP_FAILED;
+    size_t               map_size_ = 0;
+    struct timespec      mtime_ = {};
+    uint64_t             entry_ = 0;
+    std::vector<Segment> segments_;
+    std::vector<Span>    spans_;    // Executable segments, for fetch()
+};
+
+inline std::shared_ptr<const Image> Image::open(const std::string& elf_path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<const Image>> mapped;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const int fd = ::open(elf_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Could not open ELF file: " << elf_path << std::endl;
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::cerr << "ERROR: Could not read ELF file: " << elf_path << std::endl;
+        close(fd);
+        return nullptr;
+    }
+    if (std::shared_ptr<const Image> image = mapped[elf_path].lock()) {
+        if (image->map_size_ == static_cast<size_t>(st.st_size) && image->mtime_.tv_sec == st.st_mtim.tv_sec &&
+            image->mtime_.tv_nsec == st.st_mtim.tv_nsec) {
+            close(fd);
+            return image;
+        }
+    }
+
+    std::shared_ptr<Image> image(new Image);
+    image->map_size_ = static_cast<size_t>(st.st_size);
+    image->mtime_ = st.st_mtim;
+    image->map_ = mmap(nullptr, image->map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image->map_ == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map ELF file: " << elf_path << std::endl;
+        return nullptr;
+    }
+    if (!image->parse(elf_path)) {
+        return nullptr;
+    }
+    mapped[elf_path] = image;
+    return image;
+}
+
+// Image fetched by models evaluated on this thread (null: everything is a NOP).
+inline thread_local std::shared_ptr<const Image> bound_image;
+
+inline void bind(std::shared_ptr<const Image> image) {
+    bound_image = std::move(image);
+}
+
+inline uint32_t fetch(uint64_t addr) {
+    return bound_image ? bound_image->fetch(addr) : NOP;
+}
+
+} // namespace shared_imem
+
+#endif // SHARED_IMEM_H
@@ -0,0 +1,198 @@
+// tests/common/simpoint.h
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+#include "rv64i_isa.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// SimPoint-style phase analysis: basic-block vectors (BBVs) per fixed-length
+// instruction interval, reduced by random projection and clustered with
+// k-means. One representative interval per cluster, weighted by cluster size,
+// stands in for the whole program.
+
+namespace simpoint {
+
+constexpr unsigned DIMENSIONS = 15; // Projection width used by SimPoint 3
+using Vector = std::array<double, DIMENSIONS>;
+
+struct SimPoint {
+    uint64_t interval = 0; // Index of the representative interval
+    double   weight = 0.0; // Fraction of all intervals in its cluster
+};
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Collects one projected BBV per complete interval. A basic block is named
+// by the PC of its first instruction and ends at any control-flow instruction
+// or interval boundary; its entry counts the instructions executed in it.
+class BbvCollector {
+public:
+    BbvCollector(uint64_t interval_length, uint64_t seed) : interval_length_(interval_length), seed_(seed) {}
+
+    void on_retire(uint64_t pc, uint32_t instr) {
+        if (block_length_ == 0) {
+            block_pc_ = pc;
+        }
+        ++block_length_;
+        const uint8_t op = rv64i::opcode(instr);
+        if (op == rv64i::OPCODE_BRANCH || op == rv64i::OPCODE_JAL || op == rv64i::OPCODE_JALR) {
+            end_block();
+        }
+        if (++interval_count_ == interval_length_) {
+            end_block();
+            end_interval();
+        }
+    }
+
+    // Projected, length-normalized BBVs of the complete intervals so far. A
+    // trailing partial interval is not included.
+    const std::vector<Vector>& intervals() const { return intervals_; }
+
+private:
+    void end_block() {
+        if (block_length_ > 0) {
+            counts_[block_pc_] += block_length_;
+            block_length_ = 0;
+        }
+    }
+
+    void end_interval() {
+        Vector v{};
+        for (const auto& entry : counts_) {
+            const double share = static_cast<double>(entry.second) / interval_length_;
+            for (unsigned d = 0; d < DIMENSIONS; ++d) {
+                const uint64_t r = splitmix64(seed_ ^ (entry.first * DIMENSIONS + d));
+                v[d] += share * (static_cast<double>(r >> 11) * 0x1.0p-53 * 2.0 - 1.0);
+            }
+        }
+        intervals_.push_back(v);
+        counts_.clear();
+        interval_count_ = 0;
+    }
+
+    uint64_t interval_length_;
+    uint64_t seed_;
+    uint64_t interval_count_ = 0;
+    uint64_t block_pc_ = 0;
+    uint64_t block_length_ = 0;
+    std::unordered_map<uint64_t, uint64_t> counts_;
+    std::vector<Vector> intervals_;
+};
+
+inline double distance2(const Vector& a, const Vector& b) {
+    double sum = 0.0;
+    for (unsigned d = 0; d < DIMENSIONS; ++d) {
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return sum;
+}
+
+// k-means with k-means++ seeding. Returns one simulation point per non-empty
+// cluster: the interval closest to its centroid. Deterministic for a seed.
+inline std::vector<SimPoint> choose_simpoints(const std::vector<Vector>& points, unsigned k, uint64_t seed,
+                                              unsigned max_iterations = 100) {
+    std::vector<SimPoint> result;
+    if (points.empty() || k == 0) {
+        return result;
+    }
+    if (k > points.size()) {
+        k = static_cast<unsigned>(points.size());
+    }
+
+    std::mt19937_64 rng(seed);
+    std::vector<Vector> centroids;
+    centroids.push_back(points[rng() % points.size()]);
+    std::vector<double> nearest(points.size(), std::numeric_limits<double>::max());
+    while (centroids.size() < k) {
+        double total = 0.0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            nearest[i] = std::min(nearest[i], distance2(points[i], centroids.back()));
+            total += nearest[i];
+        }
+        if (total == 0.0) {
+            break; // Fewer distinct phases than k
+        }
+        double pick = std::uniform_real_distribution<double>(0.0, total)(rng);
+        size_t chosen = points.size() - 1;
+        for (size_t i = 0; i < points.size(); ++i) {
+            pick -= nearest[i];
+            if (pick <= 0.0) {
+                chosen = i;
+                break;
+            }
+        }
+        centroids.push_back(points[chosen]);
+    }
+
+    std::vector<unsigned> cluster(points.size(), 0);
+    for (unsigned iteration = 0; iteration < max_iterations; ++iteration) {
+        bool changed = false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            unsigned best = 0;
+            for (unsigned c = 1; c < centroids.size(); ++c) {
+                if (distance2(points[i], centroids[c]) < distance2(points[i], centroids[best])) {
+                    best = c;
+                }
+            }
+            changed |= (iteration == 0 || cluster[i] != best);
+            cluster[i] = best;
+        }
+        if (!changed) {
+            break;
+        }
+        std::vector<Vector> sums(centroids.size(), Vector{});
+        std::vector<uint64_t> sizes(centroids.size(), 0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            for (unsigned d = 0; d < DIMENSIONS; ++d) {
+                sums[cluster[i]][d] += points[i][d];
+            }
+            ++sizes[cluster[i]];
+        }
+        for (unsigned c = 0; c < centroids.size(); ++c) {
+            if (sizes[c] == 0) {
+                continue; // Keep the old centroid of an emptied cluster
+            }
+            for (unsigned d = 0; d < DIMENSIONS; ++d) {
+                centroids[c][d] = sums[c][d] / sizes[c];
+            }
+        }
+    }
+
+    for (unsigned c = 0; c < centroids.size(); ++c) {
+        SimPoint point;
+        uint64_t size = 0;
+        double best = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (cluster[i] != c) {
+                continue;
+            }
+            ++size;
+            const double d = distance2(points[i], centroids[c]);
+            if (d < best) {
+                best = d;
+                point.interval = i;
+            }
+        }
+        if (size > 0) {
+            point.weight = static_cast<double>(size) / points.size();
+            result.push_back(point);
+        }
+    }
+    return result;
+}
+
+} // namespace simpoint
+
+#endif // SIMPOINT_H
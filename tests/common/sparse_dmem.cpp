@@ -0,0 +1,20 @@
+// tests/common/sparse_dmem.cpp
+// DPI side of data_memory.sv with SPARSE=1. Linked into testbenches built
+// with add_verilated_pipeline(... SPARSE_DMEM).
+
+#include "Vpipeline__Dpi.h"
+
+#include "sparse_dmem.h"
+
+long long dmem_sparse_read(long long addr) {
+    return static_cast<long long>(sparse_dmem::thread_memory().read64(static_cast<uint64_t>(addr)));
+}
+
+void dmem_sparse_write(long long addr, long long data, int bytes) {
+    sparse_dmem::thread_memory().write(static_cast<uint64_t>(addr), static_cast<uint64_t>(data),
+                                       static_cast<unsigned>(bytes));
+}
+
+void dmem_sparse_reset() {
+    sparse_dmem::thread_memory().reset();
+}
@@ -0,0 +1,187 @@
+// tests/common/sparse_dmem.h
+#ifndef SPARSE_DMEM_H
+#define SPARSE_DMEM_H
+
+#include "elf_loader.h"
+#include "shared_imem.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Data memory for pipelines verilated with DATA_MEM_SPARSE=1
+// (add_verilated_pipeline(... SPARSE_DMEM)). data_memory.sv then calls
+// dmem_sparse_read/write/reset() (sparse_dmem.cpp) on the memory of the
+// calling thread, which covers the whole 64-bit address space in 4 KiB pages.
+//
+// A loaded ELF file is mapped read-only (shared_imem::Image) and its pages
+// are read in place. A page gets a private copy only when it is first
+// written, or when a segment covers it partially. Untouched addresses read as
+// zero and cost nothing. reset() drops the written pages, which puts the
+// loaded image back.
+
+namespace sparse_dmem {
+
+constexpr unsigned PAGE_BITS = 12;
+constexpr uint64_t PAGE_BYTES = 1ULL << PAGE_BITS;
+
+class SparseMemory {
+public:
+    // Replaces the contents with the program's PT_LOAD segments. Images from
+    // load_elf_image() are mapped from their file; others are copied.
+    bool load(const ElfImage& image) {
+        clear();
+        if (!image.path.empty()) {
+            mapping_ = shared_imem::Image::open(image.path);
+            if (!mapping_) {
+                return false;
+            }
+            for (const shared_imem::Image::Segment& segment : mapping_->segments()) {
+                add_segment(segment.vaddr, segment.data, segment.file_size, true);
+            }
+            return true;
+        }
+        for (const ElfSegment& segment : image.segments) {
+            add_segment(segment.vaddr, segment.bytes.data(), segment.bytes.size(), false);
+        }
+        return true;
+    }
+
+    // Everything reads as zero again.
+    void clear() {
+        pages_.clear();
+        dirty_pages_.clear();
+        mapping_.reset();
+        last_number_ = ~0ULL;
+        last_page_ = nullptr;
+    }
+
+    // Drops every page written since load().
+    void reset() {
+        for (uint64_t number : dirty_pages_) {
+            auto it = pages_.find(number);
+            if (it->second.base) {
+                it->second.written.reset();
+            } else {
+                pages_.erase(it);
+            }
+        }
+        dirty_pages_.clear();
+        last_number_ = ~0ULL;
+        last_page_ = nullptr;
+    }
+
+    // Doubleword at `addr`, which is 8-byte aligned.
+    uint64_t read64(uint64_t addr) {
+        const uint8_t* data = page_data(addr >> PAGE_BITS);
+        if (!data) {
+            return 0;
+        }
+        const uint8_t* p = data + (addr & (PAGE_BYTES - 1));
+        uint64_t value = 0;
+        for (int b = 7; b >= 0; --b) {
+            value = (value << 8) | p[b];
+        }
+        return value;
+    }
+
+    // Low `bytes` bytes of `data`, little-endian; may cross a page boundary.
+    void write(uint64_t addr, uint64_t data, unsigned bytes) {
+        for (unsigned b = 0; b < bytes; ++b) {
+            writable(addr >> PAGE_BITS)[addr & (PAGE_BYTES - 1)] = static_cast<uint8_t>(data >> (8 * b));
+            ++addr;
+        }
+    }
+
+    size_t resident_pages() const { return pages_.size(); }
+    size_t dirty_pages() const { return dirty_pages_.size(); }
+
+private:
+    struct Page {
+        const uint8_t*             base = nullptr; // Loaded contents; null reads as zero
+        std::unique_ptr<uint8_t[]> own_base;       // Backs `base` when it is not in the mapping
+        std::unique_ptr<uint8_t[]> written;        // Private copy once written
+    };
+
+    Page* find(uint64_t number) {
+        if (number != last_number_) {
+            auto it = pages_.find(number);
+            last_number_ = number;
+            last_page_ = it == pages_.end() ? nullptr : &it->second;
+        }
+        return last_page_;
+    }
+
+    const uint8_t* page_data(uint64_t number) {
+        const Page* page = find(number);
+        if (!page) {
+            return nullptr;
+        }
+        return page->written ? page->written.get() : page->base;
+    }
+
+    uint8_t* writable(uint64_t number) {
+        Page* page = find(number);
+        if (!page) {
+            page = &pages_[number];
+            last_page_ = page;
+        }
+        if (!page->written) {
+            page->written.reset(new uint8_t[PAGE_BYTES]);
+            if (page->base) {
+                std::memcpy(page->written.get(), page->base, PAGE_BYTES);
+            } else {
+                std::memset(page->written.get(), 0, PAGE_BYTES);
+            }
+            dirty_pages_.push_back(number);
+        }
+        return page->written.get();
+    }
+
+    // Pages wholly inside `size` bytes of `data` point into it when `in_place`;
+    // partial pages (and all pages otherwise) get private base copies. The
+    // zero tail of a segment (.bss) needs no pages at all.
+    void add_segment(uint64_t vaddr, const uint8_t* data, uint64_t size, bool in_place) {
+        const uint64_t end = vaddr + size;
+        for (uint64_t addr = vaddr; addr < end;) {
+            const uint64_t number = addr >> PAGE_BITS;
+            const uint64_t page_start = number << PAGE_BITS;
+            const uint64_t chunk = std::min(end, page_start + PAGE_BYTES) - addr;
+            Page& page = pages_[number];
+            if (in_place && chunk == PAGE_BYTES && !page.base) {
+                page.base = data + (addr - vaddr);
+            } else {
+                if (!page.own_base) {
+                    page.own_base.reset(new uint8_t[PAGE_BYTES]);
+                    if (page.base) {
+                        std::memcpy(page.own_base.get(), page.base, PAGE_BYTES);
+                    } else {
+                        std::memset(page.own_base.get(), 0, PAGE_BYTES);
+                    }
+                    page.base = page.own_base.get();
+                }
+                std::memcpy(page.own_base.get() + (addr - page_start), data + (addr - vaddr), chunk);
+            }
+            addr += chunk;
+        }
+    }
+
+    std::unordered_map<uint64_t, Page>         pages_;
+    std::vector<uint64_t>                      dirty_pages_;
+    std::shared_ptr<const shared_imem::Image>  mapping_;
+    uint64_t                                   last_number_ = ~0ULL;
+    Page*                                      last_page_ = nullptr;
+};
+
+// Memory of the model evaluated on this thread.
+inline SparseMemory& thread_memory() {
+    static thread_local SparseMemory memory;
+    return memory;
+}
+
+} // namespace sparse_dmem
+
+#endif // SPARSE_DMEM_H
@@ -0,0 +1,70 @@
+// tests/common/spsc_ring.h
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Lock-free single-producer/single-consumer ring buffer of trivially copyable
+// records. The ring has no pointers or constructors, so it can be placed in
+// POSIX shared memory and used from two processes, or used in-process between
+// two threads. Call init() exactly once before either side touches it.
+//
+// The producer and consumer indices live on separate cache lines, and each
+// side keeps a private copy of the other side's index, so the shared line is
+// only re-read when the ring looks full or empty.
+template <typename T, size_t Capacity>
+struct SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Ring elements must be trivially copyable");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring indices must be lock-free");
+
+    static constexpr size_t kCacheLine = 64;
+
+    alignas(kCacheLine) std::atomic<uint64_t> head;  // Next slot to write (producer)
+    uint64_t cached_tail;                            // Producer's view of tail
+    alignas(kCacheLine) std::atomic<uint64_t> tail;  // Next slot to read (consumer)
+    uint64_t cached_head;                            // Consumer's view of head
+    alignas(kCacheLine) T slots[Capacity];
+
+    void init() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cached_tail = 0;
+        cached_head = 0;
+    }
+
+    bool try_push(const T& value) {
+        const uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - cached_tail == Capacity) {
+            cached_tail = tail.load(std::memory_order_acquire);
+            if (h - cached_tail == Capacity) {
+                return false;
+            }
+        }
+        slots[h & (Capacity - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T& value) {
+        const uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t == cached_head) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (t == cached_head) {
+                return false;
+            }
+        }
+        value = slots[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire);
+    }
+};
+
+#endif // SPSC_RING_H
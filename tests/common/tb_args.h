@@ -0,0 +1,68 @@
+// tests/common/tb_args.h
+#ifndef TB_ARGS_H
+#define TB_ARGS_H
+
+#include "verilated.h"
+
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+#include <iostream>
+
+// Runtime testbench configuration through Verilator plusargs
+// (e.g. "+NUM_CYCLES=55"). Lets one verilated model run any test program
+// instead of baking test parameters in with -D/-G at verilation time.
+// Verilated::commandArgs() must be called before any of these.
+
+inline bool tb_has_plusarg(const std::string& name) {
+    std::string match = Verilated::commandArgsPlusMatch(name.c_str());
+    return !match.empty();
+}
+
+inline std::string tb_plusarg_string(const std::string& name, const std::string& default_value) {
+    const std::string prefix = name + "=";
+    std::string match = Verilated::commandArgsPlusMatch(prefix.c_str());
+    if (match.empty()) {
+        return default_value;
+    }
+    return match.substr(prefix.size() + 1); // Skip leading '+' and "NAME="
+}
+
+// Accepts decimal or 0x-prefixed hex.
+inline uint64_t tb_plusarg_u64(const std::string& name, uint64_t default_value) {
+    const std::string text = tb_plusarg_string(name, "");
+    if (text.empty()) {
+        return default_value;
+    }
+    try {
+        return std::stoull(text, nullptr, 0);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: Invalid value for +" << name << "=" << text << ": " << e.what() << std::endl;
+        throw;
+    }
+}
+
+// Hex with or without 0x, for addresses (e.g. +CHECKPOINT_PC=10040).
+inline uint64_t tb_plusarg_hex(const std::string& name, uint64_t default_value) {
+    const std::string text = tb_plusarg_string(name, "");
+    if (text.empty()) {
+        return default_value;
+    }
+    try {
+        return std::stoull(text, nullptr, 16);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: Invalid value for +" << name << "=" << text << ": " << e.what() << std::endl;
+        throw;
+    }
+}
+
+// Fails loudly for parameters a test cannot run without.
+inline std::string tb_require_plusarg(const std::string& name) {
+    const std::string text = tb_plusarg_string(name, "");
+    if (text.empty()) {
+        throw std::runtime_error("Missing required plusarg +" + name + "=<value>");
+    }
+    return text;
+}
+
+#endif // TB_ARGS_H
@@ -0,0 +1,147 @@
+// tests/common/tb_checkpoint.h
+#ifndef TB_CHECKPOINT_H
+#define TB_CHECKPOINT_H
+
+#include "verilated.h"
+#ifdef TB_SAVABLE_MODEL
+#include "verilated_save.h"
+#endif
+
+#include "pipeline_events.h"
+#include "tb_args.h"
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Checkpoint/restore for models verilated with --savable. A checkpoint holds
+// the harness state below followed by the full model state (every signal and
+// memory), so a restored run continues exactly where the saved one stopped:
+//   +CHECKPOINT_SAVE=<path>    file to write
+//   +CHECKPOINT_AT=<cycle>     save before this cycle runs
+//   +CHECKPOINT_PC=<hex>       save when the PC first matches
+//   +CHECKPOINT_EXIT           stop the run once the checkpoint is written
+//   +CHECKPOINT_RESTORE=<path> resume from a checkpoint instead of resetting
+// Waveforms are not part of the model state; a restored run opens a new file
+// whose timestamps continue from the saved sim_time.
+// add_verilated_pipeline(... SAVABLE) defines TB_SAVABLE_MODEL; other models
+// compile the same harness but report an error when a checkpoint is requested.
+
+// Testbench state that has to survive a restore for identical output.
+struct TbHarnessState {
+    uint64_t sim_time = 0; // Also the waveform timestamp offset
+    uint64_t cycle = 0;    // Next cycle to run
+    bool     passed = true;
+    uint64_t tohost = ~0ULL; // End-of-test monitor state (tb_exit.h)
+    uint64_t a0 = 0;
+    pipeline_events::Counters events; // Counted so far; testbenches sample into this one
+};
+
+class TbCheckpoint {
+public:
+    TbCheckpoint() {
+        save_path_ = tb_plusarg_string("CHECKPOINT_SAVE", "");
+        restore_path_ = tb_plusarg_string("CHECKPOINT_RESTORE", "");
+        save_cycle_ = tb_plusarg_u64("CHECKPOINT_AT", NO_CYCLE);
+        if (tb_has_plusarg("CHECKPOINT_PC")) {
+            has_save_pc_ = true;
+            save_pc_ = tb_plusarg_hex("CHECKPOINT_PC", 0);
+        }
+        exit_after_save_ = tb_has_plusarg("CHECKPOINT_EXIT");
+        if (!save_path_.empty() && save_cycle_ == NO_CYCLE && !has_save_pc_) {
+            std::cerr << "WARNING: +CHECKPOINT_SAVE without +CHECKPOINT_AT or +CHECKPOINT_PC; no checkpoint will be written." << std::endl;
+        }
+    }
+
+    bool restore_requested() const { return !restore_path_.empty(); }
+
+    // Replaces the model and harness state with the checkpoint contents. Call
+    // on a freshly constructed model instead of the load/reset sequence.
+    template <typename Model>
+    bool restore(Model* top, TbHarnessState& state) {
+#ifndef TB_SAVABLE_MODEL
+        (void)top;
+        (void)state;
+        std::cerr << "ERROR: +CHECKPOINT_RESTORE needs a model verilated with --savable." << std::endl;
+        return false;
+#else
+        VerilatedRestore is;
+        is.open(restore_path_.c_str());
+        if (!is.isOpen()) {
+            std::cerr << "ERROR: Could not open checkpoint: " << restore_path_ << std::endl;
+            return false;
+        }
+        std::string magic;
+        uint64_t version = 0;
+        is >> magic >> version;
+        if (magic != MAGIC || version != VERSION) {
+            std::cerr << "ERROR: " << restore_path_ << " is not a version " << VERSION << " testbench checkpoint." << std::endl;
+            return false;
+        }
+        is >> state.sim_time >> state.cycle >> state.passed >> state.tohost >> state.a0;
+        state.events.restore(is);
+        is >> *top;
+        is.close();
+        std::cout << "CHECKPOINT: Restored " << restore_path_ << " at cycle " << state.cycle << std::endl;
+        return true;
+#endif
+    }
+
+    // Call once per cycle before it runs. Returns true when the run should stop
+    // because the checkpoint was written and +CHECKPOINT_EXIT was given.
+    template <typename Model>
+    bool on_cycle(Model* top, const TbHarnessState& state, uint64_t pc) {
+        if (saved_ || save_path_.empty()) {
+            return false;
+        }
+        const bool at_cycle = save_cycle_ != NO_CYCLE && state.cycle >= save_cycle_;
+        const bool at_pc = has_save_pc_ && pc == save_pc_;
+        if (!at_cycle && !at_pc) {
+            return false;
+        }
+        saved_ = true;
+        if (!save(top, state)) {
+            return false;
+        }
+        return exit_after_save_;
+    }
+
+private:
+    static constexpr uint64_t NO_CYCLE = ~0ULL;
+    static constexpr const char* MAGIC = "TBCKPT";
+    static constexpr uint64_t VERSION = 3;
+
+    template <typename Model>
+    bool save(Model* top, const TbHarnessState& state) {
+#ifndef TB_SAVABLE_MODEL
+        (void)top;
+        (void)state;
+        std::cerr << "ERROR: +CHECKPOINT_SAVE needs a model verilated with --savable." << std::endl;
+        return false;
+#else
+        VerilatedSave os;
+        os.open(save_path_.c_str());
+        if (!os.isOpen()) {
+            std::cerr << "ERROR: Could not open checkpoint for writing: " << save_path_ << std::endl;
+            return false;
+        }
+        os << std::string(MAGIC) << VERSION;
+        os << state.sim_time << state.cycle << state.passed << state.tohost << state.a0;
+        state.events.save(os);
+        os << *top;
+        os.close();
+        std::cout << "CHECKPOINT: Saved " << save_path_ << " at cycle " << state.cycle << std::endl;
+        return true;
+#endif
+    }
+
+    std::string save_path_;
+    std::string restore_path_;
+    uint64_t    save_cycle_ = NO_CYCLE;
+    bool        has_save_pc_ = false;
+    uint64_t    save_pc_ = 0;
+    bool        exit_after_save_ = false;
+    bool        saved_ = false;
+};
+
+#endif // TB_CHECKPOINT_H
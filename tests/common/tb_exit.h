@@ -0,0 +1,94 @@
+// tests/common/tb_exit.h
+#ifndef TB_EXIT_H
+#define TB_EXIT_H
+
+#include "elf_loader.h"
+#include "retire_record.h"
+#include "rv64i_isa.h"
+#include "tb_args.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// End-of-test detection on the retirement stream, so a run stops when the
+// program says it is done rather than after a guessed cycle count. A program
+// ends by
+//   - storing to tohost (the riscv-tests/HTIF convention): an odd value v ends
+//     the run with exit code v >> 1, so 1 is a pass. Even non-zero values are
+//     HTIF requests the harness does not serve; they end the run as a failure.
+//   - retiring ecall or ebreak: the exit code is a0 at that point.
+// The tohost address is +TOHOST=<addr> or else the ELF symbol `tohost`;
+// without one, only ecall/ebreak end a run. Testbenches bound the run with
+// +MAX_CYCLES=<n> and treat reaching it as a failure.
+
+constexpr uint64_t TB_DEFAULT_MAX_CYCLES = 100000;
+
+class TbExitMonitor {
+public:
+    static constexpr uint64_t NO_TOHOST = ~0ULL;
+
+    explicit TbExitMonitor(uint64_t tohost = NO_TOHOST, uint64_t a0 = 0) : tohost_(tohost), a0_(a0) {}
+
+    // Call for every retired instruction, in order. Returns true once the
+    // program has ended; later calls are ignored.
+    bool on_retire(const RetireRecord& r) {
+        if (finished_) {
+            return true;
+        }
+        if (r.rd_write && r.rd == 10) {
+            a0_ = r.rd_value;
+        }
+        if (r.instr == rv64i::INSTR_ECALL || r.instr == rv64i::INSTR_EBREAK) {
+            finish(r.instr == rv64i::INSTR_ECALL ? "ecall" : "ebreak", a0_);
+        } else if (r.mem_write && r.mem_addr == tohost_ && r.mem_wdata != 0) {
+            finish("tohost", (r.mem_wdata & 1) ? r.mem_wdata >> 1 : r.mem_wdata);
+        }
+        return finished_;
+    }
+
+    bool finished() const { return finished_; }
+    const std::string& reason() const { return reason_; }
+    uint64_t exit_value() const { return exit_value_; }
+
+    // Process exit status for exit_value(): its low byte, but never 0 unless
+    // the program passed.
+    int exit_code() const {
+        if (exit_value_ == 0) {
+            return 0;
+        }
+        return (exit_value_ & 0xFF) ? static_cast<int>(exit_value_ & 0xFF) : 1;
+    }
+
+    // State a checkpoint has to carry to resume monitoring.
+    uint64_t tohost() const { return tohost_; }
+    uint64_t a0() const { return a0_; }
+
+private:
+    void finish(const char* reason, uint64_t value) {
+        finished_ = true;
+        reason_ = reason;
+        exit_value_ = value;
+    }
+
+    uint64_t    tohost_;
+    uint64_t    a0_;
+    bool        finished_ = false;
+    std::string reason_;
+    uint64_t    exit_value_ = 0;
+};
+
+// tohost address for the program in `elf_file` (may be empty), or NO_TOHOST.
+inline uint64_t tb_tohost_address(const std::string& elf_file) {
+    if (tb_has_plusarg("TOHOST")) {
+        return tb_plusarg_u64("TOHOST", TbExitMonitor::NO_TOHOST);
+    }
+    std::vector<ElfSymbol> symbols;
+    uint64_t address = TbExitMonitor::NO_TOHOST;
+    if (!elf_file.empty() && load_elf_symbols(elf_file, symbols)) {
+        elf_find_symbol(symbols, "tohost", address);
+    }
+    return address;
+}
+
+#endif // TB_EXIT_H
@@ -0,0 +1,200 @@
+// tests/common/tb_trace.h
+#ifndef TB_TRACE_H
+#define TB_TRACE_H
+
+#include "verilated.h"
+
+#include "tb_args.h"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Waveform tracing for testbenches. Tracing is off unless requested:
+//   +TRACE                         trace the whole run
+//   +TRACE_FILE=<path>             output file (default <name>.vcd / .fst)
+//   +TRACE_DEPTH=<n>               hierarchy depth passed to trace() (default 99)
+//   +TRACE_SCOPE=<path>[:<levels>][,...]
+//                                  only dump these scopes, relative to the top
+//                                  module ("." is the top itself; levels 0 = all),
+//                                  e.g. +TRACE_SCOPE=.:1,u_hazard_unit
+//   +TRACE_START=<cycle>           start dumping at this cycle
+//   +TRACE_PC=<hex>                start dumping when the PC first matches
+//   +TRACE_STOP=<cycle>            stop dumping at this cycle
+//   +TRACE_ON_MISMATCH[=<cycles>]  start dumping at the first mismatch and keep
+//                                  going for <cycles> more (default 20)
+// Cycle/PC/mismatch triggers need the testbench to call on_cycle()/on_mismatch().
+// The output format follows the build: --trace gives VCD, --trace-fst gives FST.
+
+#ifndef VM_TRACE
+#define VM_TRACE 0
+#endif
+
+#if VM_TRACE && VM_TRACE_FST
+#include "verilated_fst_c.h"
+using TbTraceFile = VerilatedFstC;
+#define TB_TRACE_EXTENSION ".fst"
+#elif VM_TRACE
+#include "verilated_vcd_c.h"
+using TbTraceFile = VerilatedVcdC;
+#define TB_TRACE_EXTENSION ".vcd"
+#else
+// Model built without trace support; keeps testbench code compiling.
+struct TbTraceFile {
+    void open(const char*) {}
+    void dump(uint64_t) {}
+    void flush() {}
+    void close() {}
+};
+#define TB_TRACE_EXTENSION ""
+#endif
+
+class TbTrace {
+public:
+    // default_name: file name without extension; top_scope: top module name.
+    template <typename Model>
+    TbTrace(Model* top, const std::string& default_name, const std::string& top_scope) {
+        const bool has_trigger = tb_has_plusarg("TRACE_START") || tb_has_plusarg("TRACE_PC") ||
+                                 tb_has_plusarg("TRACE_ON_MISMATCH");
+        if (!tb_has_plusarg("TRACE")) { // Prefix match: any +TRACE* option enables tracing
+            return;
+        }
+#if VM_TRACE
+        file_name_ = tb_plusarg_string("TRACE_FILE", default_name + TB_TRACE_EXTENSION);
+        start_cycle_ = tb_plusarg_u64("TRACE_START", NO_CYCLE);
+        stop_cycle_ = tb_plusarg_u64("TRACE_STOP", NO_CYCLE);
+        if (tb_has_plusarg("TRACE_PC")) {
+            has_start_pc_ = true;
+            start_pc_ = tb_plusarg_hex("TRACE_PC", 0);
+        }
+        on_mismatch_ = tb_has_plusarg("TRACE_ON_MISMATCH");
+        post_mismatch_cycles_ = tb_plusarg_u64("TRACE_ON_MISMATCH", 20);
+        waiting_for_trigger_ = has_trigger;
+
+        Verilated::traceEverOn(true);
+        file_ = new TbTraceFile;
+        add_scopes(top_scope, tb_plusarg_string("TRACE_SCOPE", ""));
+        top->trace(file_, static_cast<int>(tb_plusarg_u64("TRACE_DEPTH", 99)));
+        if (!waiting_for_trigger_) {
+            activate("start of run");
+        }
+#else
+        (void)top;
+        (void)default_name;
+        (void)top_scope;
+        (void)has_trigger;
+        std::cerr << "WARNING: Tracing requested, but the model was built without trace support." << std::endl;
+#endif
+    }
+
+    ~TbTrace() {
+        close();
+        delete file_;
+    }
+
+    // File for dump() calls while tracing is active, nullptr otherwise.
+    TbTraceFile* file() const { return active_ ? file_ : nullptr; }
+
+    void dump(uint64_t time) {
+        if (active_) file_->dump(time);
+    }
+
+    // Evaluates cycle and PC triggers; call once per clock cycle.
+    void on_cycle(uint64_t cycle, uint64_t pc) {
+        if (!file_) {
+            return;
+        }
+        if (waiting_for_trigger_) {
+            if (start_cycle_ != NO_CYCLE && cycle >= start_cycle_) {
+                activate("cycle " + std::to_string(cycle));
+            } else if (has_start_pc_ && pc == start_pc_) {
+                std::ostringstream why;
+                why << "pc 0x" << std::hex << pc << " at cycle " << std::dec << cycle;
+                activate(why.str());
+            }
+        }
+        if (active_ && stop_cycle_ != NO_CYCLE && cycle >= stop_cycle_) {
+            active_ = false;
+            file_->flush();
+        }
+    }
+
+    // Starts the mismatch window if +TRACE_ON_MISMATCH was given. Returns the
+    // number of cycles the testbench should keep simulating to fill it.
+    uint64_t on_mismatch(uint64_t cycle) {
+        if (!file_ || !on_mismatch_) {
+            return 0;
+        }
+        if (waiting_for_trigger_) {
+            activate("mismatch at cycle " + std::to_string(cycle));
+            std::cout << "TRACE: For the cycles before the mismatch, rerun with +TRACE_START="
+                      << (cycle > post_mismatch_cycles_ ? cycle - post_mismatch_cycles_ : 0) << std::endl;
+        }
+        stop_cycle_ = cycle + post_mismatch_cycles_;
+        return post_mismatch_cycles_;
+    }
+
+    void close() {
+        if (file_ && opened_) {
+            file_->close();
+            opened_ = false;
+        }
+        active_ = false;
+    }
+
+private:
+    static constexpr uint64_t NO_CYCLE = ~0ULL;
+
+    void activate(const std::string& why) {
+        waiting_for_trigger_ = false;
+        if (!opened_) {
+            file_->open(file_name_.c_str());
+            opened_ = true;
+            std::cout << "TRACE: Dumping to " << file_name_ << " from " << why << std::endl;
+        }
+        active_ = true;
+    }
+
+    void add_scopes(const std::string& top_scope, const std::string& spec) {
+        if (spec.empty()) {
+            return;
+        }
+#if VM_TRACE && defined(VERILATOR_VERSION_INTEGER) && VERILATOR_VERSION_INTEGER >= 5006000
+        std::stringstream ss(spec);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            int levels = 0;
+            const size_t colon = item.find(':');
+            if (colon != std::string::npos) {
+                levels = std::stoi(item.substr(colon + 1));
+                item = item.substr(0, colon);
+            }
+            std::string hier = "TOP." + top_scope;
+            if (!item.empty() && item != ".") {
+                hier += "." + item;
+            }
+            file_->dumpvars(levels, hier);
+        }
+#else
+        (void)top_scope;
+        (void)spec;
+        std::cerr << "WARNING: +TRACE_SCOPE needs Verilator 5.006 or newer; tracing all scopes." << std::endl;
+#endif
+    }
+
+    TbTraceFile* file_ = nullptr;
+    std::string  file_name_;
+    bool         opened_ = false;
+    bool         active_ = false;
+    bool         waiting_for_trigger_ = false;
+    uint64_t     start_cycle_ = NO_CYCLE;
+    uint64_t     stop_cycle_ = NO_CYCLE;
+    bool         has_start_pc_ = false;
+    uint64_t     start_pc_ = 0;
+    bool         on_mismatch_ = false;
+    uint64_t     post_mismatch_cycles_ = 20;
+};
+
+#endif // TB_TRACE_H
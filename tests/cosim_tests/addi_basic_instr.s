@@ -7,18 +7,4 @@ _start:
     sub x3, x2, x1
     add x4, x2, x1
     slti x5, x4, 10
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    sret
\ No newline at end of file
+    ecall
@@ -24,33 +24,5 @@ poop:
     addi x1, x1, 600
 end:
     addi x8, x0, 0
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    sret
+    addi x10, x0, 0
+    ecall
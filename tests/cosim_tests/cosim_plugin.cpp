@@ -3,55 +3,89 @@
 #include <fstream>
 #include <iomanip>
 #include <string>
+#include <thread>
 #include "hart.h"
+#include "../common/cosim_channel.h"
+#include "../common/retire_trace.h"
 
-std::ofstream cosim_plugin_output_file;
-bool cosim_plugin_file_opened = false;
-
-void initialize_plugin_output(const std::string& filename) {
-    if (!cosim_plugin_file_opened) {
+// Register-write sink for co-simulation, chosen once from the environment:
+//   COSIM_SHM_NAME           - stream to pipeline_cosim_tb through shared memory
+//   COSIM_PLUGIN_TRACE_FILE  - binary retire trace with register writes only
+//                              (retire_trace.h; compare with retire_trace_diff)
+//   COSIM_PLUGIN_OUTPUT_FILE - write one hex line per register write
+class CosimPluginOutput {
+public:
+    CosimPluginOutput() {
+        if (const char* shm_name = std::getenv("COSIM_SHM_NAME")) {
+            channel_ = cosim_channel_open(shm_name);
+            if (!channel_) {
+                std::cerr << "PLUGIN ERROR: Could not attach to co-simulation channel: " << shm_name << std::endl;
+            }
+            return;
+        }
+        if (const char* trace_file = std::getenv("COSIM_PLUGIN_TRACE_FILE")) {
+            trace_.open(trace_file, retire_trace::FIELD_RD);
+            return;
+        }
         const char* out_file_env = std::getenv("COSIM_PLUGIN_OUTPUT_FILE");
-        std::string actual_filename = filename;
+        if (!out_file_env) {
+            std::cerr << "PLUGIN ERROR: None of COSIM_SHM_NAME, COSIM_PLUGIN_TRACE_FILE, COSIM_PLUGIN_OUTPUT_FILE is set." << std::endl;
+            return;
+        }
+        file_.open(out_file_env, std::ios::out | std::ios::trunc);
+        if (!file_.is_open()) {
+            std::cerr << "PLUGIN ERROR: Could not open output file: " << out_file_env << std::endl;
+        }
+    }
 
-        if (out_file_env) {
-            actual_filename = std::string(out_file_env);
-        } else {
-            std::cerr << "PLUGIN WARNING: COSIM_PLUGIN_OUTPUT_FILE env var not set. Using default: " << actual_filename << std::endl;
+    ~CosimPluginOutput() {
+        if (channel_) {
+            channel_->producer_done.store(1, std::memory_order_release);
+            cosim_channel_unmap(channel_);
         }
+    }
 
-        cosim_plugin_output_file.open(actual_filename, std::ios::out | std::ios::trunc);
-        if (cosim_plugin_output_file.is_open()) {
-            cosim_plugin_file_opened = true;
-            std::cout << "PLUGIN: Output file opened: " << actual_filename << std::endl;
-        } else {
-            std::cerr << "PLUGIN ERROR: Could not open output file: " << actual_filename << std::endl;
+    void write(Machine::RegId reg, Machine::RegValue val) {
+        if (channel_) {
+            const CosimRegWrite entry{static_cast<uint64_t>(val), static_cast<uint32_t>(reg), 0};
+            while (!channel_->ring.try_push(entry)) {
+                if (channel_->consumer_done.load(std::memory_order_acquire)) {
+                    return; // RTL side has stopped comparing
+                }
+                std::this_thread::yield();
+            }
+        } else if (trace_.is_open()) {
+            retire_trace::Record rec{};
+            rec.cycle = writes_++;
+            rec.flags = retire_trace::FLAG_RD_WRITE;
+            rec.rd = static_cast<uint8_t>(reg);
+            rec.rd_value = static_cast<uint64_t>(val);
+            trace_.write(rec);
+        } else if (file_.is_open()) {
+            file_ << std::hex << std::setw(16) << std::setfill('0') << val << '\n';
         }
     }
-}
 
+private:
+    CosimChannel* channel_ = nullptr;
+    retire_trace::Writer trace_;
+    uint64_t writes_ = 0;
+    std::ofstream file_;
+};
+
+static CosimPluginOutput& cosim_plugin_output() {
+    static CosimPluginOutput output;
+    return output;
+}
 
 extern "C" {
     void setReg(Machine::Hart *hart, Machine::RegId *reg_id_ptr, Machine::Instr *instr) {
-        if (!cosim_plugin_file_opened) {
-             const char* out_file_env = std::getenv("COSIM_PLUGIN_OUTPUT_FILE");
-             if (out_file_env) {
-                cosim_plugin_output_file.open(out_file_env, std::ios::out | std::ios::app);
-                if (cosim_plugin_output_file.is_open()) {
-                    cosim_plugin_file_opened = true;
-                } else {
-                    std::cerr << "PLUGIN ERROR: Could not open output file: " << out_file_env << std::endl;
-                }
-             } else {
-                 std::cerr << "PLUGIN ERROR: COSIM_PLUGIN_OUTPUT_FILE env var not set in setReg." << std::endl;
-                 return;
-             }
-        }
-        if (cosim_plugin_file_opened && reg_id_ptr != nullptr) {
+        (void)instr;
+        if (reg_id_ptr != nullptr) {
             Machine::RegId reg = *reg_id_ptr;
             if (reg != 0) {
-                Machine::RegValue val = hart->getReg(reg);
-                cosim_plugin_output_file << std::hex << std::setw(16) << std::setfill('0') << val << std::endl;
+                cosim_plugin_output().write(reg, hart->getReg(reg));
             }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+// tests/cosim_tests/iss_hart.h
+#ifndef ISS_HART_H
+#define ISS_HART_H
+
+#include "hart.h"
+
+#include "elf_loader.h"
+#include "retire_record.h"
+#include "rv64i_isa.h"
+
+#include <cstdint>
+#include <string>
+
+// Reference side of the lock-step co-simulation: wraps the simulator's
+// Machine::Hart so it can be stepped one instruction at a time and report
+// the same RetireRecord the RTL produces. Only this file depends on the
+// simulator API (Hart(elf), getPC(), getReg(), setReg(), step()).
+class IssHart {
+public:
+    explicit IssHart(const std::string& elf_file) : hart_(elf_file) {}
+
+    uint64_t pc() const { return static_cast<uint64_t>(hart_.getPC()); }
+
+    // Fetches the next instruction from the program image. Returns false once
+    // the ISS leaves the image or reaches ecall/ebreak, which the test
+    // programs use to end.
+    bool next_instr(const ElfImage& image, uint32_t& instr) const {
+        if (!elf_image_read32(image, pc(), instr)) {
+            return false;
+        }
+        return rv64i::opcode(instr) != rv64i::OPCODE_SYSTEM || rv64i::is_csr(instr);
+    }
+
+    RetireRecord step(uint32_t instr) {
+        RetireRecord r;
+        r.pc = pc();
+        r.instr = instr;
+        if (rv64i::opcode(instr) == rv64i::OPCODE_STORE) {
+            const unsigned bytes = rv64i::mem_access_bytes(instr);
+            r.mem_write = true;
+            r.mem_addr = reg(rv64i::rs1(instr)) + static_cast<uint64_t>(rv64i::imm_s(instr));
+            r.mem_wdata = rv64i::mask_to_bytes(reg(rv64i::rs2(instr)), bytes);
+        }
+
+        hart_.step();
+
+        if (rv64i::writes_rd(instr)) {
+            r.rd_write = true;
+            r.rd = rv64i::rd(instr);
+            r.rd_value = reg(r.rd);
+        }
+        return r;
+    }
+
+    // Overwrites a register, e.g. with the RTL's value of a CSR read.
+    void set_reg(uint8_t index, uint64_t value) {
+        if (index != 0) {
+            hart_.setReg(static_cast<Machine::RegId>(index), static_cast<Machine::RegValue>(value));
+        }
+    }
+
+private:
+    uint64_t reg(uint8_t index) const {
+        return static_cast<uint64_t>(hart_.getReg(static_cast<Machine::RegId>(index)));
+    }
+
+    Machine::Hart hart_;
+};
+
+#endif // ISS_HART_H
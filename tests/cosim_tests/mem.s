@@ -5,21 +5,4 @@ _start:
     addi x1, x0, 1
     sd x1, 0x10(x0)
     ld x2, 0x10(x0)
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    sret
\ No newline at end of file
+    ecall
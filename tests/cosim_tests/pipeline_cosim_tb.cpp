@@ -1,5 +1,4 @@
 #include "Vpipeline.h"
-#include "verilated_vcd_c.h"
 #include "verilated.h"
 
 #include <iostream>
@@ -9,25 +8,45 @@
 #include <vector>
 #include <sstream>
 #include <cstdlib>
+#include <thread>
 
-#ifndef PIPELINE_COSIM_TEST_CASE_NAME_STR_RAW
-#error "PIPELINE_COSIM_TEST_CASE_NAME_STR_RAW not defined!"
-#endif
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-#ifndef NUM_CYCLES_TO_RUN
-#error "NUM_CYCLES_TO_RUN not defined!"
-#endif
+#include "tb_args.h"
+#include "tb_trace.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "cosim_channel.h"
+#include "retire_record.h"
+#include "retire_trace.h"
+#include "tb_exit.h"
+#include "pipeline_events.h"
+#include "async_trace_sink.h"
 
-#ifndef VERILOG_OUTPUT_FILE_PATH_STR_RAW
-#error "VERILOG_OUTPUT_FILE_PATH_STR_RAW not defined!"
-#endif
+extern char** environ;
 
-#define STRINGIFY_HELPER(x) #x
-#define STRINGIFY(x) STRINGIFY_HELPER(x)
-
-const std::string G_PIPELINE_COSIM_TEST_CASE_NAME = STRINGIFY(PIPELINE_COSIM_TEST_CASE_NAME_STR_RAW);
-const int G_NUM_CYCLES_TO_RUN = NUM_CYCLES_TO_RUN;
-const std::string G_VERILOG_OUTPUT_FILE_PATH = STRINGIFY(VERILOG_OUTPUT_FILE_PATH_STR_RAW);
+// Test parameters come from plusargs so a single build runs every program:
+//   +TEST_NAME=<name>
+//   +ELF_FILE=<elf>   program loaded straight into both memories; start PC = e_entry
+//   +MAX_CYCLES=<n>   the run ends with the program (tb_exit.h), which also
+//                     sets the exit code; reaching n cycles first is a failure
+//   +NUM_CYCLES=<n>   instead run exactly n cycles (programs that never end)
+//   +INSTR_MEM_INIT_FILE=<hex> +PC_START_ADDR=<hex> (consumed by the RTL)
+// Output mode, one of:
+//   +VERILOG_OUTPUT_FILE=<path>  write RTL register writes for offline comparison
+//   +ISS_EXE=<simulator> +ISS_PLUGIN=<cosim plugin .so> [+ISS_LOG=<path>] [+COSIM_SHM=</name>]
+//       run the ISS concurrently and compare register writes on the fly through
+//       a shared-memory ring (see cosim_channel.h); requires +ELF_FILE
+//   +RETIRE_TRACE_FILE=<path>    additionally record every retirement in the
+//       binary trace format (retire_trace.h; compare with retire_trace_diff)
+//   +EVENT_REPORT=<path>         hazard/dispatch counters (pipeline_events.h)
+std::string G_PIPELINE_COSIM_TEST_CASE_NAME;
+int G_NUM_CYCLES_TO_RUN = 0; // 0: run until the program ends
+uint64_t G_MAX_CYCLES = 0;
+std::string G_VERILOG_OUTPUT_FILE_PATH;
 
 vluint64_t sim_time = 0;
 
@@ -35,70 +54,392 @@ double sc_time_stamp() {
     return sim_time;
 }
 
-void tick(Vpipeline* top, VerilatedVcdC* tfp, std::ofstream& outFile) {
+// Register writes for +VERILOG_OUTPUT_FILE; formatted on the sink's thread.
+void tick(Vpipeline* top, TbTrace& trace, AsyncTraceSink<uint64_t>& reg_writes) {
     top->clk = 0;
     top->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.dump(sim_time);
     sim_time++;
 
     top->clk = 1;
     top->eval();
-    if (tfp) tfp->dump(sim_time);
-
-    if (top->debug_reg_write_wb) {
-        if (outFile.is_open()) {
+    trace.dump(sim_time);
 
-            outFile << std::hex << std::setw(16) << std::setfill('0') << top->debug_result_w << std::endl;
-        }
+    if (top->debug_reg_write_wb && reg_writes.is_open()) {
+        reg_writes.push(top->debug_result_w);
     }
     sim_time++;
 }
 
+// ISS process feeding the shared-memory channel.
+class IssProcess {
+public:
+    bool start(const std::string& exe, const std::string& elf, const std::string& plugin,
+               const std::string& shm_name, const std::string& log_file) {
+        std::vector<std::string> env_strings;
+        for (char** e = environ; *e; ++e) {
+            env_strings.emplace_back(*e);
+        }
+        env_strings.push_back("COSIM_SHM_NAME=" + shm_name);
+        std::vector<char*> envp;
+        for (std::string& e : env_strings) envp.push_back(&e[0]);
+        envp.push_back(nullptr);
+
+        std::vector<std::string> arg_strings = {exe, elf, plugin};
+        std::vector<char*> argv;
+        for (std::string& a : arg_strings) argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (!log_file.empty()) {
+            posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+        }
+        const int rc = posix_spawn(&pid_, exe.c_str(), &actions, nullptr, argv.data(), envp.data());
+        posix_spawn_file_actions_destroy(&actions);
+        if (rc != 0) {
+            std::cerr << "VERILOG SIM ERROR: Could not start ISS " << exe << ": " << std::strerror(rc) << std::endl;
+            pid_ = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Non-blocking; true once the process has exited.
+    bool exited() {
+        if (pid_ > 0 && waitpid(pid_, &status_, WNOHANG) == pid_) {
+            pid_ = -1;
+        }
+        return pid_ <= 0;
+    }
+
+    // Waits for the process; false if it failed.
+    bool wait() {
+        if (pid_ > 0 && waitpid(pid_, &status_, 0) == pid_) {
+            pid_ = -1;
+        }
+        return WIFEXITED(status_) && WEXITSTATUS(status_) == 0;
+    }
+
+    void kill_process() {
+        if (pid_ > 0) {
+            kill(pid_, SIGTERM);
+            waitpid(pid_, &status_, 0);
+            pid_ = -1;
+        }
+    }
+
+private:
+    pid_t pid_ = -1;
+    int status_ = 0;
+};
+
+// Shared-memory channel plus the ISS feeding it. Once started, every exit
+// from main, including early error returns, stops the ISS and removes the
+// segment.
+class CosimSession {
+public:
+    ~CosimSession() { close(); }
+
+    bool start(const std::string& shm_name, const std::string& exe, const std::string& elf,
+               const std::string& plugin, const std::string& log_file) {
+        shm_name_ = shm_name;
+        channel_ = cosim_channel_create(shm_name_);
+        if (!channel_) {
+            return false;
+        }
+        if (!iss_.start(exe, elf, plugin, shm_name_, log_file)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Tells the ISS to stop publishing, kills it if it is still running and
+    // removes the channel. Idempotent.
+    void close() {
+        if (!channel_) {
+            return;
+        }
+        channel_->consumer_done.store(1, std::memory_order_release);
+        iss_.kill_process();
+        cosim_channel_unmap(channel_);
+        shm_unlink(shm_name_.c_str());
+        channel_ = nullptr;
+    }
+
+    CosimChannel* channel() const { return channel_; }
+    IssProcess& iss() { return iss_; }
+
+private:
+    std::string shm_name_;
+    CosimChannel* channel_ = nullptr;
+    IssProcess iss_;
+};
+
+// Compares RTL register writes (rd != x0) against the ISS stream. The ISS may
+// only run out once the RTL has retired the program's final instruction (its
+// ecall/ebreak or tohost store); writes the RTL makes after that, in a
+// fixed-cycle run, are not compared.
+class CosimStreamChecker {
+public:
+    CosimStreamChecker(CosimChannel* channel, IssProcess& iss) : channel_(channel), iss_(iss) {}
+
+    // Returns false on mismatch, or if the ISS ended while the RTL was still
+    // running the program (rtl_ended false).
+    bool check(uint32_t rd, uint64_t value, bool rtl_ended) {
+        if (iss_finished_) {
+            return true;
+        }
+        CosimRegWrite ref;
+        if (!next(ref)) {
+            iss_finished_ = true;
+            if (!rtl_ended) {
+                std::cerr << "VERILOG SIM ERROR: The ISS ended after " << compared_ << " register writes, before the RTL"
+                          << " retired the program's final instruction (next RTL write: x" << std::dec << rd << " = 0x"
+                          << std::hex << std::setw(16) << std::setfill('0') << value << std::dec << ")." << std::endl;
+                return false;
+            }
+            return true;
+        }
+        ++compared_;
+        if (ref.rd != rd || ref.value != value) {
+            std::cerr << "VERILOG SIM ERROR: Co-simulation mismatch at register write " << compared_ << ":" << std::endl;
+            std::cerr << "  RTL: x" << std::dec << rd << " = 0x" << std::hex << std::setw(16) << std::setfill('0') << value << std::endl;
+            std::cerr << "  ISS: x" << std::dec << ref.rd << " = 0x" << std::hex << std::setw(16) << std::setfill('0') << ref.value << std::dec << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool iss_finished() const { return iss_finished_; }
+    uint64_t compared() const { return compared_; }
+
+    // End-of-run check, after the ISS has exited: a run that compared nothing
+    // proves nothing, and in a run to the program's end (until_exit) any write
+    // still in the ring is one the RTL never made.
+    bool finish(bool until_exit) {
+        if (compared_ == 0) {
+            std::cerr << "VERILOG SIM ERROR: No register writes were compared against the ISS." << std::endl;
+            return false;
+        }
+        CosimRegWrite ref;
+        uint64_t left = 0;
+        while (channel_->ring.try_pop(ref)) {
+            if (left++ == 0 && until_exit) {
+                std::cerr << "VERILOG SIM ERROR: The program ended after " << compared_ << " register writes, but the ISS"
+                          << " made more (next ISS write: x" << std::dec << ref.rd << " = 0x" << std::hex
+                          << std::setw(16) << std::setfill('0') << ref.value << std::dec << ")." << std::endl;
+            }
+        }
+        return !until_exit || left == 0;
+    }
+
+private:
+    bool next(CosimRegWrite& ref) {
+        while (!channel_->ring.try_pop(ref)) {
+            if (channel_->producer_done.load(std::memory_order_acquire) || iss_.exited()) {
+                return channel_->ring.try_pop(ref); // Drain what was published before exit
+            }
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    CosimChannel* channel_;
+    IssProcess& iss_;
+    bool iss_finished_ = false;
+    uint64_t compared_ = 0;
+};
+
 int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
+    try {
+        G_PIPELINE_COSIM_TEST_CASE_NAME = tb_plusarg_string("TEST_NAME", "pipeline_cosim");
+        G_NUM_CYCLES_TO_RUN = static_cast<int>(tb_plusarg_u64("NUM_CYCLES", 0));
+        G_MAX_CYCLES = tb_plusarg_u64("MAX_CYCLES", TB_DEFAULT_MAX_CYCLES);
+        G_VERILOG_OUTPUT_FILE_PATH = tb_plusarg_string("VERILOG_OUTPUT_FILE", "");
+    } catch (const std::exception& e) {
+        std::cerr << "VERILOG SIM ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const std::string elf_file = tb_plusarg_string("ELF_FILE", "");
+    ElfImage elf_image;
+    if (!elf_file.empty() && !load_elf_image(elf_file, elf_image)) {
+        return 1;
+    }
+
+    const std::string iss_exe = tb_plusarg_string("ISS_EXE", "");
+    const bool streaming = !iss_exe.empty();
+    if (streaming == !G_VERILOG_OUTPUT_FILE_PATH.empty()) {
+        std::cerr << "VERILOG SIM ERROR: Pass exactly one of +VERILOG_OUTPUT_FILE or +ISS_EXE." << std::endl;
+        return 1;
+    }
+    if (streaming && elf_file.empty()) {
+        std::cerr << "VERILOG SIM ERROR: +ISS_EXE requires +ELF_FILE." << std::endl;
+        return 1;
+    }
+
+    const std::string shm_name = tb_plusarg_string("COSIM_SHM", "/riscv_cosim_" + std::to_string(getpid()));
+    CosimSession cosim;
+    if (streaming && !cosim.start(shm_name, iss_exe, elf_file, tb_plusarg_string("ISS_PLUGIN", ""),
+                                  tb_plusarg_string("ISS_LOG", ""))) {
+        return 1;
+    }
+    IssProcess& iss = cosim.iss();
+    CosimStreamChecker checker(cosim.channel(), iss);
+
+    // Both trace outputs are written by background threads (async_trace_sink.h);
+    // the simulation loop only copies raw records into their rings.
+    retire_trace::Writer retire_trace_writer;
+    AsyncTraceSink<retire_trace::Record> retire_trace_sink;
+    const std::string retire_trace_file = tb_plusarg_string("RETIRE_TRACE_FILE", "");
+    if (!retire_trace_file.empty()) {
+        if (!retire_trace_writer.open(retire_trace_file, retire_trace::FIELD_ALL)) {
+            return 1;
+        }
+        retire_trace_sink.open([&retire_trace_writer](const retire_trace::Record& rec) { retire_trace_writer.write(rec); });
+    }
+
     Vpipeline* top = new Vpipeline;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    std::string vcd_file_name = G_PIPELINE_COSIM_TEST_CASE_NAME + "_cosim_verilog_tb.vcd";
-    tfp->open(vcd_file_name.c_str());
+    TbTrace trace(top, G_PIPELINE_COSIM_TEST_CASE_NAME + "_cosim_verilog_tb", "pipeline");
 
     std::cout << "VERILOG SIM: Starting Co-simulation Test Case: " << G_PIPELINE_COSIM_TEST_CASE_NAME << std::endl;
-    std::cout << "VERILOG SIM: Number of cycles to run: " << G_NUM_CYCLES_TO_RUN << std::endl;
-    std::cout << "VERILOG SIM: Output file: " << G_VERILOG_OUTPUT_FILE_PATH << std::endl;
+    const bool until_exit = G_NUM_CYCLES_TO_RUN == 0;
+    if (until_exit) {
+        std::cout << "VERILOG SIM: Running until the program ends (at most " << G_MAX_CYCLES << " cycles)" << std::endl;
+    } else {
+        std::cout << "VERILOG SIM: Number of cycles to run: " << G_NUM_CYCLES_TO_RUN << std::endl;
+    }
+    if (streaming) {
+        std::cout << "VERILOG SIM: Comparing against ISS through " << shm_name << std::endl;
+    } else {
+        std::cout << "VERILOG SIM: Output file: " << G_VERILOG_OUTPUT_FILE_PATH << std::endl;
+    }
 
-    std::ofstream verilog_output_file(G_VERILOG_OUTPUT_FILE_PATH, std::ios::out | std::ios::trunc);
-    if (!verilog_output_file.is_open()) {
-        std::cerr << "VERILOG SIM ERROR: Could not open output file: " << G_VERILOG_OUTPUT_FILE_PATH << std::endl;
-        if (tfp) tfp->close();
-        delete top;
-        return 1;
+    std::ofstream verilog_output_file;
+    AsyncTraceSink<uint64_t> verilog_output_sink;
+    if (!streaming) {
+        verilog_output_file.open(G_VERILOG_OUTPUT_FILE_PATH, std::ios::out | std::ios::trunc);
+        if (!verilog_output_file.is_open()) {
+            std::cerr << "VERILOG SIM ERROR: Could not open output file: " << G_VERILOG_OUTPUT_FILE_PATH << std::endl;
+            trace.close();
+            delete top;
+            return 1;
+        }
+        verilog_output_file << std::hex << std::setfill('0');
+        verilog_output_sink.open([&verilog_output_file](const uint64_t& value) {
+            verilog_output_file << std::setw(16) << value << '\n';
+        });
     }
 
     top->rst_n = 0;
+    top->eval(); // Run initial blocks before the backdoor load overwrites memories
+    if (!elf_file.empty()) {
+        if (!backdoor_load_instr_mem(top, elf_image)) {
+            trace.close();
+            delete top;
+            return 1;
+        }
+        if (!tb_has_plusarg("PC_START_ADDR")) {
+            backdoor_set_pc_start(top, elf_image.entry);
+        }
+    }
+
     for(int i=0; i<2; ++i) {
-        top->clk = 0; top->eval(); if (tfp) tfp->dump(sim_time); sim_time++;
-        top->clk = 1; top->eval(); if (tfp) tfp->dump(sim_time); sim_time++;
+        top->clk = 0; top->eval(); trace.dump(sim_time); sim_time++;
+        top->clk = 1; top->eval(); trace.dump(sim_time); sim_time++;
     }
     top->rst_n = 1;
-    top->clk = 0; top->eval(); if (tfp) tfp->dump(sim_time); sim_time++;
-    top->clk = 1; top->eval(); if (tfp) tfp->dump(sim_time); sim_time++;
+    top->clk = 0; top->eval(); trace.dump(sim_time); sim_time++;
+    top->clk = 1; top->eval(); trace.dump(sim_time); sim_time++;
 
+    if (!elf_file.empty() && !backdoor_load_data_mem(top, elf_image)) { // Reset clears data memory
+        trace.close();
+        delete top;
+        return 1;
+    }
     std::cout << "VERILOG SIM: Reset complete." << std::endl;
 
-    for (int cycle = 0; cycle < G_NUM_CYCLES_TO_RUN; ++cycle) {
-        tick(top, tfp, verilog_output_file);
+    int exit_code = 0;
+    TbExitMonitor program_exit(tb_tohost_address(elf_file));
+    pipeline_events::Counters events;
+    const uint64_t last_cycle = until_exit ? G_MAX_CYCLES : static_cast<uint64_t>(G_NUM_CYCLES_TO_RUN);
+    uint64_t cycle = 0;
+    for (; cycle < last_cycle; ++cycle) {
+        trace.on_cycle(cycle, top->debug_pc_f);
+        tick(top, trace, verilog_output_sink);
+        events.sample(top);
+        bool ended = false;
+        if (top->rvfi_valid) {
+            const RetireRecord retired = retire_record_from_model(top);
+            if (retire_trace_sink.is_open()) {
+                retire_trace_sink.push(retire_trace::make_record(cycle, retired));
+            }
+            // Fed in fixed-cycle runs too, so the checker knows where the program ends
+            ended = program_exit.on_retire(retired) && until_exit;
+        }
+        if (streaming && top->debug_reg_write_wb && top->debug_rd_addr_wb != 0) {
+            if (!checker.check(top->debug_rd_addr_wb, top->debug_result_w, program_exit.finished())) {
+                exit_code = 1;
+                for (uint64_t extra = trace.on_mismatch(cycle), c = cycle + 1; extra > 0; --extra, ++c) {
+                    trace.on_cycle(c, top->debug_pc_f);
+                    tick(top, trace, verilog_output_sink);
+                }
+                break;
+            }
+            if (checker.iss_finished()) {
+                break;
+            }
+        }
+        if (ended) {
+            ++cycle;
+            break;
+        }
+    }
+
+    std::cout << "VERILOG SIM: Simulation finished after " << cycle << " cycles." << std::endl;
+    std::cout << "VERILOG SIM: " << events.summary() << std::endl;
+    const std::string event_report = tb_plusarg_string("EVENT_REPORT", "");
+    if (!event_report.empty() && !events.write(event_report)) {
+        exit_code = 1;
+    }
+    if (until_exit && exit_code == 0) {
+        if (program_exit.finished()) {
+            std::cout << "VERILOG SIM: Program ended (" << program_exit.reason() << ") with exit code "
+                      << program_exit.exit_value() << std::endl;
+            exit_code = program_exit.exit_code();
+        } else {
+            std::cerr << "VERILOG SIM ERROR: TIMEOUT: The program did not end within " << G_MAX_CYCLES << " cycles." << std::endl;
+            exit_code = 1;
+        }
     }
 
-    std::cout << "VERILOG SIM: Simulation finished after " << G_NUM_CYCLES_TO_RUN << " cycles." << std::endl;
+    if (streaming) {
+        cosim.channel()->consumer_done.store(1, std::memory_order_release);
+        if (exit_code != 0) {
+            iss.kill_process();
+        } else if (!iss.wait()) {
+            std::cerr << "VERILOG SIM ERROR: ISS process failed." << std::endl;
+            exit_code = 1;
+        } else if (!checker.finish(until_exit)) {
+            exit_code = 1;
+        } else {
+            std::cout << "VERILOG SIM: " << checker.compared() << " register writes match the ISS." << std::endl;
+        }
+        cosim.close();
+    }
 
+    verilog_output_sink.close();
     if (verilog_output_file.is_open()) {
         verilog_output_file.close();
     }
-    if (tfp) {
-        tfp->close();
-    }
+    retire_trace_sink.close();
+    retire_trace_writer.close();
+    trace.close();
     delete top;
-    return 0;
+    return exit_code;
 }
\ No newline at end of file
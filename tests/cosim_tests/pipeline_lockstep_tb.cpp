@@ -0,0 +1,182 @@
+#include "Vpipeline.h"
+#include "verilated.h"
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "tb_args.h"
+#include "tb_trace.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "retire_record.h"
+#include "retire_trace.h"
+#include "tb_exit.h"
+#include "pipeline_events.h"
+#include "iss_hart.h"
+
+// In-process lock-step co-simulation: the ISS hart is stepped once for every
+// instruction the RTL retires and both results are compared immediately.
+//   +TEST_NAME=<name> +ELF_FILE=<elf> +MAX_CYCLES=<n> (+NUM_CYCLES is accepted too)
+//   +RETIRE_TRACE_FILE=<path> +ISS_TRACE_FILE=<path>  optional binary traces of
+//       both sides (retire_trace.h) for offline inspection with retire_trace_diff
+//   +EVENT_REPORT=<path>  hazard/dispatch counters (pipeline_events.h)
+// Exits with 1 at the first divergence or when MAX_CYCLES pass first. The run
+// ends when the ISS reaches the end of the program (SYSTEM instruction or PC
+// outside the image) or the RTL signals the end (tb_exit.h); an ecall, ebreak
+// or tohost exit passes the program's exit code on.
+std::string G_LOCKSTEP_TEST_CASE_NAME;
+uint64_t G_MAX_CYCLES = 0;
+
+vluint64_t sim_time = 0;
+
+double sc_time_stamp() {
+    return sim_time;
+}
+
+void tick(Vpipeline* top, TbTrace& trace) {
+    top->clk = 0;
+    top->eval();
+    trace.dump(sim_time);
+    sim_time++;
+
+    top->clk = 1;
+    top->eval();
+    trace.dump(sim_time);
+    sim_time++;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    std::string elf_file;
+    try {
+        G_LOCKSTEP_TEST_CASE_NAME = tb_plusarg_string("TEST_NAME", "pipeline_lockstep");
+        G_MAX_CYCLES = tb_plusarg_u64("MAX_CYCLES", tb_plusarg_u64("NUM_CYCLES", TB_DEFAULT_MAX_CYCLES));
+        elf_file = tb_require_plusarg("ELF_FILE");
+    } catch (const std::exception& e) {
+        std::cerr << "LOCKSTEP ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    ElfImage elf_image;
+    if (!load_elf_image(elf_file, elf_image)) {
+        return 1;
+    }
+    IssHart iss(elf_file);
+
+    retire_trace::Writer rtl_trace, iss_trace;
+    const std::string rtl_trace_file = tb_plusarg_string("RETIRE_TRACE_FILE", "");
+    const std::string iss_trace_file = tb_plusarg_string("ISS_TRACE_FILE", "");
+    if ((!rtl_trace_file.empty() && !rtl_trace.open(rtl_trace_file, retire_trace::FIELD_ALL)) ||
+        (!iss_trace_file.empty() && !iss_trace.open(iss_trace_file, retire_trace::FIELD_ALL & ~retire_trace::FIELD_CYCLE))) {
+        return 1;
+    }
+
+    Vpipeline* top = new Vpipeline;
+
+    TbTrace trace(top, G_LOCKSTEP_TEST_CASE_NAME + "_lockstep", "pipeline");
+
+    std::cout << "LOCKSTEP: Starting test case: " << G_LOCKSTEP_TEST_CASE_NAME << std::endl;
+
+    top->rst_n = 0;
+    top->eval(); // Run initial blocks before the backdoor load overwrites memories
+    if (!backdoor_load_instr_mem(top, elf_image)) {
+        trace.close();
+        delete top;
+        return 1;
+    }
+    backdoor_set_pc_start(top, elf_image.entry);
+
+    for (int i = 0; i < 2; ++i) {
+        tick(top, trace);
+    }
+    top->rst_n = 1;
+    tick(top, trace);
+
+    if (!backdoor_load_data_mem(top, elf_image)) { // Reset clears data memory
+        trace.close();
+        delete top;
+        return 1;
+    }
+
+    int exit_code = 0;
+    TbExitMonitor program_exit(tb_tohost_address(elf_file));
+    pipeline_events::Counters events;
+    uint64_t retired = 0;
+    bool iss_done = false;
+    uint64_t cycle = 0;
+    for (; cycle < G_MAX_CYCLES && !iss_done; ++cycle) {
+        trace.on_cycle(cycle, top->debug_pc_f);
+        tick(top, trace);
+        events.sample(top);
+        if (!top->rvfi_valid) {
+            continue;
+        }
+
+        const RetireRecord rtl = retire_record_from_model(top);
+        if (rtl_trace.is_open()) {
+            rtl_trace.write(retire_trace::make_record(cycle, rtl));
+        }
+        program_exit.on_retire(rtl);
+        uint32_t instr = 0;
+        if (!iss.next_instr(elf_image, instr)) {
+            iss_done = true;
+            if (rtl.pc != iss.pc()) {
+                std::cerr << "LOCKSTEP FAIL: RTL retired pc=0x" << std::hex << rtl.pc
+                          << " after the ISS finished at pc=0x" << iss.pc() << std::dec << std::endl;
+                exit_code = 1;
+            }
+            break;
+        }
+
+        RetireRecord ref = iss.step(instr);
+        if (adopt_csr_read(rtl, ref)) {
+            iss.set_reg(ref.rd, ref.rd_value);
+        }
+        if (iss_trace.is_open()) {
+            iss_trace.write(retire_trace::make_record(retired, ref));
+        }
+        const std::string diff = diff_retire_records(rtl, ref);
+        if (!diff.empty()) {
+            std::cerr << "LOCKSTEP FAIL: " << diff << " at instruction " << retired
+                      << " (cycle " << cycle << ")" << std::endl;
+            std::cerr << "  RTL: " << format_retire_record(rtl) << std::endl;
+            std::cerr << "  ISS: " << format_retire_record(ref) << std::endl;
+            exit_code = 1;
+            for (uint64_t extra = trace.on_mismatch(cycle), c = cycle + 1; extra > 0; --extra, ++c) {
+                trace.on_cycle(c, top->debug_pc_f);
+                tick(top, trace);
+            }
+            break;
+        }
+        ++retired;
+        if (program_exit.finished()) { // tohost store, compared above
+            iss_done = true;
+            break;
+        }
+    }
+
+    if (exit_code == 0) {
+        if (!iss_done) {
+            std::cerr << "LOCKSTEP FAIL: TIMEOUT: the program did not end within " << G_MAX_CYCLES << " cycles, "
+                      << retired << " instructions matched." << std::endl;
+            exit_code = 1;
+        } else if (program_exit.finished() && program_exit.exit_code() != 0) {
+            std::cerr << "LOCKSTEP FAIL: program ended (" << program_exit.reason() << ") with exit code "
+                      << program_exit.exit_value() << " after " << retired << " matched instructions." << std::endl;
+            exit_code = program_exit.exit_code();
+        } else {
+            std::cout << "LOCKSTEP PASS: " << retired << " instructions matched in " << cycle << " cycles." << std::endl;
+        }
+    }
+
+    std::cout << "LOCKSTEP: " << events.summary() << std::endl;
+    const std::string event_report = tb_plusarg_string("EVENT_REPORT", "");
+    if (!event_report.empty() && !events.write(event_report)) {
+        exit_code = 1;
+    }
+
+    trace.close();
+    delete top;
+    return exit_code;
+}
@@ -0,0 +1,49 @@
+# Runs a co-simulation testbench once per program in a manifest written by
+# tools/hazard_progen ("<name> <elf> <num_cycles>" per line) and fails if any
+# program fails. Programs end with ecall; num_cycles is only their timeout. Invoked with cmake -P:
+#   -DTB_EXE=<Vpipeline>         co-simulation or lock-step testbench
+#   -DMANIFEST=<file>            program manifest
+#   -DWORK_DIR=<dir>             per-program logs go here
+#   -DISS_EXE=<simulator>        optional: run the ISS as a separate process
+#   -DISS_PLUGIN=<plugin .so>    (pipeline_cosim_tb only)
+
+foreach(var TB_EXE MANIFEST WORK_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "run_program_manifest.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+file(STRINGS ${MANIFEST} MANIFEST_LINES REGEX "^[^#]")
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(FAILED "")
+set(PASSED 0)
+foreach(line IN LISTS MANIFEST_LINES)
+    separate_arguments(fields UNIX_COMMAND "${line}")
+    list(GET fields 0 name)
+    list(GET fields 1 program)
+    list(GET fields 2 num_cycles)
+
+    set(ARGS "+TEST_NAME=${name}" "+ELF_FILE=${program}" "+MAX_CYCLES=${num_cycles}")
+    if(ISS_EXE)
+        list(APPEND ARGS "+ISS_EXE=${ISS_EXE}" "+ISS_PLUGIN=${ISS_PLUGIN}" "+ISS_LOG=${WORK_DIR}/${name}_iss.txt")
+    endif()
+    execute_process(
+        COMMAND ${TB_EXE} ${ARGS}
+        WORKING_DIRECTORY ${WORK_DIR}
+        RESULT_VARIABLE result
+        OUTPUT_FILE ${WORK_DIR}/${name}.log
+        ERROR_FILE ${WORK_DIR}/${name}.log
+    )
+    if(result EQUAL 0)
+        math(EXPR PASSED "${PASSED} + 1")
+    else()
+        list(APPEND FAILED ${name})
+    endif()
+endforeach()
+
+list(LENGTH FAILED NUM_FAILED)
+message(STATUS "Random programs: ${PASSED} passed, ${NUM_FAILED} failed")
+if(NUM_FAILED GREATER 0)
+    list(JOIN FAILED " " FAILED_NAMES)
+    message(FATAL_ERROR "Failing programs (logs in ${WORK_DIR}): ${FAILED_NAMES}")
+endif()
@@ -0,0 +1,366 @@
+// tests/fuzz/pipeline_fuzz.h
+#ifndef PIPELINE_FUZZ_H
+#define PIPELINE_FUZZ_H
+
+#include "retire_record.h"
+#include "rv64i_isa.h"
+#include "rv64i_model.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Model-independent parts of the pipeline fuzzer: input legalization and
+// mutation, the reference run, coverage bookkeeping and divergence
+// minimization. An input is a flat instruction stream placed at address 0.
+
+namespace fuzz {
+
+constexpr uint64_t DMEM_BYTES = 1024;       // rtl/core/data_memory.sv
+constexpr uint64_t ROM_BYTES = 4ULL << 20;  // rtl/core/instruction_memory.sv (fetch wraps above this)
+constexpr unsigned DRAIN_NOPS = 5;
+constexpr uint32_t ECALL = 0x00000073;
+
+using Input = std::vector<uint32_t>;
+
+const uint8_t OPCODES[] = {
+    rv64i::OPCODE_LUI, rv64i::OPCODE_AUIPC, rv64i::OPCODE_JAL, rv64i::OPCODE_JALR, rv64i::OPCODE_BRANCH,
+    rv64i::OPCODE_LOAD, rv64i::OPCODE_STORE, rv64i::OPCODE_OP_IMM, rv64i::OPCODE_OP,
+};
+constexpr unsigned NUM_OPCODES = sizeof(OPCODES) / sizeof(OPCODES[0]);
+
+// Index into OPCODES, or NUM_OPCODES for anything else (bubbles included).
+inline unsigned opcode_class(uint32_t instr) {
+    const uint8_t op = rv64i::opcode(instr);
+    for (unsigned i = 0; i < NUM_OPCODES; ++i) {
+        if (OPCODES[i] == op) {
+            return i;
+        }
+    }
+    return NUM_OPCODES;
+}
+
+// Initial register file of every run: small doubleword-aligned values in the
+// low half so loads and stores land in data memory, arbitrary ones above.
+inline void initial_registers(uint64_t (&regs)[32]) {
+    for (unsigned i = 0; i < 32; ++i) {
+        regs[i] = i == 0 ? 0 : (i < 16 ? i * 56 : 0x9E3779B97F4A7C15ULL * i);
+    }
+}
+
+// Maps any word onto an instruction both the RTL and the functional model
+// implement identically: supported opcodes only, valid funct3/funct7 for
+// each, word-aligned static control-flow offsets and data-memory-sized
+// load/store displacements. Field bits that are already legal are kept, so
+// bit-level mutations stay local.
+inline uint32_t legalize(uint32_t w) {
+    unsigned cls = opcode_class(w);
+    if (cls == NUM_OPCODES) {
+        cls = (w & 0x7F) % NUM_OPCODES;
+    }
+    w = (w & ~0x7Fu) | OPCODES[cls];
+    const uint8_t f3 = rv64i::funct3(w);
+    auto set_f3 = [&](uint8_t v) { w = (w & ~(0x7u << 12)) | (static_cast<uint32_t>(v) << 12); };
+    switch (OPCODES[cls]) {
+        case rv64i::OPCODE_JAL:
+            w &= ~(1u << 21); // imm[1]
+            break;
+        case rv64i::OPCODE_JALR:
+            set_f3(0);
+            break;
+        case rv64i::OPCODE_BRANCH:
+            if (f3 == 0b010 || f3 == 0b011) set_f3(f3 | 0x4);
+            w &= ~(1u << 8); // imm[1]
+            break;
+        case rv64i::OPCODE_LOAD:
+        case rv64i::OPCODE_STORE: {
+            if (OPCODES[cls] == rv64i::OPCODE_STORE) {
+                set_f3(f3 & 0x3);
+            } else if (f3 == 0b111) {
+                set_f3(0b011); // No ldu
+            }
+            const unsigned width = rv64i::funct3(w) & 0x3;
+            int64_t imm = OPCODES[cls] == rv64i::OPCODE_LOAD ? rv64i::imm_i(w) : rv64i::imm_s(w);
+            imm &= static_cast<int64_t>((DMEM_BYTES - 1) & ~((1u << width) - 1));
+            w = OPCODES[cls] == rv64i::OPCODE_LOAD
+                    ? rv64i::encode_i(rv64i::OPCODE_LOAD, rv64i::rd(w), rv64i::funct3(w), rv64i::rs1(w), imm)
+                    : rv64i::encode_s(rv64i::OPCODE_STORE, rv64i::funct3(w), rv64i::rs1(w), rv64i::rs2(w), imm);
+            break;
+        }
+        case rv64i::OPCODE_OP_IMM:
+            if (f3 == 0b001) w &= ~(0x3Fu << 26);
+            if (f3 == 0b101) w &= ~(0x2Fu << 26); // Keep imm[10] (srai)
+            break;
+        case rv64i::OPCODE_OP: {
+            const bool alt_ok = f3 == 0b000 || f3 == 0b101;
+            w = (w & ~(0x7Fu << 25)) | (alt_ok ? (w & (0x20u << 25)) : 0);
+            break;
+        }
+        default:
+            break;
+    }
+    return w;
+}
+
+// Applies 1-4 random mutations and legalizes the result. `corpus` supplies
+// splice donors.
+inline Input mutate(const Input& parent, const std::vector<Input>& corpus, size_t max_len, std::mt19937_64& rng) {
+    Input child = parent;
+    auto below = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    for (unsigned n = 1 + below(4); n > 0; --n) {
+        const size_t size = child.size();
+        switch (below(8)) {
+            case 0: // Bit flip
+                if (size) child[below(size)] ^= 1u << below(32);
+                break;
+            case 1: // New register field (small numbers collide more)
+                if (size) {
+                    static const unsigned shifts[] = {7, 15, 20};
+                    const unsigned shift = shifts[below(3)];
+                    child[below(size)] = (child[below(size)] & ~(0x1Fu << shift)) | (static_cast<uint32_t>(below(8)) << shift);
+                }
+                break;
+            case 2: // Random word
+                if (size) child[below(size)] = static_cast<uint32_t>(rng());
+                break;
+            case 3: // Insert a random word
+                if (size < max_len) child.insert(child.begin() + below(size + 1), static_cast<uint32_t>(rng()));
+                break;
+            case 4: // Delete
+                if (size > 1) child.erase(child.begin() + below(size));
+                break;
+            case 5: // Duplicate a word
+                if (size && size < max_len) {
+                    const size_t i = below(size);
+                    child.insert(child.begin() + i, child[i]);
+                }
+                break;
+            case 6: // Swap neighbours
+                if (size > 1) {
+                    const size_t i = below(size - 1);
+                    std::swap(child[i], child[i + 1]);
+                }
+                break;
+            default: { // Splice in a run from another input
+                const Input& donor = corpus[below(corpus.size())];
+                if (!donor.empty() && size < max_len) {
+                    const size_t from = below(donor.size());
+                    const size_t count = std::min<size_t>({1 + below(8), donor.size() - from, max_len - size});
+                    child.insert(child.begin() + below(size + 1), donor.begin() + from, donor.begin() + from + count);
+                }
+                break;
+            }
+        }
+    }
+    if (child.empty()) {
+        child.push_back(static_cast<uint32_t>(rng()));
+    }
+    for (uint32_t& word : child) {
+        word = legalize(word);
+    }
+    return child;
+}
+
+// One pass of reference_run(). Sets `restart` when it patched an
+// instruction that had already executed.
+inline void run_reference(rv64i::FunctionalModel& model, uint64_t max_retire, Input& program,
+                          std::vector<bool>& executed, std::vector<RetireRecord>& expected, bool& restart) {
+    while (expected.size() < max_retire) {
+        const uint64_t pc = model.pc;
+        uint32_t instr = model.fetch(pc);
+        const uint64_t base = model.regs[rv64i::rs1(instr)];
+        bool patch = false;
+        switch (rv64i::opcode(instr)) {
+            case rv64i::OPCODE_LOAD:
+            case rv64i::OPCODE_STORE: {
+                const unsigned bytes = rv64i::mem_access_bytes(instr);
+                const int64_t imm = rv64i::opcode(instr) == rv64i::OPCODE_LOAD ? rv64i::imm_i(instr) : rv64i::imm_s(instr);
+                const uint64_t addr = base + static_cast<uint64_t>(imm);
+                patch = addr % bytes != 0 || addr >= DMEM_BYTES || addr + bytes > DMEM_BYTES;
+                break;
+            }
+            case rv64i::OPCODE_JALR: {
+                const uint64_t target = (base + static_cast<uint64_t>(rv64i::imm_i(instr))) & ~1ULL;
+                patch = target % 4 != 0 || target >= ROM_BYTES;
+                break;
+            }
+            case rv64i::OPCODE_JAL:
+                patch = pc + static_cast<uint64_t>(rv64i::imm_j(instr)) >= ROM_BYTES;
+                break;
+            case rv64i::OPCODE_BRANCH:
+                patch = pc + static_cast<uint64_t>(rv64i::imm_b(instr)) >= ROM_BYTES;
+                break;
+            default:
+                break;
+        }
+        const bool in_program = pc / 4 < program.size();
+        if (patch && in_program) {
+            program[pc / 4] = rv64i::FunctionalModel::NOP;
+            if (executed[pc / 4]) {
+                restart = true;
+                return;
+            }
+            instr = rv64i::FunctionalModel::NOP;
+            model.set_instr(pc, instr);
+        }
+        if (in_program) {
+            executed[pc / 4] = true;
+        }
+
+        RetireRecord record;
+        record.pc = pc;
+        record.instr = instr;
+        if (rv64i::opcode(instr) == rv64i::OPCODE_STORE) {
+            record.mem_write = true;
+            record.mem_addr = base + static_cast<uint64_t>(rv64i::imm_s(instr));
+            record.mem_wdata = rv64i::mask_to_bytes(model.regs[rv64i::rs2(instr)], rv64i::mem_access_bytes(instr));
+        }
+        if (!model.step()) {
+            break; // ecall
+        }
+        if (rv64i::writes_rd(instr)) {
+            record.rd_write = true;
+            record.rd = rv64i::rd(instr);
+            record.rd_value = model.regs[record.rd];
+        }
+        expected.push_back(record);
+    }
+}
+
+// The program actually simulated: the input, a NOP drain and ecall, with
+// instructions whose dynamic behaviour the RTL does not model identically
+// (out-of-range or misaligned data accesses, jumps outside the ROM) patched
+// to NOPs during the reference run. `expected` receives one record per
+// retired instruction, up to `max_retire`.
+inline void reference_run(const Input& input, uint64_t max_retire, Input& program, std::vector<RetireRecord>& expected) {
+    program = input;
+    program.insert(program.end(), DRAIN_NOPS, rv64i::FunctionalModel::NOP);
+    program.push_back(ECALL);
+    expected.clear();
+
+    // A patch applies from the start of the program: when the instruction
+    // already ran unpatched, the run restarts.
+    std::vector<bool> executed;
+    bool restart = true;
+    while (restart) {
+        restart = false;
+        executed.assign(program.size(), false);
+        expected.clear();
+        rv64i::FunctionalModel model(program.size(), DMEM_BYTES);
+        for (size_t i = 0; i < program.size(); ++i) {
+            model.set_instr(i * 4, program[i]);
+        }
+        initial_registers(model.regs);
+        model.pc = 0;
+        run_reference(model, max_retire, program, executed, expected, restart);
+    }
+}
+
+// Per-run event counts, bucketed AFL-style into a global feature set.
+class Coverage {
+public:
+    // Hazard decisions (forward_a, forward_b, stall, flush_d, flush_e) crossed
+    // with the opcode in EX; then opcode/funct3/alt of every retired instruction.
+    static constexpr unsigned HAZARD_IDS = 128 * (NUM_OPCODES + 1);
+    static constexpr unsigned RETIRE_IDS = NUM_OPCODES * 8 * 2;
+    static constexpr unsigned NUM_IDS = HAZARD_IDS + RETIRE_IDS;
+
+    Coverage() : counts_(NUM_IDS, 0), seen_(NUM_IDS, 0) {}
+
+    void clear_run() { std::fill(counts_.begin(), counts_.end(), 0); }
+
+    void on_cycle(uint32_t instr_ex, unsigned forward_a, unsigned forward_b, bool stall, bool flush_d, bool flush_e) {
+        const unsigned hazard = (forward_a & 3) | ((forward_b & 3) << 2) | (stall << 4) | (flush_d << 5) | (flush_e << 6);
+        ++counts_[hazard * (NUM_OPCODES + 1) + opcode_class(instr_ex)];
+    }
+
+    void on_retire(uint32_t instr) {
+        const unsigned cls = opcode_class(instr);
+        if (cls == NUM_OPCODES) {
+            return;
+        }
+        const unsigned alt = (rv64i::funct7(instr) >> 5) & 1;
+        ++counts_[HAZARD_IDS + (cls * 8 + rv64i::funct3(instr)) * 2 + alt];
+    }
+
+    // Merges this run into the global set; true if it hit anything new.
+    bool merge_run() {
+        bool new_coverage = false;
+        for (unsigned id = 0; id < NUM_IDS; ++id) {
+            if (counts_[id] == 0) {
+                continue;
+            }
+            const uint8_t bit = bucket(counts_[id]);
+            if (!(seen_[id] & bit)) {
+                seen_[id] |= bit;
+                ++features_;
+                new_coverage = true;
+            }
+        }
+        return new_coverage;
+    }
+
+    uint64_t features() const { return features_; }
+
+    // Hazard combinations (ignoring the EX opcode) seen so far, out of 128.
+    unsigned hazard_combinations() const {
+        unsigned combos = 0;
+        for (unsigned hazard = 0; hazard < 128; ++hazard) {
+            for (unsigned cls = 0; cls <= NUM_OPCODES; ++cls) {
+                if (seen_[hazard * (NUM_OPCODES + 1) + cls]) {
+                    ++combos;
+                    break;
+                }
+            }
+        }
+        return combos;
+    }
+
+private:
+    static uint8_t bucket(uint32_t count) {
+        if (count <= 3) return static_cast<uint8_t>(1u << (count - 1));
+        if (count <= 7) return 1u << 3;
+        if (count <= 15) return 1u << 4;
+        if (count <= 31) return 1u << 5;
+        if (count <= 127) return 1u << 6;
+        return 1u << 7;
+    }
+
+    std::vector<uint32_t> counts_;
+    std::vector<uint8_t>  seen_;
+    uint64_t              features_ = 0;
+};
+
+// Shrinks a diverging input while `diverges` still holds: removes chunks of
+// halving size, then replaces the remaining instructions with NOPs.
+inline Input minimize(Input input, const std::function<bool(const Input&)>& diverges) {
+    for (size_t chunk = std::max<size_t>(input.size() / 2, 1); chunk > 0; chunk /= 2) {
+        for (size_t start = 0; start < input.size() && input.size() > 1;) {
+            Input candidate = input;
+            candidate.erase(candidate.begin() + start,
+                            candidate.begin() + std::min(start + chunk, candidate.size()));
+            if (!candidate.empty() && diverges(candidate)) {
+                input = std::move(candidate);
+            } else {
+                start += chunk;
+            }
+        }
+    }
+    for (uint32_t& word : input) {
+        if (word == rv64i::FunctionalModel::NOP) {
+            continue;
+        }
+        const uint32_t saved = word;
+        word = rv64i::FunctionalModel::NOP;
+        if (!diverges(input)) {
+            word = saved;
+        }
+    }
+    return input;
+}
+
+} // namespace fuzz
+
+#endif // PIPELINE_FUZZ_H
@@ -0,0 +1,293 @@
+#include "Vpipeline.h"
+#include "verilated.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tb_args.h"
+#include "pipeline_backdoor.h"
+#include "hazard_progen.h"
+#include "pipeline_fuzz.h"
+#include "rvfi_check.h"
+
+// Coverage-guided mutation fuzzer. Instruction streams are mutated, run on one
+// reused pipeline model and checked retirement by retirement against the
+// functional model and for rvfi_* port consistency (rvfi_check.h). Inputs that reach new hazard/opcode coverage join the
+// corpus; divergences are minimized and written out.
+//   +FUZZ_SEED=<n>           RNG seed (default 1)
+//   +FUZZ_EXECS=<n>          executions to run (default 100000)
+//   +FUZZ_SECONDS=<n>        stop after this long instead (0 = no limit)
+//   +FUZZ_MAX_LEN=<n>        instructions per input (default 64)
+//   +CORPUS_DIR=<dir>        seed inputs (*.bin, little-endian words); new
+//                            coverage is saved back here
+//   +CRASH_DIR=<dir>         where minimized divergences go (default .)
+//   +FUZZ_STOP_ON_DIVERGENCE stop at the first divergence
+// Exit status is 1 if any divergence was found.
+vluint64_t sim_time = 0;
+
+double sc_time_stamp() {
+    return sim_time;
+}
+
+namespace {
+
+inline void tick(Vpipeline* top) {
+    top->clk = 0;
+    top->eval();
+    sim_time++;
+    top->clk = 1;
+    top->eval();
+    sim_time++;
+}
+
+struct RunResult {
+    bool        diverged = false;
+    std::string message;
+};
+
+class FuzzTarget {
+public:
+    explicit FuzzTarget(Vpipeline* top) : top_(top) {
+        top_->rst_n = 0;
+        top_->eval(); // Default program; after this only the words we touch change
+        backdoor_clear_instr_mem(top_); // Unwritten words are NOPs, as in the reference model
+        fuzz::initial_registers(initial_regs_);
+    }
+
+    // Runs one input; coverage (if given) receives this run's events.
+    RunResult run(const fuzz::Input& input, size_t max_len, fuzz::Coverage* coverage) {
+        fuzz::reference_run(input, 8 * (max_len + fuzz::DRAIN_NOPS) + 64, program_, expected_);
+
+        auto& rom = backdoor_instr_mem(top_);
+        top_->rst_n = 0;
+        top_->eval();
+        for (size_t i = 0; i < loaded_words_; ++i) {
+            rom[i] = rv64i::FunctionalModel::NOP; // Back to the cleared state
+        }
+        for (size_t i = 0; i < program_.size(); ++i) {
+            rom[i] = program_[i];
+        }
+        loaded_words_ = program_.size();
+        backdoor_set_pc_start(top_, 0);
+        for (int i = 0; i < 2; ++i) {
+            tick(top_);
+        }
+        backdoor_load_registers(top_, initial_regs_);
+        top_->rst_n = 1;
+        tick(top_); // Data memory is cleared by reset
+
+        RunResult result;
+        rvfi_check::Checker rvfi(initial_regs_);
+        size_t retired = 0;
+        const uint64_t max_cycles = 4 * expected_.size() + 64;
+        for (uint64_t cycle = 0; cycle < max_cycles && retired < expected_.size(); ++cycle) {
+            tick(top_);
+            if (coverage) {
+                coverage->on_cycle(top_->debug_instr_ex, top_->debug_forward_a_ex, top_->debug_forward_b_ex,
+                                   top_->debug_stall_f, top_->debug_flush_d, top_->debug_flush_e);
+            }
+            if (!top_->rvfi_valid) {
+                continue;
+            }
+            const RetireRecord got = retire_record_from_model(top_);
+            const RetireRecord& exp = expected_[retired];
+            std::string diff = diff_retire_records(got, exp);
+            if (diff.empty()) {
+                diff = rvfi.check(top_);
+            }
+            if (!diff.empty()) {
+                result.diverged = true;
+                result.message = diff + " at retirement " + std::to_string(retired) + "\n  RTL:   " +
+                                 format_retire_record(got) + "\n  Model: " + format_retire_record(exp);
+                return result;
+            }
+            if (coverage) {
+                coverage->on_retire(got.instr);
+            }
+            ++retired;
+        }
+        if (retired < expected_.size()) {
+            result.diverged = true;
+            result.message = "RTL retired " + std::to_string(retired) + " of " + std::to_string(expected_.size()) +
+                             " instructions within " + std::to_string(max_cycles) + " cycles";
+        }
+        return result;
+    }
+
+    // The input as simulated by the last run (after reference patching).
+    fuzz::Input simulated_body() const {
+        return fuzz::Input(program_.begin(), program_.end() - fuzz::DRAIN_NOPS - 1);
+    }
+
+private:
+    Vpipeline*                top_;
+    uint64_t                  initial_regs_[32];
+    fuzz::Input               program_;
+    std::vector<RetireRecord> expected_;
+    size_t                    loaded_words_ = 0;
+};
+
+bool read_input(const std::filesystem::path& path, fuzz::Input& input) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    input.clear();
+    for (size_t i = 0; i + 4 <= raw.size(); i += 4) {
+        uint32_t word = 0;
+        for (int b = 0; b < 4; ++b) {
+            word |= static_cast<uint32_t>(static_cast<uint8_t>(raw[i + b])) << (8 * b);
+        }
+        input.push_back(fuzz::legalize(word));
+    }
+    return !input.empty();
+}
+
+void write_input(const std::string& path, const fuzz::Input& input) {
+    std::ofstream file(path, std::ios::binary);
+    for (uint32_t word : input) {
+        for (int b = 0; b < 4; ++b) {
+            file.put(static_cast<char>(word >> (8 * b)));
+        }
+    }
+}
+
+// Seeds an empty corpus with short hazard-pattern programs.
+std::vector<fuzz::Input> generated_seeds(size_t max_len, uint64_t seed) {
+    progen::Config config;
+    config.length = 8;
+    config.num_regs = 4;
+    config.text_base = 0;
+    progen::Generator generator(config);
+    std::vector<fuzz::Input> seeds;
+    for (uint64_t i = 0; i < 16; ++i) {
+        const ElfSegment& text = generator.generate(seed + i).image.segments.front();
+        fuzz::Input input;
+        for (size_t offset = 0; offset + 4 <= text.bytes.size() - 4 && input.size() < max_len; offset += 4) {
+            uint32_t word = 0;
+            for (int b = 0; b < 4; ++b) {
+                word |= static_cast<uint32_t>(text.bytes[offset + b]) << (8 * b);
+            }
+            input.push_back(fuzz::legalize(word));
+        }
+        seeds.push_back(input);
+    }
+    return seeds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    uint64_t seed = 0, max_execs = 0, max_seconds = 0, max_len = 0;
+    try {
+        seed = tb_plusarg_u64("FUZZ_SEED", 1);
+        max_execs = tb_plusarg_u64("FUZZ_EXECS", 100000);
+        max_seconds = tb_plusarg_u64("FUZZ_SECONDS", 0);
+        max_len = tb_plusarg_u64("FUZZ_MAX_LEN", 64);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    const std::string corpus_dir = tb_plusarg_string("CORPUS_DIR", "");
+    const std::string crash_dir = tb_plusarg_string("CRASH_DIR", ".");
+    const bool stop_on_divergence = tb_has_plusarg("FUZZ_STOP_ON_DIVERGENCE");
+    if (max_len == 0) {
+        std::cerr << "ERROR: +FUZZ_MAX_LEN must be positive." << std::endl;
+        return 1;
+    }
+
+    std::vector<fuzz::Input> seeds;
+    if (!corpus_dir.empty()) {
+        std::filesystem::create_directories(corpus_dir);
+        for (const auto& entry : std::filesystem::directory_iterator(corpus_dir)) {
+            fuzz::Input input;
+            if (entry.path().extension() == ".bin" && read_input(entry.path(), input)) {
+                seeds.push_back(input);
+            }
+        }
+    }
+    if (seeds.empty()) {
+        seeds = generated_seeds(max_len, seed);
+    }
+    std::filesystem::create_directories(crash_dir);
+
+    Vpipeline* top = new Vpipeline;
+    FuzzTarget target(top);
+    fuzz::Coverage coverage;
+    std::mt19937_64 rng(seed);
+    std::vector<fuzz::Input> corpus;
+    uint64_t execs = 0, divergences = 0;
+
+    auto handle_divergence = [&](const fuzz::Input& input, const RunResult& result) {
+        const fuzz::Input minimized = fuzz::minimize(input, [&](const fuzz::Input& candidate) {
+            return target.run(candidate, max_len, nullptr).diverged;
+        });
+        const RunResult final_result = target.run(minimized, max_len, nullptr);
+        const std::string base = crash_dir + "/divergence_" + std::to_string(seed) + "_" + std::to_string(divergences);
+        write_input(base + ".bin", minimized);
+        std::ofstream report(base + ".txt");
+        report << (final_result.diverged ? final_result.message : result.message) << "\n\nProgram (address: word):\n";
+        report << std::hex << std::setfill('0');
+        for (size_t i = 0; i < minimized.size(); ++i) {
+            report << std::setw(8) << i * 4 << ": " << std::setw(8) << minimized[i] << '\n';
+        }
+        ++divergences;
+        std::cout << "FUZZ: Divergence after " << execs << " executions, minimized from " << input.size() << " to "
+                  << minimized.size() << " instructions: " << base << ".txt\n  " << result.message << std::endl;
+    };
+
+    // Seed inputs are all kept, so corpus entries never shrink coverage.
+    for (const fuzz::Input& input : seeds) {
+        coverage.clear_run();
+        const RunResult result = target.run(input, max_len, &coverage);
+        ++execs;
+        coverage.merge_run();
+        corpus.push_back(target.simulated_body());
+        if (result.diverged) {
+            handle_divergence(input, result);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto last_report = start;
+    auto elapsed = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+    while (execs < max_execs && (max_seconds == 0 || elapsed() < max_seconds) && !(stop_on_divergence && divergences)) {
+        const fuzz::Input child = fuzz::mutate(corpus[rng() % corpus.size()], corpus, max_len, rng);
+        coverage.clear_run();
+        const RunResult result = target.run(child, max_len, &coverage);
+        ++execs;
+        if (result.diverged) {
+            handle_divergence(child, result);
+            continue;
+        }
+        if (coverage.merge_run()) {
+            corpus.push_back(target.simulated_body());
+            if (!corpus_dir.empty()) {
+                std::ostringstream name;
+                name << corpus_dir << "/" << std::hex << std::setfill('0') << std::setw(16) << seed << "_"
+                     << std::dec << corpus.size() << ".bin";
+                write_input(name.str(), corpus.back());
+            }
+        }
+        if (std::chrono::steady_clock::now() - last_report > std::chrono::seconds(2)) {
+            last_report = std::chrono::steady_clock::now();
+            std::cout << "FUZZ: " << execs << " execs (" << static_cast<uint64_t>(execs / elapsed()) << "/s), corpus "
+                      << corpus.size() << ", features " << coverage.features() << ", hazard combinations "
+                      << coverage.hazard_combinations() << "/128, divergences " << divergences << std::endl;
+        }
+    }
+
+    std::cout << "FUZZ: Done: " << execs << " execs in " << std::fixed << std::setprecision(1) << elapsed()
+              << " s, corpus " << corpus.size() << ", features " << coverage.features() << ", hazard combinations "
+              << coverage.hazard_combinations() << "/128, divergences " << divergences << std::endl;
+
+    top->final();
+    delete top;
+    return divergences ? 1 : 0;
+}
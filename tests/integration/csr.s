@@ -0,0 +1,47 @@
+.section .text
+.global _start
+
+# Zicsr through the pipeline. A csrr of mcycle returns the cycle its own
+# writeback lands on (its line in csr_expected.txt); CSR numbers are spelled
+# out because older assemblers lack some of the names.
+_start:
+    addi x1, x0, 1
+    csrrw x2, 0x323, x1         # mhpmevent3 = load-use stalls (x1 forwarded), old 0
+    csrrs x3, 0x323, x0         # read only
+    csrrw x0, 0xB03, x0         # mhpmcounter3 = 0
+
+    # Zero sources only read: a stray write would drop that cycle's increment
+    csrrsi x4, 0xB00, 0
+    csrrci x5, 0xB00, 0
+    csrrc x6, 0xB00, x0
+    csrrs x7, 0xB00, x0
+    addi x8, x7, 1              # CSR result forwarded from MEM
+    add x9, x0, x7              # and from WB
+
+    # Immediate forms; the write wins over that cycle's increment
+    csrrwi x10, 0xB00, 20
+    csrrs x11, 0xB00, x0        # 20
+    csrrsi x12, 0xB00, 3        # 21, writes 23
+    csrrci x13, 0xB00, 1        # 23, writes 22
+    csrrs x14, 0xB00, x0        # 22
+
+    # Register forms on minstret
+    addi x15, x0, 0x40
+    csrrw x16, 0xB02, x15       # 16 retired so far, writes 0x40
+    csrrs x17, 0xB02, x1        # 0x40, writes 0x41
+    csrrc x18, 0xB02, x1        # 0x41, writes 0x40
+    csrrs x19, 0xB02, x0        # 0x40
+    csrrs x20, 0xB02, x0        # 0x41
+
+    # Two load-use stalls for mhpmcounter3
+    addi x21, x0, 0x55
+    sd x21, 0x20(x0)
+    ld x22, 0x20(x0)
+    addi x23, x22, 1
+    ld x24, 0x20(x0)
+    add x25, x0, x24
+    csrrs x26, 0xC03, x0        # hpmcounter3 alias
+    csrrs x27, 0xB03, x0
+
+    addi x10, x0, 0
+    ecall
@@ -0,0 +1,16 @@
+.section .text
+.global _start
+
+_start:
+    ld x1, 0x100(x0)
+    ld x2, 0x108(x0)
+    add x3, x1, x2
+    ld x4, 0x110(x0)
+    ecall
+
+.section .data
+    .dword 0x1122334455667788
+    .dword 0x0000000000000010
+
+.section .bss
+    .zero 8
@@ -5,20 +5,4 @@ _start:
     addi x1, x0, 7
     sd x1, 0x30(x0)
     ld x2, 0x30(x0)
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
-    nop
\ No newline at end of file
+    ecall
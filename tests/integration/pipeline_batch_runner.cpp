@@ -0,0 +1,334 @@
+#include "Vpipeline.h"
+#include "verilated.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tb_args.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "expected_wd3.h"
+#include "tb_exit.h"
+#include "pipeline_events.h"
+
+// Runs a whole regression in one process: programs from a manifest are
+// simulated on N worker threads. Each worker owns a VerilatedContext and a
+// Vpipeline and reuses them for every job it picks up, resetting through
+// rst_n instead of constructing a new model. The model is built with a shared
+// instruction image (PIPELINE_SHARED_IMEM): a job binds its mapped ELF file to
+// the worker thread instead of copying it into a ROM.
+//   +MANIFEST=<file> [+JOBS=<n>] [+REPORT_FILE=<json>] [+MAX_CYCLES=<n>]
+//   [+EVENT_REPORT=<file>]  hazard/dispatch counters of all jobs together
+// Manifest: one job per line, '#' starts a comment line:
+//   <name> <elf> <num_cycles> [<expected_wd3_file>]
+// num_cycles 0 runs the program until it ends (tb_exit.h), bounded by
+// +MAX_CYCLES, and the job takes the program's exit code; the expected file
+// must then cover exactly those cycles. Otherwise the job runs num_cycles
+// cycles and, without an expected file, passes when it gets through them.
+
+struct BatchJob {
+    std::string name;
+    std::string elf_file;
+    uint64_t num_cycles = 0;
+    std::string expected_file;
+};
+
+struct BatchResult {
+    bool passed = false;
+    std::string message;
+    uint64_t cycles = 0;
+    uint64_t retired = 0;
+    int exit_code = 0;
+    double seconds = 0.0;
+    unsigned worker = 0;
+};
+
+static bool load_manifest(const std::string& path, std::vector<BatchJob>& jobs) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Could not open manifest: " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        std::istringstream ss(line);
+        BatchJob job;
+        if (!(ss >> job.name) || job.name[0] == '#') {
+            continue;
+        }
+        if (!(ss >> job.elf_file >> job.num_cycles)) {
+            std::cerr << "ERROR: " << path << ":" << line_number
+                      << ": expected '<name> <elf> <num_cycles> [<expected_wd3_file>]'" << std::endl;
+            return false;
+        }
+        ss >> job.expected_file;
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+class BatchWorker {
+public:
+    BatchWorker(unsigned id, uint64_t max_cycles)
+        : id_(id), max_cycles_(max_cycles), top_(new Vpipeline(&context_, "pipeline")) {
+        events_.clear();
+        top_->clk = 0;
+        top_->rst_n = 0;
+        top_->eval(); // Initial blocks run once per model, not per job
+    }
+
+    ~BatchWorker() { top_->final(); }
+
+    // Counters of every job this worker ran.
+    const pipeline_events::Counters& events() const { return events_; }
+
+    BatchResult run(const BatchJob& job) {
+        BatchResult result;
+        result.worker = id_;
+
+        const bool until_exit = job.num_cycles == 0;
+        std::vector<uint64_t> expected;
+        if (!job.expected_file.empty() &&
+            !load_expected_wd3_values(job.expected_file, expected,
+                                      until_exit ? EXPECTED_WD3_UNTIL_EXIT : static_cast<int>(job.num_cycles))) {
+            result.message = "could not load " + job.expected_file;
+            return result;
+        }
+        ElfImage image;
+        if (!load_elf_image(job.elf_file, image)) {
+            result.message = "could not load " + job.elf_file;
+            return result;
+        }
+
+        top_->rst_n = 0;
+        top_->eval();
+        backdoor_clear_instr_mem(top_.get());
+        if (!backdoor_load_instr_mem(top_.get(), image)) {
+            result.message = "program does not fit instruction memory";
+            return result;
+        }
+        backdoor_set_pc_start(top_.get(), image.entry);
+        for (int i = 0; i < 2; ++i) {
+            tick();
+        }
+        top_->rst_n = 1;
+        tick();
+        if (!backdoor_load_data_mem(top_.get(), image)) { // Reset clears data memory
+            result.message = "program does not fit data memory";
+            return result;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        pipeline_events::Counters job_events;
+        TbExitMonitor program_exit(tb_tohost_address(job.elf_file)); // +TOHOST applies to every job
+        result.passed = true;
+        for (uint64_t cycle = 0; cycle < (until_exit ? max_cycles_ : job.num_cycles); ++cycle) {
+            tick();
+            job_events.sample(top_.get());
+            ++result.cycles;
+            result.retired += top_->rvfi_valid;
+            const bool ended = until_exit && top_->rvfi_valid &&
+                               program_exit.on_retire(retire_record_from_model(top_.get()));
+            if (!expected.empty() && !check_cycle(cycle, expected, result)) {
+                break;
+            }
+            if (ended) {
+                break;
+            }
+        }
+        if (result.passed && until_exit) {
+            if (!program_exit.finished()) {
+                result.message = "timeout: the program did not end within " + std::to_string(max_cycles_) + " cycles";
+                result.passed = false;
+            } else if (result.cycles < expected.size()) {
+                result.message = "program ended (" + program_exit.reason() + ") at cycle " +
+                                 std::to_string(result.cycles) + ", expected output covers " +
+                                 std::to_string(expected.size());
+                result.passed = false;
+            } else if (program_exit.exit_code() != 0) {
+                result.exit_code = program_exit.exit_code();
+                result.message = "program exited (" + program_exit.reason() + ") with code " +
+                                 std::to_string(program_exit.exit_value());
+                result.passed = false;
+            }
+        }
+        events_.merge(job_events);
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+
+private:
+    // Compares the register write in WB with the expected file.
+    bool check_cycle(uint64_t cycle, const std::vector<uint64_t>& expected, BatchResult& result) const {
+        if (cycle >= expected.size()) {
+            result.message = "cycle " + std::to_string(cycle + 1) + ": program still running past the expected output";
+            result.passed = false;
+            return false;
+        }
+        const bool wrote = top_->debug_reg_write_wb;
+        const uint64_t value = top_->debug_result_w;
+        const uint64_t want = expected[cycle];
+        if ((want == X_DEF) == wrote || (wrote && value != want)) {
+            std::ostringstream ss;
+            ss << "cycle " << cycle + 1 << ": expected "
+               << (want == X_DEF ? std::string("no write") : to_hex(want)) << ", got "
+               << (wrote ? "x" + std::to_string(top_->debug_rd_addr_wb) + "=" + to_hex(value) : std::string("no write"));
+            result.message = ss.str();
+            result.passed = false;
+            return false;
+        }
+        return true;
+    }
+
+    static std::string to_hex(uint64_t value) {
+        std::ostringstream ss;
+        ss << "0x" << std::hex << value;
+        return ss.str();
+    }
+
+    void tick() {
+        top_->clk = 0;
+        top_->eval();
+        context_.timeInc(1);
+        top_->clk = 1;
+        top_->eval();
+        context_.timeInc(1);
+    }
+
+    unsigned id_;
+    uint64_t max_cycles_;
+    pipeline_events::Counters events_;
+    VerilatedContext context_;
+    std::unique_ptr<Vpipeline> top_;
+};
+
+static std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static bool write_report(const std::string& path, const std::vector<BatchJob>& jobs,
+                         const std::vector<BatchResult>& results, unsigned num_workers, double wall_seconds) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "ERROR: Could not open report file: " << path << std::endl;
+        return false;
+    }
+    const size_t passed = std::count_if(results.begin(), results.end(), [](const BatchResult& r) { return r.passed; });
+    out << "{\n"
+        << "  \"workers\": " << num_workers << ",\n"
+        << "  \"wall_seconds\": " << wall_seconds << ",\n"
+        << "  \"passed\": " << passed << ",\n"
+        << "  \"failed\": " << results.size() - passed << ",\n"
+        << "  \"jobs\": [\n";
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchResult& r = results[i];
+        out << "    {\"name\": \"" << json_escape(jobs[i].name) << "\", \"passed\": " << (r.passed ? "true" : "false")
+            << ", \"cycles\": " << r.cycles << ", \"retired\": " << r.retired << ", \"exit_code\": " << r.exit_code
+            << ", \"seconds\": " << r.seconds
+            << ", \"worker\": " << r.worker << ", \"message\": \"" << json_escape(r.message) << "\"}"
+            << (i + 1 < jobs.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    std::string manifest;
+    std::string report_file;
+    uint64_t num_workers = 0;
+    uint64_t max_cycles = 0;
+    try {
+        manifest = tb_require_plusarg("MANIFEST");
+        report_file = tb_plusarg_string("REPORT_FILE", "");
+        num_workers = tb_plusarg_u64("JOBS", std::max(1u, std::thread::hardware_concurrency()));
+        max_cycles = tb_plusarg_u64("MAX_CYCLES", TB_DEFAULT_MAX_CYCLES);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<BatchJob> jobs;
+    if (!load_manifest(manifest, jobs)) {
+        return 1;
+    }
+    if (jobs.empty()) {
+        std::cerr << "ERROR: No jobs in manifest: " << manifest << std::endl;
+        return 1;
+    }
+    num_workers = std::max<uint64_t>(1, std::min<uint64_t>(num_workers, jobs.size()));
+    std::cout << "Running " << jobs.size() << " programs on " << num_workers << " workers" << std::endl;
+
+    // Workers pull the next job index until the manifest is exhausted; each
+    // result slot is written by exactly one worker.
+    std::vector<BatchResult> results(jobs.size());
+    std::vector<pipeline_events::Counters> worker_events(num_workers);
+    std::atomic<size_t> next_job{0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned id = 0; id < num_workers; ++id) {
+        threads.emplace_back([&, id] {
+            BatchWorker worker(id, max_cycles);
+            for (size_t i = next_job.fetch_add(1); i < jobs.size(); i = next_job.fetch_add(1)) {
+                results[i] = worker.run(jobs[i]);
+            }
+            worker_events[id] = worker.events();
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    size_t passed = 0;
+    uint64_t total_cycles = 0;
+    std::cout << "\nTest                           | Result | Cycles     | Retired    | Seconds" << std::endl;
+    std::cout << "-------------------------------|--------|------------|------------|--------" << std::endl;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchResult& r = results[i];
+        passed += r.passed;
+        total_cycles += r.cycles;
+        std::cout << std::left << std::setw(30) << jobs[i].name << " | " << (r.passed ? "PASS  " : "FAIL  ") << " | "
+                  << std::right << std::setw(10) << r.cycles << " | " << std::setw(10) << r.retired << " | "
+                  << std::fixed << std::setprecision(3) << r.seconds;
+        if (!r.message.empty()) {
+            std::cout << "  " << r.message;
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "\nBatch: " << passed << "/" << jobs.size() << " passed, " << total_cycles << " cycles in "
+              << std::setprecision(3) << wall_seconds << " s (" << std::setprecision(0)
+              << (wall_seconds > 0 ? total_cycles / wall_seconds : 0.0) << " cycles/s aggregate)" << std::endl;
+
+    pipeline_events::Counters events;
+    events.clear();
+    for (const pipeline_events::Counters& counters : worker_events) {
+        events.merge(counters);
+    }
+    std::cout << events.summary() << std::endl;
+
+    if (!report_file.empty() && !write_report(report_file, jobs, results, num_workers, wall_seconds)) {
+        return 1;
+    }
+    const std::string event_report = tb_plusarg_string("EVENT_REPORT", "");
+    if (!event_report.empty() && !events.write(event_report)) {
+        return 1;
+    }
+    return passed == jobs.size() ? 0 : 1;
+}
@@ -1,5 +1,4 @@
 #include "Vpipeline.h"
-#include "verilated_vcd_c.h"
 #include "verilated.h"
 
 #include <iostream>
@@ -10,25 +9,46 @@
 #include <sstream>
 #include <cassert>
 
-#ifndef PIPELINE_TEST_CASE_NAME_STR_RAW
-#error "PIPELINE_TEST_CASE_NAME_STR_RAW not defined! Pass it via CFLAGS from CMake."
-#endif
+#include "tb_args.h"
+#include "tb_trace.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "expected_wd3.h"
+#include "tb_checkpoint.h"
+#include "tb_exit.h"
+#include "pipeline_events.h"
+#include "pipeline_timeline.h"
+#include "cpi_stack.h"
+#include "pipeline_profile.h"
+#include "rvfi_check.h"
+#include "async_trace_sink.h"
 
-#ifndef EXPECTED_WD3_FILE_PATH_STR_RAW
-#error "EXPECTED_WD3_FILE_PATH_STR_RAW not defined! Pass it via CFLAGS from CMake."
-#endif
-
-#ifndef NUM_CYCLES_TO_RUN
-#error "NUM_CYCLES_TO_RUN not defined! Pass it via CFLAGS from CMake."
-#endif
-
-#define STRINGIFY_HELPER(x) #x
-#define STRINGIFY(x) STRINGIFY_HELPER(x)
-
-const std::string G_PIPELINE_TEST_CASE_NAME = STRINGIFY(PIPELINE_TEST_CASE_NAME_STR_RAW);
-const std::string G_EXPECTED_WD3_FILE_PATH = STRINGIFY(EXPECTED_WD3_FILE_PATH_STR_RAW);
-const int G_NUM_CYCLES_TO_RUN = NUM_CYCLES_TO_RUN;
-const uint64_t X_DEF = 0xFFFFFFFFFFFFFFFFUL;
+// Test parameters come from plusargs so a single build runs every program:
+//   +TEST_NAME=<name> +EXPECTED_WD3_FILE=<path>
+//   +ELF_FILE=<elf>   program loaded straight into both memories; start PC = e_entry
+//   +INSTR_MEM_INIT_FILE=<hex> +PC_START_ADDR=<hex> (consumed by the RTL)
+//   +CHECKPOINT_* save/restore the run (see tb_checkpoint.h)
+//   +EVENT_REPORT=<file> write the hazard/dispatch counters (pipeline_events.h)
+//   +PIPEVIEW_FILE=<file> per-instruction timeline for Konata; +PIPEVIEW_FORMAT=
+//                     konata (default) or o3 (pipeline_timeline.h)
+//   +CPI_STACK[=<file>] cycle accounting by hazard class, globally and per PC
+//                     (cpi_stack.h); the file gets the full report
+//   +PROFILE=<prefix> symbolized hot-PC/function profile and instruction mix
+//                     in <prefix>.txt, folded stacks in <prefix>.folded
+//                     (pipeline_profile.h); symbols come from +ELF_FILE
+// The run ends when the program does (ecall/ebreak or a tohost store, see
+// tb_exit.h); the expected file must then cover exactly the cycles up to and
+// including that retirement, and the exit code is the program's.
+//   +MAX_CYCLES=<n>   timeout (default 100000); reaching it fails the test
+//   +NUM_CYCLES=<n>   instead run exactly n cycles and ignore the program's
+//                     end, for images that never finish (endless loops)
+// Every retirement is also checked for consistency on the rvfi_* port
+// (rvfi_check.h), except in a restored run: the checker follows the program
+// from reset.
+std::string G_PIPELINE_TEST_CASE_NAME;
+std::string G_EXPECTED_WD3_FILE_PATH;
+int G_NUM_CYCLES_TO_RUN = 0; // 0: run until the program ends
+uint64_t G_MAX_CYCLES = 0;
 
 vluint64_t sim_time = 0;
 
@@ -36,148 +56,338 @@ double sc_time_stamp() {
     return sim_time;
 }
 
-void tick(Vpipeline* top, VerilatedVcdC* tfp) {
+void tick(Vpipeline* top, TbTrace& trace) {
     top->clk = 0;
     top->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.dump(sim_time);
     sim_time++;
 
     top->clk = 1;
     top->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.dump(sim_time);
     sim_time++;
 }
 
-bool load_expected_wd3_values(const std::string& filepath, std::vector<uint64_t>& values, int expected_num_cycles) {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        std::cerr << "ERROR: Could not open expected output file: " << filepath << std::endl;
-        return false;
+enum RowStatus : uint8_t {
+    ROW_PASS,
+    ROW_PASS_NO_WRITE,
+    ROW_FAIL_NO_WRITE,
+    ROW_FAIL_VALUE,
+    ROW_FAIL_UNEXPECTED_WRITE,
+    ROW_FAIL_PAST_EXPECTED,
+};
+
+// Raw values for one row of the per-cycle table.
+struct CycleRow {
+    uint64_t cycle;
+    uint64_t pc;
+    uint64_t result;
+    uint64_t expected;
+    uint32_t instr;
+    uint8_t  reg_write;
+    uint8_t  rd;
+    uint8_t  status;
+};
+
+RowStatus check_cycle(const CycleRow& row, bool past_expected) {
+    if (past_expected) {
+        return ROW_FAIL_PAST_EXPECTED;
     }
-    std::string line;
-    int line_count = 0;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        try {
-            if (line == "X" || line == "x") {
-                values.push_back(X_DEF);
-            } else {
-                values.push_back(std::stoull(line, nullptr, 16));
-            }
-            line_count++;
-        } catch (const std::exception& e) {
-            std::cerr << "Error parsing hex value '" << line << "' at line " << (line_count + 1) << ": " << e.what() << std::endl;
+    if (row.expected != X_DEF) {
+        if (!row.reg_write) return ROW_FAIL_NO_WRITE;
+        return row.result == row.expected ? ROW_PASS : ROW_FAIL_VALUE;
+    }
+    return row.reg_write ? ROW_FAIL_UNEXPECTED_WRITE : ROW_PASS_NO_WRITE;
+}
+
+void print_cycle_row(const CycleRow& row) {
+    std::ostringstream line;
+    line << std::setw(5) << std::dec << row.cycle + 1 << " | "
+         << "0x" << std::setw(8) << std::setfill('0') << std::hex << row.pc << " | "
+         << "0x" << std::setw(8) << std::setfill('0') << std::hex << row.instr << " | "
+         << std::setw(8) << std::dec << (row.reg_write ? "1" : "0") << " | "
+         << std::setw(9) << std::dec << (row.reg_write ? (int)row.rd : 0) << " | "
+         << "0x" << std::setw(14) << std::setfill('0') << std::hex << (row.reg_write ? row.result : 0) << " | ";
+    if (row.status == ROW_FAIL_PAST_EXPECTED) {
+        line << " -             ";
+    } else if (row.expected != X_DEF) {
+        line << "0x" << std::setw(14) << std::setfill('0') << std::hex << row.expected;
+    } else {
+        line << " X (no write)  ";
+    }
+    switch (row.status) {
+        case ROW_PASS:          line << " | PASS"; break;
+        case ROW_PASS_NO_WRITE: line << " | PASS (No Write)"; break;
+        case ROW_FAIL_NO_WRITE: line << " | FAIL (Exp Write, Got No Write)"; break;
+        case ROW_FAIL_VALUE:    line << " | FAIL (Value Mismatch)"; break;
+        case ROW_FAIL_PAST_EXPECTED: line << " | FAIL (Program Still Running Past Expected Output)"; break;
+        default:
+            line << " | FAIL (Exp No Write, Got Write to x" << std::dec << (int)row.rd << "=0x" << std::hex << row.result << ")";
+            break;
+    }
+    line << '\n';
+    std::cout << line.str();
+}
+
+// Backdoor-loads the program (if any) and runs the reset sequence.
+bool load_program_and_reset(Vpipeline* top, TbTrace& trace, const std::string& elf_file, const ElfImage& elf_image) {
+    top->rst_n = 0;
+    top->eval(); // Run initial blocks before the backdoor load overwrites memories
+    if (!elf_file.empty()) {
+        if (!backdoor_load_instr_mem(top, elf_image)) {
             return false;
         }
+        if (!tb_has_plusarg("PC_START_ADDR")) {
+            backdoor_set_pc_start(top, elf_image.entry);
+        }
+        std::cout << "Loaded ELF: " << elf_file << " (entry 0x" << std::hex << elf_image.entry << std::dec << ")" << std::endl;
     }
-    file.close();
-    if (line_count < expected_num_cycles) {
-        std::cerr << "ERROR: Number of expected values (" << line_count
-                  << ") is less than NUM_CYCLES_TO_RUN (" << expected_num_cycles << ")." << std::endl;
-        std::cerr << "Please provide an expected value (or 'X' if no write) for each cycle." << std::endl;
-        return false;
+
+    for(int i=0; i<2; ++i) {
+        tick(top, trace);
     }
-    if (line_count > expected_num_cycles) {
-         std::cerr << "Warning: Number of expected values (" << line_count
-                  << ") is greater than NUM_CYCLES_TO_RUN (" << expected_num_cycles << ")." << std::endl;
+    top->rst_n = 1;
+    tick(top, trace);
+
+    if (!elf_file.empty() && !backdoor_load_data_mem(top, elf_image)) { // Reset clears data memory
+        return false;
     }
+    std::cout << "Reset complete." << std::endl;
     return true;
 }
 
 int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
+    try {
+        G_PIPELINE_TEST_CASE_NAME = tb_plusarg_string("TEST_NAME", "pipeline");
+        G_EXPECTED_WD3_FILE_PATH = tb_require_plusarg("EXPECTED_WD3_FILE");
+        G_NUM_CYCLES_TO_RUN = static_cast<int>(tb_plusarg_u64("NUM_CYCLES", 0));
+        G_MAX_CYCLES = tb_plusarg_u64("MAX_CYCLES", TB_DEFAULT_MAX_CYCLES);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const std::string elf_file = tb_plusarg_string("ELF_FILE", "");
+    ElfImage elf_image;
+    if (!elf_file.empty() && !load_elf_image(elf_file, elf_image)) {
+        return 1;
+    }
+
     Vpipeline* top = new Vpipeline;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    std::string vcd_file_name = G_PIPELINE_TEST_CASE_NAME + "_pipeline_tb.vcd";
-    tfp->open(vcd_file_name.c_str());
+    TbTrace trace(top, G_PIPELINE_TEST_CASE_NAME + "_pipeline_tb", "pipeline");
 
     std::cout << "Starting Pipeline Test Case: " << G_PIPELINE_TEST_CASE_NAME << std::endl;
     std::cout << "Expected output file: " << G_EXPECTED_WD3_FILE_PATH << std::endl;
-    std::cout << "Number of cycles to run: " << G_NUM_CYCLES_TO_RUN << std::endl;
+    const bool until_exit = G_NUM_CYCLES_TO_RUN == 0;
+    if (until_exit) {
+        std::cout << "Running until the program ends (at most " << G_MAX_CYCLES << " cycles)" << std::endl;
+    } else {
+        std::cout << "Number of cycles to run: " << G_NUM_CYCLES_TO_RUN << std::endl;
+    }
 
     std::vector<uint64_t> expected_results_per_cycle;
-    if (!load_expected_wd3_values(G_EXPECTED_WD3_FILE_PATH, expected_results_per_cycle, G_NUM_CYCLES_TO_RUN)) {
-        if (tfp) tfp->close();
+    if (!load_expected_wd3_values(G_EXPECTED_WD3_FILE_PATH, expected_results_per_cycle,
+                                  until_exit ? EXPECTED_WD3_UNTIL_EXIT : G_NUM_CYCLES_TO_RUN)) {
+        trace.close();
         delete top;
         return 1;
     }
 
-    top->rst_n = 0;
-    for(int i=0; i<2; ++i) {
-        tick(top, tfp);
+    TbCheckpoint checkpoint;
+    TbHarnessState harness;
+    harness.tohost = tb_tohost_address(elf_file);
+    if (checkpoint.restore_requested() && (tb_has_plusarg("CPI_STACK") || tb_has_plusarg("PROFILE"))) {
+        // Their per-PC totals, shadow pipeline and call stack are not in the checkpoint
+        std::cerr << "ERROR: +CPI_STACK and +PROFILE account from reset and cannot be combined with +CHECKPOINT_RESTORE."
+                  << std::endl;
+        trace.close();
+        delete top;
+        return 1;
     }
-    top->rst_n = 1;
-    tick(top, tfp);
-    std::cout << "Reset complete." << std::endl;
+    if (checkpoint.restore_requested()) {
+        if (!checkpoint.restore(top, harness)) {
+            trace.close();
+            delete top;
+            return 1;
+        }
+        sim_time = harness.sim_time;
+    } else if (!load_program_and_reset(top, trace, elf_file, elf_image)) {
+        trace.close();
+        delete top;
+        return 1;
+    }
+
+    bool test_passed = harness.passed;
+    bool checkpoint_exit = false;
+    TbExitMonitor program_exit(harness.tohost, harness.a0);
+    pipeline_events::Counters& events = harness.events; // Restored with the checkpoint
+    const bool cpi_stack_mode = tb_has_plusarg("CPI_STACK");
+    cpi_stack::Accountant cpi;
+    const std::string profile_prefix = tb_plusarg_string("PROFILE", "");
+    pipeline_profile::Symbolizer symbolizer;
+    if (!profile_prefix.empty() && !elf_file.empty()) {
+        std::vector<ElfSymbol> symbols;
+        if (load_elf_symbols(elf_file, symbols)) {
+            symbolizer.load(symbols, elf_image);
+        }
+    }
+    pipeline_profile::Profiler profile(symbolizer);
+    const bool rvfi_check_mode = !checkpoint.restore_requested();
+    rvfi_check::Checker rvfi;
+    const uint64_t last_cycle = until_exit ? G_MAX_CYCLES : static_cast<uint64_t>(G_NUM_CYCLES_TO_RUN);
 
-    bool test_passed = true;
+    // The per-cycle table is formatted and printed on a writer thread.
+    AsyncTraceSink<CycleRow> table;
+    table.open(print_cycle_row);
+
+    // So is the pipeline timeline, when requested.
+    pipeline_timeline::Writer timeline;
+    AsyncTraceSink<pipeline_timeline::Sample> timeline_sink;
+    const std::string pipeview_file = tb_plusarg_string("PIPEVIEW_FILE", "");
+    if (!pipeview_file.empty()) {
+        pipeline_timeline::Format format;
+        if (!pipeline_timeline::parse_format(tb_plusarg_string("PIPEVIEW_FORMAT", ""), format)) {
+            std::cerr << "ERROR: +PIPEVIEW_FORMAT must be konata or o3" << std::endl;
+            test_passed = false;
+        } else if (!timeline.open(pipeview_file, format)) {
+            test_passed = false;
+        } else {
+            timeline_sink.open([&timeline](const pipeline_timeline::Sample& s) { timeline.consume(s); });
+        }
+    }
 
     std::cout << "\nCycle | PC_F     | Instr_F  | RegWr_WB | RdAddr_WB | Result_W (Got) | Result_W (Exp) | Status" << std::endl;
     std::cout << "------|----------|----------|----------|-----------|----------------|----------------|-------" << std::endl;
 
-    for (int cycle = 0; cycle < G_NUM_CYCLES_TO_RUN; ++cycle) {
-        tick(top, tfp);
-
-
-        uint64_t current_pc_f = top->debug_pc_f;
-        uint32_t current_instr_f = top->debug_instr_f;
-        bool current_reg_write_wb = top->debug_reg_write_wb;
-        uint8_t current_rd_addr_wb = top->debug_rd_addr_wb;
-        uint64_t current_result_w = top->debug_result_w;
-
-        uint64_t expected_result = expected_results_per_cycle[cycle];
-        bool expect_write_this_cycle = (expected_result != X_DEF);
-
-        std::cout << std::setw(5) << std::dec << cycle + 1 << " | "
-                  << "0x" << std::setw(8) << std::setfill('0') << std::hex << current_pc_f << " | "
-                  << "0x" << std::setw(8) << std::setfill('0') << std::hex << current_instr_f << " | "
-                  << std::setw(8) << std::dec << (current_reg_write_wb ? "1" : "0") << " | "
-                  << std::setw(9) << std::dec << (current_reg_write_wb ? (int)current_rd_addr_wb : 0 )<< " | "
-                  << "0x" << std::setw(14) << std::setfill('0') << std::hex << (current_reg_write_wb ? current_result_w : 0) << " | "
-                  << (expect_write_this_cycle ? ("0x" + [&]{std::stringstream ss; ss << std::setw(14) << std::setfill('0') << std::hex << expected_result; return ss.str(); }()) : " X (no write)  ");
-
-        bool cycle_pass = true;
-        if (expect_write_this_cycle) {
-            if (!current_reg_write_wb) {
-                cycle_pass = false;
-                std::cout << " | FAIL (Exp Write, Got No Write)";
-            } else if (current_result_w != expected_result) {
-                cycle_pass = false;
-                std::cout << " | FAIL (Value Mismatch)";
-            } else {
-                std::cout << " | PASS";
-            }
-        } else {
-            if (current_reg_write_wb) {
-                cycle_pass = false;
-                std::cout << " | FAIL (Exp No Write, Got Write to x" << std::dec << (int)current_rd_addr_wb << "=0x" << std::hex << current_result_w << ")";
-            } else {
-                std::cout << " | PASS (No Write)";
+    uint64_t cycle = harness.cycle;
+    for (; cycle < last_cycle; ++cycle) {
+        harness.sim_time = sim_time;
+        harness.cycle = cycle;
+        harness.passed = test_passed;
+        harness.a0 = program_exit.a0();
+        if (checkpoint.on_cycle(top, harness, top->debug_pc_f)) {
+            checkpoint_exit = true;
+            break;
+        }
+        trace.on_cycle(cycle, top->debug_pc_f);
+        tick(top, trace);
+        events.sample(top);
+        if (cpi_stack_mode) {
+            cpi.sample(top);
+        }
+        if (!profile_prefix.empty()) {
+            profile.sample(top);
+        }
+        if (timeline_sink.is_open()) {
+            timeline_sink.push(pipeline_timeline::sample_from_model(top, cycle + 1)); // Cycle numbers as in the table
+        }
+        if (rvfi_check_mode && test_passed) {
+            const std::string rvfi_error = rvfi.check(top);
+            if (!rvfi_error.empty()) {
+                std::cerr << "ERROR: Cycle " << cycle << ": " << rvfi_error << std::endl;
+                trace.on_mismatch(cycle);
+                test_passed = false;
             }
         }
-        std::cout << std::endl;
 
+        CycleRow row;
+        const bool past_expected = cycle >= expected_results_per_cycle.size();
+        row.cycle = cycle;
+        row.pc = top->debug_pc_f;
+        row.instr = top->debug_instr_f;
+        row.reg_write = top->debug_reg_write_wb;
+        row.rd = top->debug_rd_addr_wb;
+        row.result = top->debug_result_w;
+        row.expected = past_expected ? X_DEF : expected_results_per_cycle[cycle];
+        row.status = check_cycle(row, past_expected);
+        table.push(row);
+
+        const bool cycle_pass = row.status == ROW_PASS || row.status == ROW_PASS_NO_WRITE;
         if (!cycle_pass) {
+            if (test_passed) {
+                trace.on_mismatch(cycle);
+            }
+            test_passed = false;
+        }
+        if (until_exit && top->rvfi_valid && program_exit.on_retire(retire_record_from_model(top))) {
+            ++cycle;
+            break;
+        }
+        if (past_expected) {
+            ++cycle;
+            break; // Already failed; do not run on to the timeout
+        }
+    }
+
+    table.close(); // Prints the remaining rows before the verdict
+    if (timeline_sink.is_open()) {
+        timeline_sink.close();
+        timeline.close();
+        std::cout << "Pipeline timeline: " << pipeview_file << " (" << timeline.retired() << " retired, "
+                  << timeline.flushed() << " flushed)" << std::endl;
+    }
+
+    std::cout << "\n" << events.summary() << std::endl;
+    if (rvfi_check_mode && test_passed) {
+        std::cout << rvfi.summary() << std::endl;
+    }
+    const std::string event_report = tb_plusarg_string("EVENT_REPORT", "");
+    if (!event_report.empty() && !events.write(event_report)) {
+        test_passed = false;
+    }
+    if (cpi_stack_mode) {
+        std::cout << cpi.summary() << std::endl;
+        const std::string cpi_report = tb_plusarg_string("CPI_STACK", "");
+        if (!cpi_report.empty() && !cpi.write(cpi_report)) {
+            test_passed = false;
+        }
+        if (!cpi.check_totals() || !cpi.check_load_use(events.count(pipeline_events::STALL_LOAD_USE))) {
+            test_passed = false;
+        }
+    }
+    if (!profile_prefix.empty()) {
+        std::cout << profile.summary() << std::endl;
+        if (!profile.write(profile_prefix)) {
             test_passed = false;
         }
-        std::cout << std::setfill(' ');
     }
 
-    if (tfp) {
-        tfp->close();
+    int exit_code = test_passed ? 0 : 1;
+    if (until_exit && !checkpoint_exit) {
+        if (!program_exit.finished() && cycle < last_cycle) {
+            std::cout << "\nFAIL: The program is still running after the " << expected_results_per_cycle.size()
+                      << " cycles of expected output." << std::endl;
+            exit_code = 1;
+        } else if (!program_exit.finished()) {
+            std::cout << "\nTIMEOUT: The program did not end within " << G_MAX_CYCLES << " cycles." << std::endl;
+            exit_code = 1;
+        } else {
+            std::cout << "\nProgram ended (" << program_exit.reason() << ") after " << cycle << " cycles with exit code "
+                      << program_exit.exit_value() << std::endl;
+            if (cycle < expected_results_per_cycle.size()) {
+                std::cout << "FAIL: The expected output covers " << expected_results_per_cycle.size() << " cycles." << std::endl;
+                exit_code = 1;
+            } else if (test_passed) {
+                exit_code = program_exit.exit_code();
+            }
+        }
     }
+
+    trace.close();
     delete top;
 
-    if (test_passed) {
+    if (checkpoint_exit) {
+        std::cout << "\nPipeline Test Case: " << G_PIPELINE_TEST_CASE_NAME << " - STOPPED AT CHECKPOINT ("
+                  << (test_passed ? "passing" : "failing") << " so far)" << std::endl;
+        return test_passed ? 0 : 1;
+    }
+    if (exit_code == 0) {
         std::cout << "\nPipeline Test Case: " << G_PIPELINE_TEST_CASE_NAME << " - PASSED" << std::endl;
         return 0;
     } else {
         std::cout << "\nPipeline Test Case: " << G_PIPELINE_TEST_CASE_NAME << " - FAILED" << std::endl;
-        return 1;
+        return exit_code;
     }
 }
\ No newline at end of file
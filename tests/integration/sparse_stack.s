@@ -0,0 +1,21 @@
+.section .text
+.global _start
+
+_start:
+    lui sp, 0x7ffff
+    addi x5, x0, 0x55
+    sd x5, -8(sp)
+    ld x6, -8(sp)
+    lui x7, 0x40000
+    ld x8, 0(x7)
+    add x9, x8, x6
+    ld x10, 8(x7)
+    sd x9, 16(x7)
+    ld x11, 16(x7)
+    addi x10, x0, 0
+    ecall
+
+.section .data
+    .dword 0x1122334455667788
+    .dword 0x0000000000000010
+    .dword 0
@@ -0,0 +1,27 @@
+# Control-flow-heavy endless workload: short blocks, taken and not-taken
+# conditional branches and jal/jalr pairs, so most cycles see a flush.
+.section .text
+.global _start
+
+_start:
+    addi x1, x0, 0
+    addi x2, x0, 7
+
+loop:
+    addi x1, x1, 1
+    andi x3, x1, 1
+    beq  x3, x0, even
+    addi x4, x4, 3
+    jal  x0, joined
+even:
+    addi x4, x4, -1
+joined:
+    andi x5, x1, 7
+    bne  x5, x2, skip
+    jal  x10, call
+skip:
+    blt  x1, x0, loop
+    bge  x1, x0, loop
+call:
+    addi x6, x6, 1
+    jalr x0, 0(x10)
@@ -0,0 +1,21 @@
+# Wraps the per-run JSON lines written by pipeline_perf_tb (+BENCH_JSON) into
+# one report tagged with the commit it was measured on.
+#   cmake -DSOURCE_DIR=<repo> -DINPUT=<jsonl> -DOUTPUT=<json> -P bench_collect.cmake
+
+find_package(Git QUIET)
+set(COMMIT "unknown")
+if(GIT_FOUND)
+    execute_process(COMMAND ${GIT_EXECUTABLE} describe --always --dirty
+                    WORKING_DIRECTORY ${SOURCE_DIR}
+                    OUTPUT_VARIABLE COMMIT OUTPUT_STRIP_TRAILING_WHITESPACE
+                    RESULT_VARIABLE GIT_RESULT ERROR_QUIET)
+    if(NOT GIT_RESULT EQUAL 0)
+        set(COMMIT "unknown")
+    endif()
+endif()
+
+file(STRINGS ${INPUT} RESULT_LINES)
+list(JOIN RESULT_LINES ",\n    " RESULTS)
+string(TIMESTAMP DATE "%Y-%m-%dT%H:%M:%SZ" UTC)
+file(WRITE ${OUTPUT} "{\n  \"commit\": \"${COMMIT}\",\n  \"date\": \"${DATE}\",\n  \"results\": [\n    ${RESULTS}\n  ]\n}\n")
+message(STATUS "Benchmark report: ${OUTPUT}")
@@ -0,0 +1,23 @@
+# Memory-heavy endless workload: a load-use chain through a table, byte
+# and halfword accesses and back-to-back stores. Data stays inside 0x000-0x1F8.
+.section .text
+.global _start
+
+_start:
+    addi x1, x0, 0
+    addi x2, x0, 0
+
+loop:
+    ld   x3, 0(x2)
+    addi x3, x3, 8
+    andi x3, x3, 0x1F8
+    sd   x3, 0(x2)
+    lbu  x4, 1(x2)
+    add  x1, x1, x4
+    lh   x5, 2(x2)
+    sh   x1, 4(x2)
+    sb   x5, 6(x2)
+    lw   x6, 4(x2)
+    sub  x1, x1, x6
+    addi x2, x3, 0
+    jal  x0, loop
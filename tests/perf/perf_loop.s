@@ -0,0 +1,28 @@
+# Endless mixed workload for simulation-speed measurements: ALU ops, a
+# load-use pair, stores, a taken branch per iteration and a jump per
+# outer iteration. Data stays inside 0x000-0x1F8.
+.section .text
+.global _start
+
+_start:
+    addi x1, x0, 0
+    addi x2, x0, 0x100
+    addi x3, x0, 64
+
+outer:
+    addi x4, x0, 0
+
+inner:
+    ld   x5, 0(x2)
+    add  x1, x1, x5
+    addi x5, x5, 3
+    sd   x5, 0(x2)
+    xor  x6, x1, x4
+    slli x7, x6, 2
+    srai x7, x7, 1
+    sltu x8, x7, x6
+    addi x2, x2, 8
+    andi x2, x2, 0x1F8
+    addi x4, x4, 1
+    bne  x4, x3, inner
+    jal  x0, outer
@@ -0,0 +1,213 @@
+#include "Vpipeline.h"
+#include "verilated.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "tb_args.h"
+#include "tb_trace.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "rv64i_model.h"
+#include "cpi_stack.h"
+#include "pipeline_profile.h"
+
+// Simulation-speed measurement: runs a program for a fixed number of cycles
+// and reports cycles/second. Built twice (debug and fast flavor, see
+// tests/perf/CMakeLists.txt) so the two can be compared on the same workload.
+//   +ELF_FILE=<elf> +NUM_CYCLES=<n> [+TEST_NAME=<name>] [+BENCH_JSON=<file>]
+// +BENCH_JSON appends one JSON object per run to <file> (one per line); the
+// bench_pipeline target collects them into a single report.
+// +FAST_FORWARD=<n> runs the first n instructions on the functional model
+// (rv64i_model.h) and starts the RTL from its PC, registers and data memory,
+// so NUM_CYCLES only covers the region after the skipped prefix.
+// +CPI_STACK[=<file>] also splits the measured cycles by hazard class,
+// globally and per PC (cpi_stack.h); it slows the run down, so leave it off
+// when measuring simulation speed. +PROFILE=<prefix> does the same for the
+// symbolized profile (pipeline_profile.h): <prefix>.txt and <prefix>.folded.
+vluint64_t sim_time = 0;
+
+double sc_time_stamp() {
+    return sim_time;
+}
+
+// All pipeline state is posedge-triggered. The falling edge still needs an
+// eval() so Verilator sees the next rising edge, but nothing is sensitive to
+// it. Without trace support (fast flavor) the dumps compile away.
+inline void tick(Vpipeline* top, TbTrace& trace) {
+    top->clk = 0;
+    top->eval();
+#if VM_TRACE
+    trace.dump(sim_time);
+#endif
+    sim_time++;
+
+    top->clk = 1;
+    top->eval();
+#if VM_TRACE
+    trace.dump(sim_time);
+#else
+    (void)trace;
+#endif
+    sim_time++;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    std::string test_name;
+    std::string elf_file;
+    uint64_t num_cycles = 0;
+    try {
+        test_name = tb_plusarg_string("TEST_NAME", "pipeline_perf");
+        elf_file = tb_require_plusarg("ELF_FILE");
+        num_cycles = tb_plusarg_u64("NUM_CYCLES", 1000000);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+
+    ElfImage elf_image;
+    if (!load_elf_image(elf_file, elf_image)) {
+        return 1;
+    }
+
+    // Startup covers model construction, including allocating the ROM and data
+    // memory arrays, and the first eval(), which runs the initial blocks (the
+    // default program or +INSTR_MEM_INIT_FILE; other ROM words stay 0).
+    const auto startup_begin = std::chrono::steady_clock::now();
+    Vpipeline* top = new Vpipeline;
+    TbTrace trace(top, test_name + "_perf", "pipeline");
+    top->rst_n = 0;
+    top->eval(); // Run initial blocks before the backdoor load overwrites memories
+    const double startup_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - startup_begin).count();
+
+    if (!backdoor_load_instr_mem(top, elf_image)) {
+        delete top;
+        return 1;
+    }
+
+    const uint64_t fast_forward = tb_plusarg_u64("FAST_FORWARD", 0);
+    rv64i::FunctionalModel ff_model(backdoor_array_depth(backdoor_instr_mem(top)),
+                                    backdoor_array_depth(backdoor_data_mem(top)));
+    if (fast_forward > 0) {
+        if (!ff_model.load(elf_image)) {
+            delete top;
+            return 1;
+        }
+        const auto ff_start = std::chrono::steady_clock::now();
+        while (ff_model.retired < fast_forward && ff_model.step()) {
+        }
+        const double ff_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ff_start).count();
+        std::cout << "PERF: fast-forwarded " << ff_model.retired << " instructions in " << std::fixed
+                  << std::setprecision(3) << ff_seconds << " s, handing off at pc 0x" << std::hex << ff_model.pc
+                  << std::dec << std::defaultfloat << std::endl;
+        if (ff_model.retired < fast_forward) {
+            std::cerr << "WARNING: Program reached a SYSTEM instruction after " << ff_model.retired
+                      << " instructions." << std::endl;
+        }
+    }
+
+    backdoor_set_pc_start(top, fast_forward > 0 ? ff_model.pc : elf_image.entry);
+    for (int i = 0; i < 2; ++i) {
+        tick(top, trace);
+    }
+    if (fast_forward > 0) {
+        backdoor_load_registers(top, ff_model.regs);
+    }
+    top->rst_n = 1;
+    tick(top, trace);
+    // Reset clears data memory
+    const bool loaded = fast_forward > 0 ? backdoor_load_data_bytes(top, ff_model.dmem())
+                                         : backdoor_load_data_mem(top, elf_image);
+    if (!loaded) {
+        delete top;
+        return 1;
+    }
+
+    const bool cpi_stack_mode = tb_has_plusarg("CPI_STACK");
+    cpi_stack::Accountant cpi;
+    const std::string profile_prefix = tb_plusarg_string("PROFILE", "");
+    pipeline_profile::Symbolizer symbolizer;
+    if (!profile_prefix.empty()) {
+        std::vector<ElfSymbol> symbols;
+        if (!load_elf_symbols(elf_file, symbols)) {
+            delete top;
+            return 1;
+        }
+        symbolizer.load(symbols, elf_image);
+    }
+    pipeline_profile::Profiler profile(symbolizer);
+    uint64_t retired = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t cycle = 0; cycle < num_cycles; ++cycle) {
+        tick(top, trace);
+        retired += top->rvfi_valid;
+        if (cpi_stack_mode) {
+            cpi.sample(top);
+        }
+        if (!profile_prefix.empty()) {
+            profile.sample(top);
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(stop - start).count();
+
+    std::cout << "PERF: " << test_name << " (" << (VM_TRACE ? "debug" : "fast") << " build)" << std::endl;
+    std::cout << "PERF: cycles=" << num_cycles << " retired=" << retired
+              << " ipc=" << std::fixed << std::setprecision(3)
+              << (num_cycles ? static_cast<double>(retired) / num_cycles : 0.0) << std::endl;
+    const double cycles_per_second = seconds > 0 ? num_cycles / seconds : 0.0;
+    const double instructions_per_second = seconds > 0 ? retired / seconds : 0.0;
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage); // ru_maxrss is in KiB on Linux
+    std::cout << "PERF: seconds=" << std::setprecision(3) << seconds
+              << " cycles_per_second=" << std::setprecision(0) << cycles_per_second
+              << " instructions_per_second=" << instructions_per_second << std::endl;
+    std::cout << "PERF: startup_seconds=" << std::setprecision(3) << startup_seconds
+              << " peak_rss_kb=" << usage.ru_maxrss << std::endl;
+
+    if (cpi_stack_mode) {
+        std::cout << cpi.summary() << std::endl;
+        const std::string cpi_report = tb_plusarg_string("CPI_STACK", "");
+        if ((!cpi_report.empty() && !cpi.write(cpi_report)) || !cpi.check_totals()) {
+            delete top;
+            return 1;
+        }
+    }
+    if (!profile_prefix.empty()) {
+        std::cout << profile.summary() << std::endl;
+        if (!profile.write(profile_prefix)) {
+            delete top;
+            return 1;
+        }
+    }
+
+    const std::string bench_json = tb_plusarg_string("BENCH_JSON", "");
+    if (!bench_json.empty()) {
+        std::ofstream out(bench_json, std::ios::out | std::ios::app);
+        if (!out.is_open()) {
+            std::cerr << "ERROR: Could not open benchmark output file: " << bench_json << std::endl;
+            delete top;
+            return 1;
+        }
+        out << std::setprecision(6) << std::defaultfloat
+            << "{\"workload\": \"" << test_name << "\", \"flavor\": \"" << (VM_TRACE ? "debug" : "fast")
+            << "\", \"cycles\": " << num_cycles << ", \"retired\": " << retired
+            << ", \"wall_seconds\": " << seconds << ", \"cycles_per_second\": " << std::fixed
+            << std::setprecision(0) << cycles_per_second << ", \"instructions_per_second\": "
+            << instructions_per_second << std::defaultfloat << std::setprecision(6)
+            << ", \"startup_seconds\": " << startup_seconds << ", \"peak_rss_kb\": " << usage.ru_maxrss << "}\n";
+    }
+
+    trace.close();
+    top->final();
+    delete top;
+    return 0;
+}
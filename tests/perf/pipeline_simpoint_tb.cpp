@@ -0,0 +1,202 @@
+#include "Vpipeline.h"
+#include "verilated.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "tb_args.h"
+#include "elf_loader.h"
+#include "pipeline_backdoor.h"
+#include "rv64i_model.h"
+#include "simpoint.h"
+
+// Sampled CPI estimation (SimPoint). The functional model profiles the
+// program into basic-block vectors per interval. k-means picks one
+// representative interval per phase, and only those intervals are simulated
+// on the RTL. Each one starts from the functional model's architectural state
+// a warm-up window before the interval, so the pipeline is full when
+// measurement starts.
+//   +ELF_FILE=<elf>              program to estimate
+//   +INTERVAL=<n>                instructions per interval (default 100000)
+//   +WARMUP=<n>                  detailed warm-up before each interval (default 10000)
+//   +SIMPOINT_K=<n>              clusters (default 8)
+//   +MAX_INSTRUCTIONS=<n>        profile length for programs that never end (default 100M)
+//   +SEED=<n>                    projection and clustering seed (default 1)
+//   +SIMPOINT_VALIDATE           also simulate the whole profiled region in
+//                                detail and report the estimate's error
+vluint64_t sim_time = 0;
+
+double sc_time_stamp() {
+    return sim_time;
+}
+
+inline void tick(Vpipeline* top) {
+    top->clk = 0;
+    top->eval();
+    sim_time++;
+    top->clk = 1;
+    top->eval();
+    sim_time++;
+}
+
+// Resets the pipeline and starts it from the functional model's state.
+static bool start_from_model(Vpipeline* top, const rv64i::FunctionalModel& model) {
+    top->rst_n = 0;
+    top->eval();
+    backdoor_set_pc_start(top, model.pc);
+    for (int i = 0; i < 2; ++i) {
+        tick(top);
+    }
+    backdoor_load_registers(top, model.regs);
+    top->rst_n = 1;
+    tick(top);
+    return backdoor_load_data_bytes(top, model.dmem());
+}
+
+// Runs until `count` more instructions retire; returns the cycles it took, or
+// 0 if the pipeline stopped retiring.
+static uint64_t run_instructions(Vpipeline* top, uint64_t count) {
+    const uint64_t max_cycles = 100 * count + 1000;
+    uint64_t retired = 0;
+    uint64_t cycles = 0;
+    while (retired < count) {
+        if (cycles == max_cycles) {
+            std::cerr << "ERROR: Only " << retired << " of " << count << " instructions retired in "
+                      << max_cycles << " cycles." << std::endl;
+            return 0;
+        }
+        tick(top);
+        ++cycles;
+        retired += top->rvfi_valid;
+    }
+    return cycles;
+}
+
+int main(int argc, char** argv) {
+    Verilated::commandArgs(argc, argv);
+    std::string elf_file;
+    uint64_t interval = 0, warmup = 0, k = 0, max_instructions = 0, seed = 0;
+    try {
+        elf_file = tb_require_plusarg("ELF_FILE");
+        interval = tb_plusarg_u64("INTERVAL", 100000);
+        warmup = tb_plusarg_u64("WARMUP", 10000);
+        k = tb_plusarg_u64("SIMPOINT_K", 8);
+        max_instructions = tb_plusarg_u64("MAX_INSTRUCTIONS", 100000000);
+        seed = tb_plusarg_u64("SEED", 1);
+    } catch (const std::exception& e) {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    if (interval == 0) {
+        std::cerr << "ERROR: +INTERVAL must be positive." << std::endl;
+        return 1;
+    }
+
+    ElfImage elf_image;
+    if (!load_elf_image(elf_file, elf_image)) {
+        return 1;
+    }
+
+    Vpipeline* top = new Vpipeline;
+    top->rst_n = 0;
+    top->eval(); // Run initial blocks before the backdoor load overwrites memories
+    if (!backdoor_load_instr_mem(top, elf_image)) { // Reset leaves the ROM alone: load once
+        delete top;
+        return 1;
+    }
+    const uint64_t imem_words = backdoor_array_depth(backdoor_instr_mem(top));
+    const uint64_t dmem_bytes = backdoor_array_depth(backdoor_data_mem(top));
+
+    // 1. Profile
+    const auto profile_start = std::chrono::steady_clock::now();
+    rv64i::FunctionalModel profiler(imem_words, dmem_bytes);
+    if (!profiler.load(elf_image)) {
+        delete top;
+        return 1;
+    }
+    simpoint::BbvCollector bbvs(interval, seed);
+    while (profiler.retired < max_instructions) {
+        const uint64_t pc = profiler.pc;
+        const uint32_t instr = profiler.fetch(pc);
+        if (!profiler.step()) {
+            break;
+        }
+        bbvs.on_retire(pc, instr);
+    }
+    const uint64_t num_intervals = bbvs.intervals().size();
+    const double profile_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - profile_start).count();
+    std::cout << "SIMPOINT: Profiled " << profiler.retired << " instructions into " << num_intervals << " intervals of "
+              << interval << " in " << std::fixed << std::setprecision(3) << profile_seconds << " s" << std::endl;
+    if (num_intervals == 0) {
+        std::cerr << "ERROR: The program is shorter than one interval; lower +INTERVAL." << std::endl;
+        delete top;
+        return 1;
+    }
+
+    // 2. Cluster
+    std::vector<simpoint::SimPoint> points = simpoint::choose_simpoints(bbvs.intervals(), static_cast<unsigned>(k), seed);
+    std::sort(points.begin(), points.end(),
+              [](const simpoint::SimPoint& a, const simpoint::SimPoint& b) { return a.interval < b.interval; });
+
+    // 3. Simulate the representatives in program order, advancing a second
+    //    functional model to each warm-up start.
+    const auto detail_start = std::chrono::steady_clock::now();
+    rv64i::FunctionalModel forward(imem_words, dmem_bytes);
+    forward.load(elf_image);
+    double estimated_cpi = 0.0;
+    std::cout << "\nInterval   | Weight | Warm-up | Cycles     | CPI" << std::endl;
+    std::cout << "-----------|--------|---------|------------|------" << std::endl;
+    for (const simpoint::SimPoint& point : points) {
+        const uint64_t start = point.interval * interval;
+        const uint64_t warm = std::min(warmup, start);
+        while (forward.retired < start - warm && forward.step()) {
+        }
+        if (!start_from_model(top, forward) || (warm > 0 && run_instructions(top, warm) == 0)) {
+            delete top;
+            return 1;
+        }
+        const uint64_t cycles = run_instructions(top, interval);
+        if (cycles == 0) {
+            delete top;
+            return 1;
+        }
+        const double cpi = static_cast<double>(cycles) / interval;
+        estimated_cpi += point.weight * cpi;
+        std::cout << std::setw(10) << point.interval << " | " << std::setprecision(3) << std::setw(6) << point.weight
+                  << " | " << std::setw(7) << warm << " | " << std::setw(10) << cycles << " | " << cpi << std::endl;
+    }
+    const double detail_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - detail_start).count();
+
+    std::cout << "\nSIMPOINT: " << points.size() << " simulation points cover " << num_intervals << " intervals; "
+              << "detailed simulation took " << detail_seconds << " s" << std::endl;
+    std::cout << "SIMPOINT: estimated CPI=" << std::setprecision(4) << estimated_cpi << std::endl;
+
+    if (tb_has_plusarg("SIMPOINT_VALIDATE")) {
+        rv64i::FunctionalModel reset_state(imem_words, dmem_bytes);
+        reset_state.load(elf_image);
+        const uint64_t total = num_intervals * interval;
+        const auto full_start = std::chrono::steady_clock::now();
+        if (!start_from_model(top, reset_state)) {
+            delete top;
+            return 1;
+        }
+        const uint64_t cycles = run_instructions(top, total);
+        const double full_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - full_start).count();
+        if (cycles == 0) {
+            delete top;
+            return 1;
+        }
+        const double full_cpi = static_cast<double>(cycles) / total;
+        std::cout << "SIMPOINT: full-detail CPI=" << full_cpi << " (" << std::setprecision(3) << full_seconds
+                  << " s), estimate error=" << std::setprecision(2)
+                  << 100.0 * (estimated_cpi - full_cpi) / full_cpi << "%" << std::endl;
+    }
+
+    top->final();
+    delete top;
+    return 0;
+}
@@ -1,7 +1,7 @@
 // tests/unit/alu.cpp
 #include "Valu.h" // Verilator generated header for alu module
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -31,11 +31,10 @@ double sc_time_stamp() {
 }
 
 // Измененная функция eval_alu: clk не нужен для комбинационного ALU
-void eval_alu(Valu* alu_core, VerilatedVcdC* tfp) {
+void eval_alu(Valu* alu_core, TbTrace& trace) {
     alu_core->eval(); // Просто вызываем eval
-    if (tfp) {
-        tfp->dump(sim_time); // Дампим на текущее время симуляции
-    }
+    trace.on_cycle(sim_time, 0);
+    trace.dump(sim_time); // Дампим на текущее время симуляции
 }
 
 struct AluTestCase {
@@ -50,10 +49,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Valu* top = new Valu;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_alu.vcd");
+    TbTrace trace(top, "tb_alu", "alu");
 
     std::cout << "Starting Enhanced ALU Testbench (RV64)" << std::endl;
 
@@ -147,7 +143,7 @@ int main(int argc, char** argv) {
         top->operand_b = t.b;
         top->alu_control = t.alu_control_val;
 
-        eval_alu(top, tfp); // Вызываем eval один раз, т.к. модуль комбинационный
+        eval_alu(top, trace); // Вызываем eval один раз, т.к. модуль комбинационный
         // Для VCD инкрементируем время после каждого набора входов/выходов
         sim_time++;
 
@@ -168,7 +164,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nEnhanced ALU Testbench Finished. Passed " << passed_tests << "/" << num_tests << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_tests == num_tests) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
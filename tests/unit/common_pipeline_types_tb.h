@@ -27,17 +27,23 @@ const uint8_t ALU_OP_ADD_TB = 0x0; // Example, add more if needed for defaults
 
 // From common/pipeline_types.svh
 typedef struct {
+    bool        valid;
+    uint64_t    seq;
     uint32_t    instr;
     uint64_t    pc;
     uint64_t    pc_plus_4;
 } IfIdDataTb;
 
 typedef struct {
+    bool        valid;
+    uint64_t    seq;
+    uint32_t    instr;
     bool        reg_write;
     uint8_t     result_src; // 2 bits
     bool        mem_write;
     bool        jump;
     bool        branch;
+    bool        csr_en;
     bool        alu_src;    // Selects ALU OpB
     uint8_t     alu_control; // ALU_CONTROL_WIDTH bits
     uint8_t     op_a_sel; // alu_a_src_sel_e_tb
@@ -56,6 +62,10 @@ typedef struct {
 } IdExDataTb;
 
 typedef struct {
+    bool        valid;
+    uint64_t    seq;
+    uint32_t    instr;
+    uint64_t    pc;
     bool        reg_write;
     uint8_t     result_src; // 2 bits
     bool        mem_write;
@@ -66,17 +76,36 @@ typedef struct {
     uint64_t    pc_plus_4;
 
     uint8_t     rd_addr;
+
+    uint64_t    rvfi_pc_wdata;
+    uint8_t     rvfi_rs1_addr;
+    uint8_t     rvfi_rs2_addr;
+    uint64_t    rvfi_rs1_rdata;
+    uint64_t    rvfi_rs2_rdata;
 } ExMemDataTb;
 
 typedef struct {
+    bool        valid;
+    uint64_t    seq;
+    uint32_t    instr;
+    uint64_t    pc;
     bool        reg_write;
     uint8_t     result_src; // 2 bits
+    uint64_t    store_data;
 
     uint64_t    read_data_mem;
     uint64_t    alu_result;
     uint64_t    pc_plus_4;
 
     uint8_t     rd_addr;
+
+    uint64_t    rvfi_pc_wdata;
+    uint8_t     rvfi_rs1_addr;
+    uint8_t     rvfi_rs2_addr;
+    uint64_t    rvfi_rs1_rdata;
+    uint64_t    rvfi_rs2_rdata;
+    uint8_t     rvfi_mem_rmask; // DATA_BYTES bits
+    uint8_t     rvfi_mem_wmask;
 } MemWbDataTb;
 
 typedef struct {
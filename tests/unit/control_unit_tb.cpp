@@ -1,7 +1,7 @@
 // tests/unit/control_unit_tb.cpp
 #include "Vcontrol_unit_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -65,9 +65,10 @@ const uint8_t FUNCT7_5_ADD_MAIN_CU = 0; // For SRL/SRLI/ADD
 
 vluint64_t sim_time_cu = 0;
 
-void eval_cu(Vcontrol_unit_tb* dut, VerilatedVcdC* tfp) {
+void eval_cu(Vcontrol_unit_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) tfp->dump(sim_time_cu);
+    trace.on_cycle(sim_time_cu, 0);
+    trace.dump(sim_time_cu);
     // sim_time_cu++; // For combinational, advance time per test case
 }
 
@@ -95,10 +96,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vcontrol_unit_tb* top = new Vcontrol_unit_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_control_unit.vcd");
+    TbTrace trace(top, "tb_control_unit", "control_unit_tb");
 
     std::cout << "Starting Control Unit Testbench" << std::endl;
 
@@ -146,7 +144,7 @@ int main(int argc, char** argv) {
         top->i_funct3 = tc.funct3;
         top->i_funct7_5 = tc.funct7_5;
 
-        eval_cu(top, tfp);
+        eval_cu(top, trace);
         sim_time_cu++;
 
         bool current_pass = true;
@@ -172,7 +170,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nControl Unit Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ module control_unit_tb (
     output logic       o_mem_write_d,
     output logic       o_jump_d,
     output logic       o_branch_d,
+    output logic       o_csr_d,
     output logic       o_alu_src_d,
     output logic [`ALU_CONTROL_WIDTH-1:0] o_alu_control_d,
     output immediate_type_e o_imm_type_d,
@@ -33,6 +34,7 @@ module control_unit_tb (
         .mem_write_d_o     (o_mem_write_d),
         .jump_d_o          (o_jump_d),
         .branch_d_o        (o_branch_d),
+        .csr_d_o           (o_csr_d),
         .alu_src_d_o       (o_alu_src_d),
         .alu_control_d_o   (o_alu_control_d),
         .imm_type_d_o      (o_imm_type_d),
@@ -0,0 +1,32 @@
+`include "common/defines.svh"
+`include "common/csr_defines.svh"
+
+module csr_file_tb (
+    input  logic clk,
+    input  logic rst_n,
+
+    // Inputs to csr_file
+    input  logic [`CSR_ADDR_WIDTH-1:0] i_csr_addr,
+    input  logic                       i_csr_write,
+    input  logic [`DATA_WIDTH-1:0]     i_csr_wdata,
+    input  logic                       i_instr_retired,
+    input  logic [`HPM_NUM_EVENTS-1:0] i_hpm_events,
+
+    // Outputs from csr_file
+    output logic [`DATA_WIDTH-1:0]     o_csr_rdata
+);
+
+    csr_file #(
+        .NUM_HPM_COUNTERS (4)
+    ) u_csr_file (
+        .clk             (clk),
+        .rst_n           (rst_n),
+        .csr_addr_i      (i_csr_addr),
+        .csr_rdata_o     (o_csr_rdata),
+        .csr_write_i     (i_csr_write),
+        .csr_wdata_i     (i_csr_wdata),
+        .instr_retired_i (i_instr_retired),
+        .hpm_events_i    (i_hpm_events)
+    );
+
+endmodule
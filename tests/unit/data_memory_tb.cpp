@@ -1,7 +1,7 @@
 // tests/unit/data_memory_tb.cpp
 #include "Vdata_memory_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -27,22 +27,23 @@ const uint8_t FUNCT3_SD_CPP  = 0b011;
 
 vluint64_t sim_time_dmem = 0;
 
-void tick_dmem(Vdata_memory_tb* dut, VerilatedVcdC* tfp) {
+void tick_dmem(Vdata_memory_tb* dut, TbTrace& trace) {
     // Память синхронная по записи, комбинационная по чтению (но зависит от clk для записи)
     // Поэтому тактируем
     dut->clk = 0;
     dut->eval();
-    if (tfp) tfp->dump(sim_time_dmem);
+    trace.on_cycle(sim_time_dmem / 2, 0);
+    trace.dump(sim_time_dmem);
     sim_time_dmem++;
 
     dut->clk = 1;
     dut->eval(); // Запись происходит на posedge clk
-    if (tfp) tfp->dump(sim_time_dmem);
+    trace.dump(sim_time_dmem);
     sim_time_dmem++;
 }
 
 
-void reset_dmem(Vdata_memory_tb* dut, VerilatedVcdC* tfp) {
+void reset_dmem(Vdata_memory_tb* dut, TbTrace& trace) {
     dut->rst_n = 0;
     dut->i_addr = 0;
     dut->i_write_data = 0;
@@ -50,10 +51,10 @@ void reset_dmem(Vdata_memory_tb* dut, VerilatedVcdC* tfp) {
     dut->i_funct3 = 0;
     // Держим ресет несколько тактов
     for(int i=0; i<5; ++i) {
-        tick_dmem(dut, tfp);
+        tick_dmem(dut, trace);
     }
     dut->rst_n = 1;
-    tick_dmem(dut, tfp); // Один такт после снятия ресета
+    tick_dmem(dut, trace); // Один такт после снятия ресета
     std::cout << "DUT Data Memory Reset" << std::endl;
 }
 
@@ -76,14 +77,11 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vdata_memory_tb* top = new Vdata_memory_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_data_memory.vcd");
+    TbTrace trace(top, "tb_data_memory", "data_memory_tb");
 
     std::cout << "Starting Data Memory Testbench" << std::endl;
 
-    reset_dmem(top, tfp);
+    reset_dmem(top, trace);
 
     std::vector<DmemTestCase> test_cases = {
         // Test SB (Store Byte) then LB (Load Byte Signed)
@@ -151,13 +149,14 @@ int main(int argc, char** argv) {
         // We tick once to ensure any synchronous write happens.
         // Then, for READs, the output o_read_data should be valid after eval.
         if (tc.action == "WRITE") {
-            tick_dmem(top, tfp); // This will apply write on posedge clk
+            tick_dmem(top, trace); // This will apply write on posedge clk
         } else { // READ
             // For read, the output is combinational. One eval after setting address should be enough.
             // But to keep VCD clean and have a "moment" of read:
-            top->clk = 0; top->eval(); if(tfp) tfp->dump(sim_time_dmem); // Set address
+            trace.on_cycle(sim_time_dmem / 2, 0);
+            top->clk = 0; top->eval(); trace.dump(sim_time_dmem); // Set address
             sim_time_dmem++;
-            top->clk = 1; top->eval(); if(tfp) tfp->dump(sim_time_dmem); // Read output is stable
+            top->clk = 1; top->eval(); trace.dump(sim_time_dmem); // Read output is stable
             sim_time_dmem++;
         }
 
@@ -182,7 +181,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nData Memory Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
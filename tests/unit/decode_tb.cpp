@@ -1,7 +1,7 @@
 // tests/unit/decode_tb.cpp
 #include "Vdecode_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -68,18 +68,19 @@ const uint32_t NOP_INSTRUCTION = 0x00000013; // addi x0, x0, 0
 
 vluint64_t sim_time = 0; // Changed from sim_time_decode to avoid conflicts if other TBs use sim_time
 
-void tick(Vdecode_tb* dut, VerilatedVcdC* tfp) {
+void tick(Vdecode_tb* dut, TbTrace& trace) {
     dut->clk = 0;
     dut->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.on_cycle(sim_time / 2, 0);
+    trace.dump(sim_time);
     sim_time++;
     dut->clk = 1;
     dut->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.dump(sim_time);
     sim_time++;
 }
 
-void reset_dut(Vdecode_tb* dut, VerilatedVcdC* tfp) {
+void reset_dut(Vdecode_tb* dut, TbTrace& trace) {
     dut->rst_n = 0;
     dut->i_if_id_stall_d = 0;
     dut->i_if_id_flush_d = 0;
@@ -89,18 +90,18 @@ void reset_dut(Vdecode_tb* dut, VerilatedVcdC* tfp) {
     dut->i_wb_write_en = 0;
     dut->i_wb_rd_addr = 0;
     dut->i_wb_rd_data = 0;
-    for (int i = 0; i < 5; ++i) tick(dut, tfp); // Hold reset for a few cycles
+    for (int i = 0; i < 5; ++i) tick(dut, trace); // Hold reset for a few cycles
     dut->rst_n = 1;
-    tick(dut, tfp); // One tick out of reset
+    tick(dut, trace); // One tick out of reset
 }
 
-void set_reg(Vdecode_tb* dut, VerilatedVcdC* tfp, uint8_t reg_addr, uint64_t data) {
+void set_reg(Vdecode_tb* dut, TbTrace& trace, uint8_t reg_addr, uint64_t data) {
     if (reg_addr == 0) return; // Cannot write to x0
     dut->i_wb_write_en = 1;
     dut->i_wb_rd_addr = reg_addr;
     dut->i_wb_rd_data = data;
     // Write occurs on posedge clk within this tick
-    tick(dut, tfp);
+    tick(dut, trace);
     dut->i_wb_write_en = 0;
     // It's good practice to let signals propagate after write_en goes low,
     // though for this specific RF design, the next tick in the main loop will handle negedge read.
@@ -140,10 +141,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vdecode_tb* top = new Vdecode_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99); // Trace 99 levels of hierarchy
-    tfp->open("tb_decode.vcd");
+    TbTrace trace(top, "tb_decode", "decode_tb");
 
     std::cout << "Starting Decode Stage Testbench (Comprehensive)" << std::endl;
 
@@ -233,11 +231,11 @@ int main(int argc, char** argv) {
         std::cout << "\nRunning Test: " << tc.name << std::endl;
         std::cout << "  Instruction: 0x" << std::hex << tc.instruction << ", PC: 0x" << tc.pc_val << std::dec << std::endl;
 
-        reset_dut(top, tfp);
+        reset_dut(top, trace);
 
         // Initialize registers based on the test case
         for(const auto& reg_pair : tc.initial_regs) {
-            set_reg(top, tfp, reg_pair.first, reg_pair.second);
+            set_reg(top, trace, reg_pair.first, reg_pair.second);
         }
 
         // Set up inputs for the IF/ID register
@@ -257,7 +255,7 @@ int main(int argc, char** argv) {
         //          Register file rs1_data_o/rs2_data_o are NOT yet updated with data for *this* instruction,
         //          as their read addresses (rs1_addr_i, rs2_addr_i) only just got updated.
         //          They would reflect data for addresses present *before* this instruction was latched.
-        tick(top, tfp);
+        tick(top, trace);
         // For debugging:
         // std::cout << "  After Tick 1 (IF/ID latch): " << std::endl;
         // std::cout << "    o_instr_id: 0x" << std::hex << top->o_instr_id << std::dec << std::endl;
@@ -271,7 +269,7 @@ int main(int argc, char** argv) {
         // Posedge: Decode stage's combinational logic (control_unit, immediate_generator)
         //          processes the now-stable rs1_data_o, rs2_data_o, and other inputs.
         //          All outputs of the Decode stage (o_rs1_data_d, o_control_signals, etc.) become stable.
-        tick(top, tfp);
+        tick(top, trace);
         // For debugging:
         // std::cout << "  After Tick 2 (Decode process): " << std::endl;
         // std::cout << "    o_rs1_data_d: 0x" << std::hex << top->o_rs1_data_d << std::dec << std::endl;
@@ -348,7 +346,7 @@ int main(int argc, char** argv) {
     }
 
     std::cout << "\nDecode Stage Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " test cases." << std::endl;
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
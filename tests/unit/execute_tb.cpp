@@ -1,7 +1,7 @@
 // tests/unit/execute_tb.cpp
 #include "Vexecute_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -66,9 +66,10 @@ const uint8_t FWD_EX_MEM_EX_TB = 0b10; // From EX/MEM (RdM) -> EX
 
 vluint64_t sim_time_execute_tb = 0;
 
-void eval_execute(Vexecute_tb* dut, VerilatedVcdC* tfp) {
+void eval_execute(Vexecute_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) tfp->dump(sim_time_execute_tb);
+    trace.on_cycle(sim_time_execute_tb, 0);
+    trace.dump(sim_time_execute_tb);
 }
 
 // Test case structure
@@ -92,10 +93,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vexecute_tb* top = new Vexecute_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_execute.vcd");
+    TbTrace trace(top, "tb_execute", "execute_tb");
 
     std::cout << "Starting Execute Stage Testbench (Corrected)" << std::endl;
     top->rst_n = 1; // For combinational DUT, rst_n is not strictly for logic, but good for sim init
@@ -210,7 +208,7 @@ int main(int argc, char** argv) {
         top->i_forward_a_e = tc.forward_a_e_i;
         top->i_forward_b_e = tc.forward_b_e_i;
 
-        eval_execute(top, tfp); // Evaluate combinational logic
+        eval_execute(top, trace); // Evaluate combinational logic
         sim_time_execute_tb++;    // Increment VCD time for each test case
 
         bool current_pass = true;
@@ -236,7 +234,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nExecute Stage Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -13,11 +13,15 @@ module execute_tb (
     input  logic [`DATA_WIDTH-1:0]     i_forward_data_wb,
     input  logic [1:0]                 i_forward_a_e,
     input  logic [1:0]                 i_forward_b_e,
+    input  logic [`DATA_WIDTH-1:0]     i_csr_rdata,
 
     // Outputs from Execute stage
     output ex_mem_data_t           o_ex_mem_data,      // Output structure to EX/MEM
     output logic                   o_pc_src,           // PCSrcE: 1 if branch/jump taken
-    output logic [`DATA_WIDTH-1:0] o_pc_target_addr    // PCTargetE: target address
+    output logic [`DATA_WIDTH-1:0] o_pc_target_addr,   // PCTargetE: target address
+    output logic [`CSR_ADDR_WIDTH-1:0] o_csr_addr,
+    output logic                   o_csr_write,
+    output logic [`DATA_WIDTH-1:0] o_csr_wdata
 );
 
     execute u_execute_dut ( // Changed instance name for clarity
@@ -28,6 +32,11 @@ module execute_tb (
         .forward_a_e_i      (i_forward_a_e),
         .forward_b_e_i      (i_forward_b_e),
 
+        .csr_rdata_i        (i_csr_rdata),
+        .csr_addr_o         (o_csr_addr),
+        .csr_write_o        (o_csr_write),
+        .csr_wdata_o        (o_csr_wdata),
+
         .ex_mem_data_o      (o_ex_mem_data),      // Receive the whole structure
         .pc_src_o           (o_pc_src),
         .pc_target_addr_o   (o_pc_target_addr)
@@ -1,6 +1,6 @@
 #include "Vfetch_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -12,19 +12,20 @@ const uint32_t NOP_INSTRUCTION = 0x00000013;
 
 vluint64_t sim_time = 0;
 
-void tick(Vfetch_tb* dut, VerilatedVcdC* tfp) {
+void tick(Vfetch_tb* dut, TbTrace& trace) {
     dut->clk = 0;
     dut->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.on_cycle(sim_time / 2, 0);
+    trace.dump(sim_time);
     sim_time++;
 
     dut->clk = 1;
     dut->eval();
-    if (tfp) tfp->dump(sim_time);
+    trace.dump(sim_time);
     sim_time++;
 }
 
-void reset_dut(Vfetch_tb* dut, VerilatedVcdC* tfp) {
+void reset_dut(Vfetch_tb* dut, TbTrace& trace) {
     dut->rst_n = 0;
     // Initialize inputs to known safe values during reset
     dut->i_stall_f = 0;
@@ -33,10 +34,10 @@ void reset_dut(Vfetch_tb* dut, VerilatedVcdC* tfp) {
     dut->i_stall_d = 0;
     dut->i_flush_d = 0;
     for (int i = 0; i < 5; ++i) { // Hold reset for a few cycles
-        tick(dut, tfp);
+        tick(dut, trace);
     }
     dut->rst_n = 1;
-    tick(dut, tfp); // One tick out of reset
+    tick(dut, trace); // One tick out of reset
     std::cout << "DUT Reset" << std::endl;
 }
 
@@ -45,14 +46,11 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vfetch_tb* top = new Vfetch_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_fetch.vcd");
+    TbTrace trace(top, "tb_fetch", "fetch_tb");
 
     std::cout << "Starting Fetch Stage Testbench" << std::endl;
 
-    reset_dut(top, tfp);
+    reset_dut(top, trace);
 
     // Test Case 1: Basic sequential fetch
     std::cout << "Test Case 1: Sequential Fetch" << std::endl;
@@ -63,7 +61,7 @@ int main(int argc, char** argv) {
     top->i_flush_d = 0;
 
     // Cycle 1: PC=0, Fetch instr @0. IF/ID gets this after this cycle.
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -71,14 +69,14 @@ int main(int argc, char** argv) {
     // After PC=0 is fetched, on the NEXT rising edge, IF/ID will latch PC=0 and Instr @0.
 
     // Cycle 2: PC=0 latched into IF/ID. Fetch stage moves to PC=4.
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
     // Expected: PC_F=4. IF/ID PC=0, Instr = mem[0] (0x00100093)
 
     // Cycle 3: PC=4 latched into IF/ID. Fetch stage moves to PC=8.
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -92,13 +90,13 @@ int main(int argc, char** argv) {
     // PC_F was 8. It should remain 8. Instr_F will be from PC=8.
     // IF/ID will latch current Instr_F and PC_F+4.
     // Previous IF/ID instr was mem[1] (from PC=4).
-    tick(top, tfp); // PC=8 (stalled), instr_f = mem[8/4=2]. IF/ID gets (instr @ PC=8, PC=8+4)
+    tick(top, trace); // PC=8 (stalled), instr_f = mem[8/4=2]. IF/ID gets (instr @ PC=8, PC=8+4)
     std::cout << "  StallF=1. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
     // Expected: PC_F=8. IF/ID PC=8, Instr = mem[2] (0x00308193)
 
-    tick(top, tfp); // PC=8 (still stalled), instr_f = mem[8/4=2]. IF/ID re-latches same values.
+    tick(top, trace); // PC=8 (still stalled), instr_f = mem[8/4=2]. IF/ID re-latches same values.
     std::cout << "  StallF=1. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -112,7 +110,7 @@ int main(int argc, char** argv) {
     // PC_F was 8. Now stall_f=0, so PC will advance to 12. instr_f = mem[12/4=3].
     // IF/ID was (PC=8, instr=mem[2]). Now stall_d=1, so IF/ID holds its value.
     top->i_stall_d = 1;
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  StallD=1. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -120,7 +118,7 @@ int main(int argc, char** argv) {
 
     // PC_F advances to 16. instr_f = mem[16/4=4].
     // IF/ID still holds (PC=8, instr=mem[2]).
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  StallD=1. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -134,14 +132,14 @@ int main(int argc, char** argv) {
     // PC_F was 16. Now stall_d=0, PC advances to 20. instr_f = mem[20/4=5].
     // IF/ID was (PC=8, instr=mem[2]). Now flush_d=1. IF/ID should be NOP.
     top->i_flush_d = 1;
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  FlushD=1. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
     // Expected: PC_F=20 (0x14). IF/ID PC=0, Instr = NOP (0x13)
 
     top->i_flush_d = 0; // Release flush_d
-    tick(top, tfp); // PC_F advances to 24. IF/ID gets (instr @ PC=20, PC=20+4)
+    tick(top, trace); // PC_F advances to 24. IF/ID gets (instr @ PC=20, PC=20+4)
     std::cout << "  FlushD=0. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -153,14 +151,14 @@ int main(int argc, char** argv) {
     top->i_pc_target_e = 0x100; // Jump to address 0x100
     // PC_F was 24. Next PC should be 0x100. instr_f will be mem[0x100/4].
     // IF/ID was (PC=20, instr=mem[5]). IF/ID gets (instr @ PC=0x100, PC=0x100+4)
-    tick(top, tfp);
+    tick(top, trace);
     std::cout << "  Branch. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
     // Expected: PC_F=0x100. IF/ID PC=0x100, Instr = mem[0x100/4] (which is NOP by default init)
 
     top->i_pc_src_e = 0; // Next cycle, no branch
-    tick(top, tfp); // PC_F advances to 0x104. IF/ID gets (instr @ PC=0x100, PC=0x100+4)
+    tick(top, trace); // PC_F advances to 0x104. IF/ID gets (instr @ PC=0x100, PC=0x100+4)
     std::cout << "  After Branch. PC_F: 0x" << std::hex << top->o_current_pc_f
               << " -> IF/ID PC: 0x" << top->o_pc_id
               << " Instr: 0x" << top->o_instr_id << std::dec << std::endl;
@@ -169,7 +167,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nFetch Stage Testbench Finished." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return 0;
 }
\ No newline at end of file
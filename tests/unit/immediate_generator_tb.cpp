@@ -1,7 +1,7 @@
 // tests/unit/immediate_generator_tb.cpp
 #include "Vimmediate_generator_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h" // Optional for VCD
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -22,11 +22,10 @@ enum ImmediateTypeCpp {
 
 vluint64_t sim_time_immgen = 0;
 
-void eval_immgen(Vimmediate_generator_tb* dut, VerilatedVcdC* tfp) {
+void eval_immgen(Vimmediate_generator_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) {
-        tfp->dump(sim_time_immgen);
-    }
+    trace.on_cycle(sim_time_immgen, 0);
+    trace.dump(sim_time_immgen);
     // sim_time_immgen++; // For combinational, time can be advanced per test case
 }
 
@@ -96,10 +95,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vimmediate_generator_tb* top = new Vimmediate_generator_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_immediate_generator.vcd");
+    TbTrace trace(top, "tb_immediate_generator", "immediate_generator_tb");
 
     std::cout << "Starting Immediate Generator Testbench" << std::endl;
 
@@ -157,7 +153,7 @@ int main(int argc, char** argv) {
         top->i_instr = tc.instruction_bits;
         top->i_imm_type_sel = static_cast<uint8_t>(tc.imm_type); // Cast enum to uint8_t for Verilator port
 
-        eval_immgen(top, tfp);
+        eval_immgen(top, trace);
         sim_time_immgen++; // Increment time for VCD for each test case
 
         bool current_pass = true;
@@ -178,7 +174,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nImmediate Generator Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
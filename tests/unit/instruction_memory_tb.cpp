@@ -1,7 +1,7 @@
 // tests/unit/instruction_memory_tb.cpp
 #include "Vinstruction_memory_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h" // Optional: if we want VCD for this simple test
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -10,21 +10,21 @@
 #include <string>
 
 // Ожидаемые значения из instruction_memory.sv initial block
-const uint32_t DEFAULT_NOP_INSTR = 0x00000013;
+// Verilator starts unwritten words at zero, and the ROM fetches words as they are
+const uint32_t UNWRITTEN_WORD = 0x00000000;
 const uint32_t INSTR_MEM_0 = 0x00100093; // addi x1, x0, 1
 const uint32_t INSTR_MEM_1 = 0x00200113; // addi x2, x0, 2
 const uint32_t INSTR_MEM_2 = 0x00308193; // addi x3, x1, 3
 const uint32_t INSTR_MEM_3 = 0x00110213; // addi x4, x2, 1
 
-const int ROM_SIZE_INSTR = 256; // Должно соответствовать ROM_SIZE в instruction_memory.sv
+const int ROM_SIZE_INSTR = 256; // Должно соответствовать ROM_SIZE в instruction_memory_tb.sv
 
 vluint64_t sim_time_imem = 0; // Отдельное время для этого теста
 
-void eval_imem(Vinstruction_memory_tb* dut, VerilatedVcdC* tfp) {
+void eval_imem(Vinstruction_memory_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) {
-        tfp->dump(sim_time_imem);
-    }
+    trace.on_cycle(sim_time_imem, 0);
+    trace.dump(sim_time_imem);
     // sim_time_imem++; // Для комбинационного теста время можно не инкрементировать на каждом eval
 }
 
@@ -39,10 +39,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vinstruction_memory_tb* top = new Vinstruction_memory_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_instruction_memory.vcd");
+    TbTrace trace(top, "tb_instruction_memory", "instruction_memory_tb");
 
     std::cout << "Starting Instruction Memory Testbench" << std::endl;
 
@@ -51,12 +48,12 @@ int main(int argc, char** argv) {
         {"Read Addr 4 (Instr 1)",       0x04, INSTR_MEM_1, true},
         {"Read Addr 8 (Instr 2)",       0x08, INSTR_MEM_2, true},
         {"Read Addr 12 (Instr 3)",      0x0C, INSTR_MEM_3, true},
-        {"Read Addr 16 (Uninit, NOP)",  0x10, DEFAULT_NOP_INSTR, true},
-        {"Read Addr last valid (NOP)",  (uint64_t)((ROM_SIZE_INSTR - 1) * 4), DEFAULT_NOP_INSTR, true},
+        {"Read Addr 16 (Uninit)",       0x10, UNWRITTEN_WORD, true},
+        {"Read Addr last valid (Uninit)", (uint64_t)((ROM_SIZE_INSTR - 1) * 4), UNWRITTEN_WORD, true},
         // Тесты для адресов немного за пределами инициализированных, но внутри ROM_SIZE
-        {"Read Addr 20 (Uninit, NOP)",  0x14, DEFAULT_NOP_INSTR, true},
-        {"Read Addr 0x3F8 (last in ROM)",0x3F8, DEFAULT_NOP_INSTR, true}, // (255*4)
-        {"Read Addr 0x3FC (last in ROM)",0x3FC, DEFAULT_NOP_INSTR, true}, // (255*4) -> (256-1)*4
+        {"Read Addr 20 (Uninit)",       0x14, UNWRITTEN_WORD, true},
+        {"Read Addr 0x3F8 (last in ROM)",0x3F8, UNWRITTEN_WORD, true}, // (255*4)
+        {"Read Addr 0x3FC (last in ROM)",0x3FC, UNWRITTEN_WORD, true}, // (255*4) -> (256-1)*4
 
         // Тесты на граничные условия (за пределами ROM)
         // Поведение здесь зависит от Verilator/SystemVerilog для out-of-bounds array access.
@@ -77,7 +74,7 @@ int main(int argc, char** argv) {
         std::cout << "  Address: 0x" << std::hex << tc.address << std::dec << std::endl;
 
         top->i_address = tc.address;
-        eval_imem(top, tfp);
+        eval_imem(top, trace);
         sim_time_imem++; // Инкрементируем время для каждого тестового случая в VCD
 
         bool current_pass = true;
@@ -114,7 +111,7 @@ int main(int argc, char** argv) {
     std::cout << "\nInstruction Memory Testbench Finished." << std::endl;
     std::cout << "Passed " << passed_count << "/" << total_defined_tests << " defined behavior tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     // Успех, если все тесты с ожидаемым поведением прошли
     return (passed_count == total_defined_tests) ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -11,7 +11,10 @@ module instruction_memory_tb (
     output logic [`INSTR_WIDTH-1:0]    o_instruction
 );
 
-    instruction_memory u_instr_mem (
+    // Small ROM: matches ROM_SIZE_INSTR in instruction_memory_tb.cpp
+    instruction_memory #(
+        .ROM_SIZE(256)
+    ) u_instr_mem (
         .address     (i_address),
         .instruction (o_instruction)
     );
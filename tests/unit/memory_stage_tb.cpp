@@ -1,7 +1,7 @@
 // tests/unit/memory_stage_tb.cpp
 #include "Vmemory_stage_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -31,19 +31,20 @@ const uint8_t RESULT_SRC_PC4_MSTB = 0b10;
 
 vluint64_t sim_time_mem_stage = 0;
 
-void tick_mem_stage(Vmemory_stage_tb* dut, VerilatedVcdC* tfp) {
+void tick_mem_stage(Vmemory_stage_tb* dut, TbTrace& trace) {
     dut->clk = 0;
     dut->eval();
-    if (tfp) tfp->dump(sim_time_mem_stage);
+    trace.on_cycle(sim_time_mem_stage / 2, 0);
+    trace.dump(sim_time_mem_stage);
     sim_time_mem_stage++;
 
     dut->clk = 1;
     dut->eval(); // Write to data_memory happens on posedge
-    if (tfp) tfp->dump(sim_time_mem_stage);
+    trace.dump(sim_time_mem_stage);
     sim_time_mem_stage++;
 }
 
-void reset_mem_stage(Vmemory_stage_tb* dut, VerilatedVcdC* tfp) {
+void reset_mem_stage(Vmemory_stage_tb* dut, TbTrace& trace) {
     dut->rst_n = 0;
     dut->i_reg_write_m = 0;
     dut->i_result_src_m = 0;
@@ -54,10 +55,10 @@ void reset_mem_stage(Vmemory_stage_tb* dut, VerilatedVcdC* tfp) {
     dut->i_rd_addr_m = 0;
     dut->i_pc_plus_4_m = 0;
     for (int i = 0; i < 3; ++i) { // Hold reset for a few cycles
-        tick_mem_stage(dut, tfp);
+        tick_mem_stage(dut, trace);
     }
     dut->rst_n = 1;
-    tick_mem_stage(dut, tfp); // One tick after reset
+    tick_mem_stage(dut, trace); // One tick after reset
     std::cout << "DUT Memory Stage Reset" << std::endl;
 }
 
@@ -87,10 +88,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vmemory_stage_tb* top = new Vmemory_stage_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_memory_stage.vcd");
+    TbTrace trace(top, "tb_memory_stage", "memory_stage_tb");
 
     std::cout << "Starting Memory Stage Testbench" << std::endl;
 
@@ -145,7 +143,7 @@ int main(int argc, char** argv) {
 
     int passed_count = 0;
     // Reset memory once at the beginning for all test sequences
-    reset_mem_stage(top, tfp);
+    reset_mem_stage(top, trace);
 
     for (const auto& tc : test_cases) {
         std::cout << "\nRunning Test: " << tc.name << std::endl;
@@ -164,7 +162,7 @@ int main(int argc, char** argv) {
         // For reads, data_memory is combinational, so output is available after eval.
         // memory_stage itself is combinational.
         // tick_mem_stage will handle one full clock cycle.
-        tick_mem_stage(top, tfp);
+        tick_mem_stage(top, trace);
 
         // Perform checks
         bool current_pass = true;
@@ -187,7 +185,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nMemory Stage Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
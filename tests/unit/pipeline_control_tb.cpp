@@ -1,7 +1,7 @@
 // tests/unit/pipeline_control_tb.cpp
 #include "Vpipeline_control_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 #include "common_pipeline_types_tb.h" // Вспомогательный файл с C++ структурами
 
 #include <iostream>
@@ -20,11 +20,10 @@ const uint8_t FORWARD_EX_MEM_CPP = 0b10; // From EX/MEM (RdM) -> EX
 
 vluint64_t sim_time_pc_tb = 0; // Renamed to avoid conflict
 
-void eval_pipeline_control(Vpipeline_control_tb* dut, VerilatedVcdC* tfp) {
+void eval_pipeline_control(Vpipeline_control_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) {
-        tfp->dump(sim_time_pc_tb);
-    }
+    trace.on_cycle(sim_time_pc_tb, 0);
+    trace.dump(sim_time_pc_tb);
     // sim_time_pc_tb++; // For combinational, advance time per test case
 }
 
@@ -75,10 +74,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vpipeline_control_tb* top = new Vpipeline_control_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_pipeline_control.vcd");
+    TbTrace trace(top, "tb_pipeline_control", "pipeline_control_tb");
 
     std::cout << "Starting Pipeline Control (Hazard Unit) Testbench (Revised)" << std::endl;
 
@@ -228,7 +224,7 @@ int main(int argc, char** argv) {
 
         top->i_pc_src_from_ex = tc.pc_src_from_ex;
 
-        eval_pipeline_control(top, tfp);
+        eval_pipeline_control(top, trace);
         sim_time_pc_tb++;
 
         bool current_pass = true;
@@ -250,7 +246,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nPipeline Control Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 // tests/unit/register_file_tb.cpp
 #include "Vregister_file_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -13,21 +13,22 @@ vluint64_t sim_time_regfile = 0;
 
 // Определяем один полный тактовый цикл: negedge -> posedge
 // Чтение происходит на negedge, запись на posedge.
-void step_clk_regfile(Vregister_file_tb* dut, VerilatedVcdC* tfp) {
+void step_clk_regfile(Vregister_file_tb* dut, TbTrace& trace) {
     // ---- ФАЗА 1: CLK LOW (negedge) ----
     dut->clk = 0;
     dut->eval(); // Обновляются выходы RF (rs1_data_o, rs2_data_o) на основе адресов, поданных до этого
-    if (tfp) tfp->dump(sim_time_regfile);
+    trace.on_cycle(sim_time_regfile / 2, 0);
+    trace.dump(sim_time_regfile);
     sim_time_regfile++;
 
     // ---- ФАЗА 2: CLK HIGH (posedge) ----
     dut->clk = 1;
     dut->eval(); // Происходит запись в RF, если rd_write_en_wb_i активен
-    if (tfp) tfp->dump(sim_time_regfile);
+    trace.dump(sim_time_regfile);
     sim_time_regfile++;
 }
 
-void reset_regfile(Vregister_file_tb* dut, VerilatedVcdC* tfp) {
+void reset_regfile(Vregister_file_tb* dut, TbTrace& trace) {
     dut->rst_n = 0;
     // Установить входы в безопасное состояние во время сброса
     dut->i_rs1_addr = 0;
@@ -38,11 +39,11 @@ void reset_regfile(Vregister_file_tb* dut, VerilatedVcdC* tfp) {
 
     // Пропустить несколько тактов с активным сбросом
     for (int i = 0; i < 3; ++i) {
-        step_clk_regfile(dut, tfp);
+        step_clk_regfile(dut, trace);
     }
     dut->rst_n = 1;
     dut->eval(); // Применить rst_n = 1
-    step_clk_regfile(dut, tfp); // Один такт после снятия сброса для стабилизации
+    step_clk_regfile(dut, trace); // Один такт после снятия сброса для стабилизации
     std::cout << "DUT Register File Reset" << std::endl;
 }
 
@@ -65,10 +66,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vregister_file_tb* top = new Vregister_file_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_register_file.vcd");
+    TbTrace trace(top, "tb_register_file", "register_file_tb");
 
     std::cout << "Starting Register File Testbench" << std::endl;
 
@@ -130,7 +128,7 @@ int main(int argc, char** argv) {
     int passed_count = 0;
     for (const auto& tc : test_cases) {
         std::cout << "\nRunning Test: " << tc.name << std::endl;
-        reset_regfile(top, tfp); // Сбрасываем RF перед каждым набором операций
+        reset_regfile(top, trace); // Сбрасываем RF перед каждым набором операций
 
         // Выполняем предварительные записи
         for (const auto& write_op : tc.writes_before_read) {
@@ -140,7 +138,7 @@ int main(int argc, char** argv) {
             std::cout << "  Setup Write: Addr=" << (int)top->i_rd_addr_wb
                       << ", Data=0x" << std::hex << top->i_rd_data_wb
                       << ", WE=" << (int)top->i_rd_write_en_wb << std::dec << std::endl;
-            step_clk_regfile(top, tfp); // Запись происходит на posedge этого такта
+            step_clk_regfile(top, trace); // Запись происходит на posedge этого такта
         }
         // Сбрасываем сигналы записи после всех операций записи, чтобы они не влияли на чтение
         top->i_rd_write_en_wb = 0;
@@ -156,7 +154,7 @@ int main(int argc, char** argv) {
         // Данные чтения будут доступны на выходах o_rs1_data, o_rs2_data
         // ПОСЛЕ negedge следующего тактового импульса (или текущего, если адреса уже были установлены).
         // Сделаем один полный такт, чтобы чтение по negedge произошло.
-        step_clk_regfile(top, tfp);
+        step_clk_regfile(top, trace);
         // После этого step_clk_regfile, на выходах o_rs1_data и o_rs2_data должны быть актуальные значения
 
         bool current_pass = true;
@@ -184,10 +182,10 @@ int main(int argc, char** argv) {
     }
     //  // Тест на чтение во время записи (read-during-write)
     // std::cout << "\nRunning Test: Read-during-write x1" << std::endl;
-    // reset_regfile(top, tfp);
+    // reset_regfile(top, trace);
     // // 1. Записать начальное значение в x1
     // top->i_rd_addr_wb = 1; top->i_rd_data_wb = 0x1111; top->i_rd_write_en_wb = 1;
-    // step_clk_regfile(top, tfp); // x1 = 0x1111
+    // step_clk_regfile(top, trace); // x1 = 0x1111
     // top->i_rd_write_en_wb = 0; // Снять WE
 
     // // 2. Настроить чтение x1 и одновременно запись нового значения в x1
@@ -200,22 +198,22 @@ int main(int argc, char** argv) {
     // // 3. Первый такт после установки:
     // // clk=0 (negedge): rs1_data_o читает значение *до* записи 0x2222. Должно быть 0x1111.
     // // clk=1 (posedge): 0x2222 записывается в regs[1].
-    // top->clk = 0; top->eval(); if(tfp) tfp->dump(sim_time_regfile); sim_time_regfile++;
+    // top->clk = 0; top->eval(); trace.dump(sim_time_regfile); sim_time_regfile++;
     // bool pass_rdw1 = (top->o_rs1_data == 0x1111);
     // std::cout << "  Read-during-write (cycle 1 negedge): rs1_addr=1, read_data=0x" << std::hex << top->o_rs1_data << ". Expected 0x1111." << std::dec << std::endl;
 
-    // top->clk = 1; top->eval(); if(tfp) tfp->dump(sim_time_regfile); sim_time_regfile++;
+    // top->clk = 1; top->eval(); trace.dump(sim_time_regfile); sim_time_regfile++;
     // // Запись 0x2222 произошла
 
     // top->i_rd_write_en_wb = 0; // Снять WE для следующего чтения
 
     // // 4. Второй такт:
     // // clk=0 (negedge): rs1_data_o читает новое значение 0x2222.
-    // top->clk = 0; top->eval(); if(tfp) tfp->dump(sim_time_regfile); sim_time_regfile++;
+    // top->clk = 0; top->eval(); trace.dump(sim_time_regfile); sim_time_regfile++;
     // bool pass_rdw2 = (top->o_rs1_data == 0x2222);
     // std::cout << "  Read-during-write (cycle 2 negedge): rs1_addr=1, read_data=0x" << std::hex << top->o_rs1_data << ". Expected 0x2222." << std::dec << std::endl;
 
-    // top->clk = 1; top->eval(); if(tfp) tfp->dump(sim_time_regfile); sim_time_regfile++;
+    // top->clk = 1; top->eval(); trace.dump(sim_time_regfile); sim_time_regfile++;
 
 
     // if (pass_rdw1 && pass_rdw2) {
@@ -230,7 +228,7 @@ int main(int argc, char** argv) {
 
     std::cout << "\nRegister File Testbench Finished. Passed " << passed_count << "/" << test_cases.size() << " tests." << std::endl;
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     return (passed_count == test_cases.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
\ No newline at end of file
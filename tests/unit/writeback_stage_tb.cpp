@@ -1,7 +1,7 @@
 // tests/unit/writeback_stage_tb.cpp
 #include "Vwriteback_stage_tb.h"
 #include "verilated.h"
-#include "verilated_vcd_c.h"
+#include "tb_trace.h"
 
 #include <iostream>
 #include <iomanip>
@@ -12,11 +12,10 @@
 
 vluint64_t sim_time_wb = 0;
 
-void eval_wb(Vwriteback_stage_tb* dut, VerilatedVcdC* tfp) {
+void eval_wb(Vwriteback_stage_tb* dut, TbTrace& trace) {
     dut->eval();
-    if (tfp) {
-        tfp->dump(sim_time_wb);
-    }
+    trace.on_cycle(sim_time_wb, 0);
+    trace.dump(sim_time_wb);
 }
 
 struct WbTestCase {
@@ -33,10 +32,7 @@ int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
     Vwriteback_stage_tb* top = new Vwriteback_stage_tb;
 
-    Verilated::traceEverOn(true);
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    top->trace(tfp, 99);
-    tfp->open("tb_writeback_stage.vcd");
+    TbTrace trace(top, "tb_writeback_stage", "writeback_stage_tb");
 
     std::cout << "Starting Writeback Stage Testbench (Corrected)" << std::endl;
 
@@ -83,7 +79,7 @@ int main(int argc, char** argv) {
         top->i_alu_result_wb = tc.alu_result_in;
         top->i_pc_plus_4_wb = tc.pc_plus_4_in;
 
-        eval_wb(top, tfp);
+        eval_wb(top, trace);
         sim_time_wb++;
 
         bool current_pass = true;
@@ -140,7 +136,7 @@ int main(int argc, char** argv) {
     }
 
 
-    if (tfp) tfp->close();
+    trace.close();
     delete top;
     // Exit status based on defined behavior tests only
     return (total_defined_tests == 0 || passed_count == total_defined_tests) ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -0,0 +1,58 @@
+// Sums pipeline event reports (tests/common/pipeline_events.h) from many runs
+// into one and lists the hazard outcomes that none of them exercised.
+//
+//   event_report_merge [-o FILE] <report>...
+//     -o FILE   write the merged report here (default: stdout)
+//
+// Exit status: 0 success, 2 usage or I/O error.
+
+#include "pipeline_events.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using pipeline_events::Counters;
+
+int main(int argc, char** argv) {
+    std::string out_file;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Usage: " << argv[0] << " [-o FILE] <report>..." << std::endl;
+            return 2;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-o FILE] <report>..." << std::endl;
+        return 2;
+    }
+
+    Counters merged;
+    merged.clear();
+    for (const std::string& input : inputs) {
+        if (!merged.read(input)) {
+            return 2;
+        }
+    }
+
+    if (out_file.empty()) {
+        merged.write(std::cout);
+    } else if (!merged.write(out_file)) {
+        return 2;
+    }
+
+    std::ostream& log = out_file.empty() ? std::cerr : std::cout;
+    log << merged.summary() << " over " << merged.runs() << " runs" << std::endl;
+    for (unsigned e = pipeline_events::FORWARD_A_NONE; e < pipeline_events::NUM_EVENTS; ++e) {
+        if (merged.count(static_cast<pipeline_events::Event>(e)) == 0) {
+            log << "Not exercised: " << pipeline_events::EVENT_NAMES[e] << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+// Compares two binary retirement traces (tests/common/retire_trace.h) and
+// reports the first divergence with surrounding context. Both files are
+// mmapped, so multi-GB traces are compared without loading them.
+//
+//   retire_trace_diff [options] <trace_a> <trace_b>
+//   retire_trace_diff --dump <trace>
+//
+// Only fields present in both traces are compared. When either trace lacks
+// PCs (e.g. the ISS plugin, which only sees register writes), both sides are
+// reduced to their register-writing records first. Traces of different
+// length diverge where the shorter one ends, unless --allow-prefix accepts
+// one being a prefix of the other (e.g. a run cut short by +MAX_CYCLES).
+//
+// Exit status: 0 match, 1 divergence, 2 usage or I/O error.
+
+#include "retire_trace.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using retire_trace::MappedTrace;
+using retire_trace::Record;
+
+namespace {
+
+struct Options {
+    uint64_t context = 3;
+    bool compare_cycles = false;
+    bool allow_prefix = false;
+    std::string dump_file;
+    std::string file_a;
+    std::string file_b;
+};
+
+void print_usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " [--context N] [--compare-cycles] [--allow-prefix] <trace_a> <trace_b>\n"
+              << "       " << argv0 << " --dump <trace>" << std::endl;
+}
+
+// Walks a trace, optionally skipping records that do not write a register.
+class Cursor {
+public:
+    Cursor(const MappedTrace& trace, bool rd_only) : trace_(trace), rd_only_(rd_only) { index_ = skip_forward(0); }
+
+    bool done() const { return index_ >= trace_.size(); }
+    uint64_t index() const { return index_; }
+    const Record& record() const { return trace_[index_]; }
+    void advance() { index_ = skip_forward(index_ + 1); }
+
+    // Up to n selected record indices before `from`, oldest first.
+    std::vector<uint64_t> before(uint64_t from, uint64_t n) const {
+        std::vector<uint64_t> out;
+        for (uint64_t i = from; i > 0 && out.size() < n; --i) {
+            if (selected(i - 1)) out.insert(out.begin(), i - 1);
+        }
+        return out;
+    }
+
+    // Up to n selected record indices starting at `from`.
+    std::vector<uint64_t> after(uint64_t from, uint64_t n) const {
+        std::vector<uint64_t> out;
+        for (uint64_t i = skip_forward(from); i < trace_.size() && out.size() < n; i = skip_forward(i + 1)) {
+            out.push_back(i);
+        }
+        return out;
+    }
+
+private:
+    bool selected(uint64_t i) const { return !rd_only_ || (trace_[i].flags & retire_trace::FLAG_RD_WRITE); }
+
+    uint64_t skip_forward(uint64_t i) const {
+        while (i < trace_.size() && !selected(i)) ++i;
+        return i;
+    }
+
+    const MappedTrace& trace_;
+    bool rd_only_;
+    uint64_t index_ = 0;
+};
+
+std::string format_record(const Record& r, uint32_t fields) {
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0');
+    if (fields & retire_trace::FIELD_CYCLE) ss << "cycle=" << std::dec << r.cycle << std::hex << " ";
+    if (fields & retire_trace::FIELD_PC)    ss << "pc=0x" << std::setw(16) << r.pc << " ";
+    if (fields & retire_trace::FIELD_INSTR) ss << "instr=0x" << std::setw(8) << r.instr << " ";
+    if ((fields & retire_trace::FIELD_RD) && (r.flags & retire_trace::FLAG_RD_WRITE)) {
+        ss << "x" << std::dec << static_cast<int>(r.rd) << std::hex << "=0x" << std::setw(16) << r.rd_value << " ";
+    }
+    if ((fields & retire_trace::FIELD_MEM) && (r.flags & retire_trace::FLAG_MEM_WRITE)) {
+        ss << "mem[0x" << std::setw(16) << r.mem_addr << "]=0x" << std::setw(16) << r.mem_wdata << " ";
+    }
+    std::string s = ss.str();
+    if (!s.empty()) s.pop_back();
+    return s;
+}
+
+// Names of the differing fields, empty when the records match.
+std::string diff_fields(const Record& a, const Record& b, uint32_t fields) {
+    std::string out;
+    auto add = [&out](const char* name) { out += out.empty() ? name : std::string(", ") + name; };
+    if ((fields & retire_trace::FIELD_CYCLE) && a.cycle != b.cycle) add("cycle");
+    if ((fields & retire_trace::FIELD_PC) && a.pc != b.pc) add("pc");
+    if ((fields & retire_trace::FIELD_INSTR) && a.instr != b.instr) add("instr");
+    if (fields & retire_trace::FIELD_RD) {
+        const bool wa = a.flags & retire_trace::FLAG_RD_WRITE;
+        const bool wb = b.flags & retire_trace::FLAG_RD_WRITE;
+        if (wa != wb) add("rd_write");
+        else if (wa && a.rd != b.rd) add("rd");
+        else if (wa && a.rd_value != b.rd_value) add("rd_value");
+    }
+    if (fields & retire_trace::FIELD_MEM) {
+        const bool wa = a.flags & retire_trace::FLAG_MEM_WRITE;
+        const bool wb = b.flags & retire_trace::FLAG_MEM_WRITE;
+        if (wa != wb) add("mem_write");
+        else if (wa && a.mem_addr != b.mem_addr) add("mem_addr");
+        else if (wa && a.mem_wdata != b.mem_wdata) add("mem_wdata");
+    }
+    return out;
+}
+
+void print_side(const char* label, const MappedTrace& trace, const Cursor& cursor, uint64_t at,
+                uint64_t context, uint32_t fields) {
+    std::cout << label << ":" << std::endl;
+    for (uint64_t i : cursor.before(at, context)) {
+        std::cout << "    [" << i << "] " << format_record(trace[i], fields) << std::endl;
+    }
+    const std::vector<uint64_t> rest = cursor.after(at, context + 1);
+    for (size_t k = 0; k < rest.size(); ++k) {
+        std::cout << (k == 0 ? "  > [" : "    [") << rest[k] << "] " << format_record(trace[rest[k]], fields) << std::endl;
+    }
+    if (rest.empty()) {
+        std::cout << "  > <end of trace>" << std::endl;
+    }
+}
+
+int dump_trace(const std::string& path) {
+    MappedTrace trace;
+    if (!trace.open(path)) {
+        return 2;
+    }
+    for (uint64_t i = 0; i < trace.size(); ++i) {
+        std::cout << "[" << i << "] " << format_record(trace[i], trace.fields()) << '\n';
+    }
+    return 0;
+}
+
+bool parse_args(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--context" && i + 1 < argc) {
+            opt.context = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--compare-cycles") {
+            opt.compare_cycles = true;
+        } else if (arg == "--allow-prefix") {
+            opt.allow_prefix = true;
+        } else if (arg == "--dump" && i + 1 < argc) {
+            opt.dump_file = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else if (opt.file_a.empty()) {
+            opt.file_a = arg;
+        } else if (opt.file_b.empty()) {
+            opt.file_b = arg;
+        } else {
+            return false;
+        }
+    }
+    return !opt.dump_file.empty() || !opt.file_b.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (!opt.dump_file.empty()) {
+        return dump_trace(opt.dump_file);
+    }
+
+    MappedTrace a, b;
+    if (!a.open(opt.file_a) || !b.open(opt.file_b)) {
+        return 2;
+    }
+
+    uint32_t fields = a.fields() & b.fields();
+    if (!opt.compare_cycles) {
+        fields &= ~retire_trace::FIELD_CYCLE;
+    }
+    const bool rd_only = !(fields & retire_trace::FIELD_PC);
+    if (rd_only) {
+        fields &= retire_trace::FIELD_RD;
+    }
+    if (fields == 0) {
+        std::cerr << "ERROR: The traces have no fields in common." << std::endl;
+        return 2;
+    }
+
+    Cursor ca(a, rd_only), cb(b, rd_only);
+    uint64_t compared = 0;
+    for (; !ca.done() && !cb.done(); ca.advance(), cb.advance(), ++compared) {
+        const std::string diff = diff_fields(ca.record(), cb.record(), fields);
+        if (!diff.empty()) {
+            std::cout << "DIVERGENCE at compared record " << compared << " (" << diff << ")" << std::endl;
+            print_side(opt.file_a.c_str(), a, ca, ca.index(), opt.context, fields);
+            print_side(opt.file_b.c_str(), b, cb, cb.index(), opt.context, fields);
+            return 1;
+        }
+    }
+
+    if (ca.done() != cb.done()) {
+        const bool a_longer = !ca.done();
+        if (!opt.allow_prefix) {
+            std::cout << "DIVERGENCE at compared record " << compared << " (" << (a_longer ? opt.file_b : opt.file_a)
+                      << " ends here)" << std::endl;
+            print_side(opt.file_a.c_str(), a, ca, ca.index(), opt.context, fields);
+            print_side(opt.file_b.c_str(), b, cb, cb.index(), opt.context, fields);
+            return 1;
+        }
+        std::cout << (a_longer ? opt.file_a : opt.file_b) << " has more records after " << compared
+                  << " matching ones." << std::endl;
+    }
+    std::cout << "MATCH: " << compared << " records" << (rd_only ? " (register writes only)" : "") << std::endl;
+    return 0;
+}